@@ -0,0 +1,124 @@
+// runs a synthetic float loop through qcvm_interpret and reports
+// ns/statement for whichever dispatch strategy this build picked; meson
+// builds it once per USE_GNU_OPCODE_JUMPING / USE_TAIL_CALL_DISPATCH
+// setting. the QC is put together by hand in tests/progs.c, so it goes
+// through the same decoding & fusion as a real progs.
+//
+// usage: bench_dispatch_<strategy> [iterations]
+#include <time.h>
+
+#include "shared/shared.h"
+#include "vm.h"
+#include "tests/progs.h"
+
+// same choice vm_opcodes.c.h makes
+#if USE_TAIL_CALL_DISPATCH && defined(qcvm_musttail)
+#define DISPATCH_NAME "tail call"
+#elif USE_GNU_OPCODE_JUMPING && defined(__GNUC__)
+#define DISPATCH_NAME "threaded goto"
+#else
+#define DISPATCH_NAME "handler call"
+#endif
+
+static const vec_t step = 0.5f, scale = 1.0001f;
+
+// loop(n): arithmetic, a store, an int counter & compare, and a
+// conditional branch back; returns the last value stored
+static size_t build_loop(progs_builder_t *progs)
+{
+	const qcvm_global_t zero = progs_int(progs, 0), one = progs_int(progs, 1);
+	const qcvm_global_t step_global = progs_float(progs, step), scale_global = progs_float(progs, scale);
+
+	progs_function(progs, "loop", 1, 5);
+
+	const qcvm_global_t n = progs_local(progs, 0), i = progs_local(progs, 1), acc = progs_local(progs, 2);
+	const qcvm_global_t tmp = progs_local(progs, 3), out = progs_local(progs, 4), cond = progs_local(progs, 5);
+
+	progs_statement(progs, OP_STORE_F, zero, acc, 0);
+	progs_statement(progs, OP_STORE_F, zero, i, 0);
+	const size_t top = progs_statement(progs, OP_ADD_F, acc, step_global, acc);
+	progs_statement(progs, OP_MUL_F, acc, scale_global, tmp);
+	progs_statement(progs, OP_SUB_F, tmp, acc, tmp);
+	progs_statement(progs, OP_STORE_F, tmp, out, 0);
+	progs_statement(progs, OP_ADD_I, i, one, i);
+	progs_statement(progs, OP_LT_I, i, n, cond);
+	// IF_F is the one that tests the int32 bits
+	const size_t branch = progs_statement(progs, OP_IF_F, cond, 0, 0);
+	progs_statement(progs, OP_RETURN, out, 0, 0);
+	progs_statement(progs, OP_DONE, 0, 0, 0);
+
+	progs->statements[branch].args.b = progs_jump(branch, top);
+	return branch - top + 1;
+}
+
+static double now_ns(void)
+{
+	struct timespec ts;
+	timespec_get(&ts, TIME_UTC);
+	return (double)ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(int argc, char **argv)
+{
+	static progs_builder_t progs;
+	int32_t iterations = 20000000;
+	enum { RUNS = 5 };
+
+	if (argc > 1)
+		iterations = (int32_t)strtol(argv[1], NULL, 10);
+
+	if (iterations < 1)
+	{
+		fprintf(stderr, "iterations must be between 1 and %i\n", INT32_MAX);
+		return EXIT_FAILURE;
+	}
+
+	progs_init(&progs);
+	const size_t loop_length = build_loop(&progs);
+
+	qcvm_t *vm = progs_load(&progs, "bench_dispatch.dat");
+	qcvm_function_t *loop = qcvm_find_function(vm, "loop");
+
+#if ALLOW_JIT
+	// loop would get hot enough to be compiled, and this is about the interpreter
+	vm->jit.enabled = false;
+#endif
+
+	// the initial stores, the loop itself & the return
+	const double statements = (double)iterations * loop_length + 3;
+	volatile vec_t acc = 0, out = 0;
+
+	for (int32_t i = 0; i < iterations; i++)
+	{
+		acc += step;
+		volatile vec_t tmp = acc * scale;
+		out = tmp - acc;
+	}
+
+	printf("%s: %i iterations, %.0f statements per run, best of %i\n", DISPATCH_NAME, iterations, statements, RUNS);
+
+	double best = 0;
+
+	for (int r = 0; r < RUNS; r++)
+	{
+		qcvm_set_global_typed_value(int32_t, vm, GLOBAL_PARM0, iterations);
+
+		const double start = now_ns();
+		qcvm_execute(vm, loop);
+		const double elapsed = now_ns() - start;
+
+		if (!r || elapsed < best)
+			best = elapsed;
+
+		const vec_t result = *qcvm_get_global_typed(vec_t, vm, GLOBAL_RETURN);
+
+		if (result != out)
+		{
+			fprintf(stderr, "result %f doesn't match %f\n", result, out);
+			return EXIT_FAILURE;
+		}
+	}
+
+	printf("%6.3f ns/statement\n", best / statements);
+	return EXIT_SUCCESS;
+}
@@ -22,10 +22,8 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include "vm_debug.h"
 #include "vm_string.h"
 #include "vm_gi.h"
-
-#if ALLOW_DEBUGGING
+#include "vm_aot.h"
 #include "g_thread.h"
-#endif
 
 #include "game.h"
 #include "vm_game.h"
@@ -332,6 +330,26 @@ static void InitGame (void)
 	qvm->profiling.sampling.id = qvm->profiling.sampling.function_id = qvm->profiling.sampling.rate;
 #endif
 
+	// collect dynamic strings once a frame instead of ref counting every copy
+	qvm->dynamic_strings.collect = gi.cvar("qc_string_gc", "0", CVAR_LATCH)->value;
+
+#if ALLOW_PROGS_CACHE
+	// keep what's derived from the progs next to it, so the next load can skip working it out
+	qvm->cache.enabled = gi.cvar("qc_progs_cache", "1", CVAR_LATCH)->value;
+#endif
+
+	// share 32-bit progs with other servers running the same mod, rather than each reading in its own copy.
+	// off by default: pages that were never written to still see the file, so rewriting progs.dat
+	// in place (instead of replacing it) while a server is running corrupts it, or SIGBUSes if it shrinks.
+	qvm->map_progs = gi.cvar("qc_progs_mmap", "0", CVAR_LATCH)->value;
+
+	// build the tables the progs needs on a few threads at once
+	if (gi.cvar("qc_parallel_load", "1", CVAR_LATCH)->value)
+	{
+		qvm->tasks.create = qcvm_cpp_create_task;
+		qvm->tasks.join = qcvm_cpp_join_thread;
+	}
+
 	qcvm_load(qvm, "Quake2C DLL", GetProgsName());
 
 #ifdef KMQUAKE2_ENGINE_MOD
@@ -355,6 +373,19 @@ static void InitGame (void)
 
 	InitFieldWraps();
 
+	qcvm_field_wrap_list_tag_stores(qvm);
+
+#if ALLOW_JIT
+	qvm->jit.enabled = gi.cvar("qc_jit", "1", CVAR_LATCH)->value;
+#endif
+
+#if ALLOW_AOT
+	const cvar_t *qc_aot_library = gi.cvar("qc_aot_library", "", CVAR_LATCH);
+
+	if (*qc_aot_library->string)
+		qcvm_aot_load(qvm, qcvm_temp_format(qvm, "%s%s", qvm->path, qc_aot_library->string));
+#endif
+
 #if ALLOW_DEBUGGING
 	qvm->debug.create_mutex = qcvm_cpp_create_mutex;
 	qvm->debug.free_mutex = qcvm_cpp_free_mutex;
@@ -391,6 +422,10 @@ static void InitGame (void)
 	globals.num_edicts = game.num_clients + 1;
 	qvm->edicts = globals.edicts = (edict_t *)gi.TagMalloc(globals.max_edicts * globals.edict_size, TAG_GAME);
 
+	// mirror client fields into gclient_t once per callback instead of on every store
+	if (gi.cvar("qc_defer_wraps", "0", CVAR_LATCH)->value)
+		qcvm_field_wrap_list_defer(qvm, game.num_clients + 1);
+
 	WipeEntities();
 
 	func = qcvm_get_function(qvm, qce.InitGame);
@@ -433,12 +468,12 @@ void RestoreClientData(void)
 	for (uint32_t i = 0; i < game.num_clients; i++)
 	{
 		edict_t *ent = (edict_t *)qcvm_itoe(qvm, i + 1);
-#if defined(__GNU__) || defined(__clang__)
+#ifdef __GNUC__
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wcast-align"
 #endif
 		edict_t *backup = (edict_t *)((uint8_t *)game.client_load_data + (globals.edict_size * i));
-#if defined(__GNU__) || defined(__clang__)
+#ifdef __GNUC__
 #pragma GCC diagnostic pop
 #endif
 
@@ -490,15 +525,20 @@ static void SpawnEntities(const char *mapname, const char *entities, const char
 	WipeEntities();
 
 	func = qcvm_get_function(qvm, qce.SpawnEntities);
-	qcvm_set_global_str(qvm, GLOBAL_PARM0, mapname, strlen(mapname), true);
-	qcvm_set_global_str(qvm, GLOBAL_PARM1, entities, strlen(entities), true);
-	qcvm_set_global_str(qvm, GLOBAL_PARM2, spawnpoint, strlen(spawnpoint), true);
+	const qcvm_string_t mapname_id = qcvm_set_global_str_borrowed(qvm, GLOBAL_PARM0, mapname, strlen(mapname));
+	const qcvm_string_t entities_id = qcvm_set_global_str_borrowed(qvm, GLOBAL_PARM1, entities, strlen(entities));
+	const qcvm_string_t spawnpoint_id = qcvm_set_global_str_borrowed(qvm, GLOBAL_PARM2, spawnpoint, strlen(spawnpoint));
 	qcvm_execute(qvm, func);
+	qcvm_end_borrow(qvm, mapname_id, GLOBAL_PARM0);
+	qcvm_end_borrow(qvm, entities_id, GLOBAL_PARM1);
+	qcvm_end_borrow(qvm, spawnpoint_id, GLOBAL_PARM2);
 
 	func = qcvm_get_function(qvm, qce.PostSpawnEntities);
 	qcvm_execute(qvm, func);
 
 	RestoreClientData();
+
+	qcvm_field_wrap_list_sync(qvm);
 }
 
 static qboolean ClientConnect(edict_t *e, char *userinfo)
@@ -515,10 +555,17 @@ static qboolean ClientConnect(edict_t *e, char *userinfo)
 
 	const qcvm_ent_t ent = qcvm_entity_to_ent(qvm, e);
 	qcvm_set_global_typed_value(qcvm_ent_t, qvm, GLOBAL_PARM0, ent);
-	qcvm_set_global_str(qvm, GLOBAL_PARM1, userinfo, strlen(userinfo), true);
+	const qcvm_string_t userinfo_id = qcvm_set_global_str_borrowed(qvm, GLOBAL_PARM1, userinfo, strlen(userinfo));
 	qcvm_execute(qvm, game.funcs.ClientConnect);
 
-	Q_strlcpy(userinfo, qcvm_get_string(qvm, *qcvm_get_global_typed(qcvm_string_t, qvm, GLOBAL_PARM1)), MAX_INFO_STRING);
+	// QC can hand back a changed userinfo; end the borrow first, since the new
+	// one may be a slice of the old
+	const qcvm_string_t new_userinfo = *qcvm_get_global_typed(qcvm_string_t, qvm, GLOBAL_PARM1);
+
+	qcvm_end_borrow(qvm, userinfo_id, GLOBAL_PARM1);
+
+	if (new_userinfo != userinfo_id)
+		Q_strlcpy(userinfo, qcvm_get_string(qvm, new_userinfo), MAX_INFO_STRING);
 
 	const qboolean succeed = *qcvm_get_global_typed(qboolean, qvm, GLOBAL_RETURN);
 
@@ -543,6 +590,8 @@ static void ClientBegin(edict_t *e)
 	const qcvm_ent_t ent = qcvm_entity_to_ent(qvm, e);
 	qcvm_set_global_typed_value(qcvm_ent_t, qvm, GLOBAL_PARM0, ent);
 	qcvm_execute(qvm, game.funcs.ClientBegin);
+
+	qcvm_field_wrap_list_sync(qvm);
 }
 
 static void ClientUserinfoChanged(edict_t *e, char *userinfo)
@@ -557,8 +606,9 @@ static void ClientUserinfoChanged(edict_t *e, char *userinfo)
 
 	const qcvm_ent_t ent = qcvm_entity_to_ent(qvm, e);
 	qcvm_set_global_typed_value(qcvm_ent_t, qvm, GLOBAL_PARM0, ent);
-	qcvm_set_global_str(qvm, GLOBAL_PARM1, userinfo, strlen(userinfo), true);
+	const qcvm_string_t userinfo_id = qcvm_set_global_str_borrowed(qvm, GLOBAL_PARM1, userinfo, strlen(userinfo));
 	qcvm_execute(qvm, game.funcs.ClientUserinfoChanged);
+	qcvm_end_borrow(qvm, userinfo_id, GLOBAL_PARM1);
 }
 
 static void ClientDisconnect(edict_t *e)
@@ -617,6 +667,8 @@ static void ClientThink(edict_t *e, usercmd_t *ucmd)
 
 	qcvm_set_global_typed_value(QC_usercmd_t, qvm, GLOBAL_PARM1, cmd);
 	qcvm_execute(qvm, game.funcs.ClientThink);
+
+	qcvm_field_wrap_list_sync(qvm);
 }
 
 static void RunFrame(void)
@@ -630,6 +682,12 @@ static void RunFrame(void)
 #endif
 
 	qcvm_execute(qvm, game.funcs.RunFrame);
+
+	// the engine reads client state to build this frame's snapshots
+	qcvm_field_wrap_list_sync(qvm);
+
+	qcvm_string_list_collect(qvm);
+	qcvm_string_list_end_frame(qvm);
 }
 
 #define OPCODES_ONLY
@@ -675,6 +733,32 @@ static void ServerCommand(void)
 	}
 #endif
 
+	// sv qc_string_stats: dynamic string memory use and last frame's churn
+	if (strcmp(gi.argv(1), "qc_string_stats") == 0)
+	{
+		const qcvm_string_list_t *list = &qvm->dynamic_strings;
+		const qcvm_string_slab_stats_t *stats = &list->slab_stats;
+
+		gi.dprintf("%" PRIuPTR " strings (%" PRIuPTR " free indices)\n", list->strings_size - list->free_indices_size, list->free_indices_size);
+		gi.dprintf("%" PRIuPTR " bytes used, %" PRIuPTR " reserved in %" PRIuPTR " slabs + oversized\n", stats->bytes_used, stats->bytes_reserved, stats->slabs);
+		gi.dprintf("%" PRIuPTR " bytes in free chunks, %" PRIuPTR " lost to rounding\n", stats->bytes_free, stats->bytes_reserved - stats->bytes_used - stats->bytes_free);
+		gi.dprintf("last frame: %" PRIuPTR " allocs, %" PRIuPTR " frees\n", stats->frame_allocs, stats->frame_frees);
+
+		if (list->collect)
+			gi.dprintf("last collection: %" PRIuPTR " slots scanned, %" PRIuPTR " strings freed\n", stats->collect_scanned, stats->collect_freed);
+		return;
+	}
+
+#if ALLOW_AOT
+	// sv qc_aot_generate [file]: write the loaded progs out as C; see vm_aot.c
+	if (strcmp(gi.argv(1), "qc_aot_generate") == 0)
+	{
+		const char *file = gi.argc() > 2 ? gi.argv(2) : "progs_aot.c";
+		qcvm_aot_generate(qvm, qcvm_temp_format(qvm, "%s%s", qvm->path, file));
+		return;
+	}
+#endif
+
 #if ALLOW_DEBUGGING
 	qcvm_check_debugger_commands(qvm);
 #endif
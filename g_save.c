@@ -268,16 +268,11 @@ void ReadGame(const char *filename)
 		fread(def_name, sizeof(char), len, fp);
 		def_name[len] = 0;
 
-		qcvm_definition_hash_t *hashed = qvm->definition_hashes[Q_hash_string(def_name, qvm->definitions_size)];
+		qcvm_definition_t *def = qcvm_find_definition_by_name(qvm, def_name);
 
-		for (; hashed; hashed = hashed->hash_next)
-			if (!strcmp(qcvm_get_string(qvm, hashed->def->name_index), def_name))
-				break;
-
-		if (!hashed)
+		if (!def)
 			qcvm_error(qvm, "Bad definition %s", def_name);
 
-		qcvm_definition_t *def = hashed->def;
 		ReadDefinitionData(qvm, fp, def, qcvm_get_global(qvm, def->global_index));
 	}
 
@@ -301,17 +296,11 @@ void ReadGame(const char *filename)
 		if (!qcvm_find_string(qvm, def_name, &str) || qcvm_string_list_is_ref_counted(qvm, str))
 			qcvm_error(qvm, "Bad string in save file");
 
-		qcvm_definition_hash_t *hashed = qvm->field_hashes[Q_hash_string(def_name, qvm->fields_size)];
-
-		for (; hashed; hashed = hashed->hash_next)
-			if (!strcmp(qcvm_get_string(qvm, hashed->def->name_index), def_name))
-				break;
+		qcvm_definition_t *field = qcvm_find_field(qvm, def_name);
 
-		if (!hashed)
+		if (!field)
 			qcvm_error(qvm, "Bad field %s", def_name);
 		
-		qcvm_definition_t *field = hashed->def;
-		
 		for (uint32_t i = 0; i < game.num_clients; i++)
 			ReadEntityFieldData(qvm, fp, qcvm_itoe(qvm, i + 1), field);
 	}
@@ -320,6 +309,7 @@ void ReadGame(const char *filename)
 	qcvm_execute(qvm, func);
 
 	qcvm_field_wrap_list_check_set(qvm, qcvm_itoe(qvm, 1), (globals.edict_size * game.num_clients) / sizeof(qcvm_global_t));
+	qcvm_field_wrap_list_sync(qvm);
 
 	fclose(fp);
 }
@@ -481,16 +471,11 @@ void ReadLevel(const char *filename)
 		fread(def_name, sizeof(char), len, fp);
 		def_name[len] = 0;
 
-		qcvm_definition_hash_t *hashed = qvm->definition_hashes[Q_hash_string(def_name, qvm->definitions_size)];
+		qcvm_definition_t *def = qcvm_find_definition_by_name(qvm, def_name);
 
-		for (; hashed; hashed = hashed->hash_next)
-			if (!strcmp(qcvm_get_string(qvm, hashed->def->name_index), def_name))
-				break;
-
-		if (!hashed)
+		if (!def)
 			qcvm_error(qvm, "Bad definition %s", def_name);
 
-		qcvm_definition_t *def = hashed->def;
 		ReadDefinitionData(qvm, fp, def, qcvm_get_global(qvm, def->global_index));
 	}
 
@@ -512,16 +497,10 @@ void ReadLevel(const char *filename)
 		if (!qcvm_find_string(qvm, def_name, &str) || qcvm_string_list_is_ref_counted(qvm, str))
 			qcvm_error(qvm, "Bad string in save file");
 
-		qcvm_definition_hash_t *hashed = qvm->field_hashes[Q_hash_string(def_name, qvm->fields_size)];
-
-		for (; hashed; hashed = hashed->hash_next)
-			if (!strcmp(qcvm_get_string(qvm, hashed->def->name_index), def_name))
-				break;
+		qcvm_definition_t *field = qcvm_find_field(qvm, def_name);
 
-		if (!hashed)
+		if (!field)
 			qcvm_error(qvm, "Bad field %s", def_name);
-		
-		qcvm_definition_t *field = hashed->def;
 
 		while (true)
 		{
@@ -559,5 +538,7 @@ void ReadLevel(const char *filename)
 	qcvm_set_global_typed_value(int32_t, qvm, GLOBAL_PARM0, globals.num_edicts);
 	qcvm_execute(qvm, func);
 
+	qcvm_field_wrap_list_sync(qvm);
+
 	fclose(fp);
 }
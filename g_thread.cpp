@@ -6,8 +6,34 @@ extern "C"
 	#include "g_thread.h"
 };
 
-#if ALLOW_DEBUGGING
 #include <thread>
+
+qcvm_thread_t qcvm_cpp_create_task(qcvm_task_func_t func, void *data)
+{
+	// no exception can be let out into C; if we can't get a thread,
+	// just run the task here instead.
+	try
+	{
+		return reinterpret_cast<qcvm_thread_t>(new std::thread(func, data));
+	}
+	catch (...)
+	{
+		func(data);
+		return nullptr;
+	}
+}
+
+void qcvm_cpp_join_thread(qcvm_thread_t thread)
+{
+	if (!thread)
+		return;
+
+	std::thread *t = reinterpret_cast<std::thread *>(thread);
+	t->join();
+	delete t;
+}
+
+#if ALLOW_DEBUGGING
 #include <mutex>
 #include <chrono>
 
@@ -1,18 +1,20 @@
 #pragma once
 
-#if ALLOW_DEBUGGING
 // Wrapper for C++ threads. Blek.
 #ifdef __cplusplus
 extern "C"
 {
 #endif
+	qcvm_thread_t qcvm_cpp_create_task(qcvm_task_func_t, void *);
+	void qcvm_cpp_join_thread(qcvm_thread_t);
+#if ALLOW_DEBUGGING
 	qcvm_mutex_t qcvm_cpp_create_mutex(void);
 	void qcvm_cpp_free_mutex(qcvm_mutex_t);
 	void qcvm_cpp_lock_mutex(qcvm_mutex_t);
 	void qcvm_cpp_unlock_mutex(qcvm_mutex_t);
 	qcvm_thread_t qcvm_cpp_create_thread(qcvm_thread_func_t);
 	void qcvm_cpp_thread_sleep(const uint32_t);
+#endif
 #ifdef __cplusplus
 };
-#endif
 #endif
\ No newline at end of file
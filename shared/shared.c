@@ -63,6 +63,32 @@ uint32_t Q_hash_string (const char *string, const size_t hash_size)
 	return (hashValue + (hashValue >> 5)) % hash_size;
 }
 
+/*
+================
+Q_hash_bytes
+
+FNV-1a with a final avalanche; returns the full 32-bit
+hash, so it can be masked into power-of-two tables.
+================
+*/
+uint32_t Q_hash_bytes(const char *data, const size_t len)
+{
+	uint32_t hashValue = 2166136261u;
+
+	for (size_t i = 0; i < len; i++)
+	{
+		hashValue ^= (uint8_t)data[i];
+		hashValue *= 16777619u;
+	}
+
+	hashValue ^= hashValue >> 16;
+	hashValue *= 0x85ebca6bu;
+	hashValue ^= hashValue >> 13;
+	hashValue *= 0xc2b2ae35u;
+	hashValue ^= hashValue >> 16;
+	return hashValue;
+}
+
 /*
 ================
 Q_hash_pointer
@@ -88,8 +114,8 @@ Q_next_pow2
 */
 uint64_t Q_next_pow2(uint64_t x)
 {
-#ifdef __GNU__
-	return x == 1 ? 1 : 1 << (64 - __builtin_clzl((uint32_t)(x - 1)));
+#ifdef __GNUC__
+	return x <= 1 ? x : 1ull << (64 - __builtin_clzll(x - 1));
 #else
 	x--;
 	x |= x >> 1;
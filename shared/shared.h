@@ -41,6 +41,12 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #if defined(__clang__) || defined(__GNUC__)
 #define qcvm_always_inline __attribute__((always_inline)) inline
 #define qcvm_noreturn __attribute__((noreturn))
+#if defined(__has_attribute)
+#if __has_attribute(musttail)
+// a tail call the compiler has to turn into a jump, or fail to build
+#define qcvm_musttail __attribute__((musttail))
+#endif
+#endif
 #elif defined(_MSC_VER)
 #define qcvm_always_inline __forceinline
 #ifndef __cplusplus
@@ -192,6 +198,8 @@ enum { MAX_INFO_STRING	= 512 };
 
 uint32_t Q_hash_string(const char *string, const size_t hash_size);
 
+uint32_t Q_hash_bytes(const char *data, const size_t len);
+
 uint32_t Q_hash_pointer(uint32_t a, const size_t hash_size);
 
 uint64_t Q_next_pow2(uint64_t x);
@@ -0,0 +1,252 @@
+#include "shared/shared.h"
+#include "vm.h"
+#include "game.h"
+#include "g_main.h"
+#include "tests/progs.h"
+
+// the VM links against the game's, but nothing here ever calls into them
+game_import_t gi;
+game_t game;
+game_export_t globals;
+qcvm_t *qvm;
+
+// same layout as the header qcvm_load reads
+enum
+{
+	PROGS_FTE				= 7,
+	PROG_SECONDARYVERSION32	= ((('1'<<0)|('F'<<8)|('T'<<16)|('E'<<24))^(('3'<<0)|('2'<<8)|('B'<<16)|(' '<<24)))
+};
+
+typedef struct
+{
+	uint32_t	offset;
+	uint32_t	size;
+} progs_offset_t;
+
+typedef struct
+{
+	uint32_t		version;
+	uint16_t		crc;
+	uint16_t		skip;
+
+	struct {
+		progs_offset_t	statement;
+		progs_offset_t	definition;
+		progs_offset_t	field;
+		progs_offset_t	function;
+		progs_offset_t	string;
+		progs_offset_t	globals;
+	} sections;
+
+	uint32_t		entityfields;
+
+	uint32_t		ofs_files;
+	uint32_t		ofs_linenums;
+	progs_offset_t	bodylessfuncs;
+	progs_offset_t	types;
+
+	uint32_t		blockscompressed;
+
+	uint32_t		secondary_version;
+} progs_header_t;
+
+static qcvm_noreturn void progs_error(const char *str)
+{
+	fprintf(stderr, "error: %s\n", str);
+	exit(EXIT_FAILURE);
+}
+
+static void progs_warning(const char *format, ...)
+{
+	va_list argptr;
+
+	va_start(argptr, format);
+	vfprintf(stderr, format, argptr);
+	va_end(argptr);
+}
+
+static void progs_debug_print(const char *str)
+{
+}
+
+static void *progs_alloc(const size_t size)
+{
+	void *ptr = calloc(1, size ? size : 1);
+
+	if (!ptr)
+		progs_error("out of memory");
+
+	return ptr;
+}
+
+static void progs_free(void *ptr)
+{
+	free(ptr);
+}
+
+static qcvm_string_t progs_string(progs_builder_t *progs, const char *str)
+{
+	const size_t len = strlen(str) + 1;
+
+	if (progs->strings_size + len > PROGS_MAX_STRINGS)
+		progs_error("too many strings");
+
+	memcpy(progs->strings + progs->strings_size, str, len);
+	progs->strings_size += len;
+	return (qcvm_string_t)(progs->strings_size - len);
+}
+
+static qcvm_global_t progs_reserve(progs_builder_t *progs, const size_t count)
+{
+	if (progs->globals_size + count > PROGS_MAX_GLOBALS)
+		progs_error("too many globals");
+
+	progs->globals_size += count;
+	return (qcvm_global_t)(progs->globals_size - count);
+}
+
+void progs_init(progs_builder_t *progs)
+{
+	memset(progs, 0, sizeof(*progs));
+
+	// empty string, null definition, function & statement
+	progs->strings_size = 1;
+	progs->definitions_size = 1;
+	progs->functions_size = 1;
+	progs_statement(progs, OP_DONE, 0, 0, 0);
+	progs_reserve(progs, GLOBAL_QC);
+
+	progs_global(progs, "strcasesensitive", TYPE_INTEGER, 0);
+}
+
+qcvm_global_t progs_global(progs_builder_t *progs, const char *name, const qcvm_deftype_t type, const qcvm_global_t value)
+{
+	const qcvm_global_t global = progs_reserve(progs, 1);
+
+	progs->globals[global] = value;
+
+	if (name)
+	{
+		if (progs->definitions_size == PROGS_MAX_DEFINITIONS)
+			progs_error("too many definitions");
+
+		progs->definitions[progs->definitions_size++] = (qcvm_definition_t) {
+			.id = type | TYPE_GLOBAL,
+			.global_index = global,
+			.name_index = progs_string(progs, name)
+		};
+	}
+
+	return global;
+}
+
+qcvm_global_t progs_int(progs_builder_t *progs, const int32_t value)
+{
+	return progs_global(progs, NULL, TYPE_INTEGER, (qcvm_global_t)value);
+}
+
+qcvm_global_t progs_float(progs_builder_t *progs, const vec_t value)
+{
+	qcvm_global_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return progs_global(progs, NULL, TYPE_FLOAT, bits);
+}
+
+qcvm_global_t progs_function(progs_builder_t *progs, const char *name, const uint32_t num_args, const uint32_t num_locals)
+{
+	if (progs->functions_size == PROGS_MAX_FUNCTIONS)
+		progs_error("too many functions");
+	else if (num_args > 8)
+		progs_error("too many arguments");
+
+	const qcvm_func_t id = (qcvm_func_t)progs->functions_size++;
+	const qcvm_global_t global = progs_global(progs, name, TYPE_FUNCTION, (qcvm_global_t)id);
+	qcvm_function_t *func = &progs->functions[id];
+
+	*func = (qcvm_function_t) {
+		.id = (qcvm_func_t)progs->statements_size,
+		.first_arg = progs_reserve(progs, num_args + num_locals),
+		.num_args_and_locals = num_args + num_locals,
+		.name_index = progs->definitions[progs->definitions_size - 1].name_index,
+		.num_args = num_args
+	};
+
+	for (uint32_t i = 0; i < num_args; i++)
+		func->arg_sizes[i] = 1;
+
+	// nothing else can live in the slots LOCALS_FIX covers, or the
+	// function can't be windowed
+	progs_reserve(progs, LOCALS_FIX);
+	return global;
+}
+
+qcvm_global_t progs_local(const progs_builder_t *progs, const uint32_t index)
+{
+	return progs->functions[progs->functions_size - 1].first_arg + index;
+}
+
+size_t progs_statement(progs_builder_t *progs, const qcvm_opcode_t opcode, const qcvm_global_t a, const qcvm_global_t b, const qcvm_global_t c)
+{
+	if (progs->statements_size == PROGS_MAX_STATEMENTS)
+		progs_error("too many statements");
+
+	progs->statements[progs->statements_size] = (qcvm_statement_t) { opcode, { a, b, c } };
+	return progs->statements_size++;
+}
+
+qcvm_global_t progs_jump(const size_t from, const size_t to)
+{
+	return (qcvm_global_t)(uint16_t)(int16_t)((int64_t)to - (int64_t)from);
+}
+
+static void progs_write(const progs_builder_t *progs, const char *filename)
+{
+	static const qcvm_definition_t null_field;
+	const size_t strings_size = (progs->strings_size + 3) & ~(size_t)3;
+	progs_header_t header = { .version = PROGS_FTE, .secondary_version = PROG_SECONDARYVERSION32 };
+	uint32_t offset = sizeof(header);
+
+#define PROGS_SECTION(name, count, element_size) \
+	header.sections.name = (progs_offset_t) { offset, (uint32_t)(count) }; \
+	offset += (uint32_t)((count) * (element_size))
+
+	PROGS_SECTION(statement, progs->statements_size, sizeof(qcvm_statement_t));
+	PROGS_SECTION(definition, progs->definitions_size, sizeof(qcvm_definition_t));
+	PROGS_SECTION(field, 1, sizeof(qcvm_definition_t));
+	PROGS_SECTION(function, progs->functions_size, sizeof(qcvm_function_t));
+	PROGS_SECTION(string, strings_size, sizeof(char));
+	PROGS_SECTION(globals, progs->globals_size, sizeof(qcvm_global_t));
+#undef PROGS_SECTION
+
+	FILE *fp = fopen(filename, "wb");
+
+	if (!fp)
+		progs_error("can't write progs");
+
+	fwrite(&header, sizeof(header), 1, fp);
+	fwrite(progs->statements, sizeof(qcvm_statement_t), progs->statements_size, fp);
+	fwrite(progs->definitions, sizeof(qcvm_definition_t), progs->definitions_size, fp);
+	fwrite(&null_field, sizeof(null_field), 1, fp);
+	fwrite(progs->functions, sizeof(qcvm_function_t), progs->functions_size, fp);
+	fwrite(progs->strings, sizeof(char), strings_size, fp);
+	fwrite(progs->globals, sizeof(qcvm_global_t), progs->globals_size, fp);
+	fclose(fp);
+}
+
+qcvm_t *progs_load(const progs_builder_t *progs, const char *filename)
+{
+	qcvm_t *vm = (qcvm_t *)progs_alloc(sizeof(qcvm_t));
+
+	vm->error = progs_error;
+	vm->warning = progs_warning;
+	vm->debug_print = progs_debug_print;
+	vm->alloc = progs_alloc;
+	vm->free = progs_free;
+
+	progs_write(progs, filename);
+	qcvm_load(vm, "progs test", filename);
+	qcvm_check(vm);
+	remove(filename);
+
+	return vm;
+}
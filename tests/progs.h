@@ -0,0 +1,59 @@
+#pragma once
+
+// Builds small 32-bit progs.dat files out of hand-written statements, so tests
+// & benchmarks can run real QC through qcvm_load & qcvm_check without a
+// compiler or a mod. Only what the VM needs to run code is written; there
+// are no fields, and every function is QC.
+
+#define OPCODES_ONLY
+#include "vm_opcodes.h"
+#undef OPCODES_ONLY
+
+enum
+{
+	PROGS_MAX_STATEMENTS	= 256,
+	PROGS_MAX_DEFINITIONS	= 64,
+	PROGS_MAX_FUNCTIONS		= 16,
+	PROGS_MAX_GLOBALS		= 1024,
+	PROGS_MAX_STRINGS		= 1024
+};
+
+typedef struct
+{
+	qcvm_statement_t	statements[PROGS_MAX_STATEMENTS];
+	size_t				statements_size;
+	qcvm_definition_t	definitions[PROGS_MAX_DEFINITIONS];
+	size_t				definitions_size;
+	qcvm_function_t		functions[PROGS_MAX_FUNCTIONS];
+	size_t				functions_size;
+	qcvm_global_t		globals[PROGS_MAX_GLOBALS];
+	size_t				globals_size;
+	char				strings[PROGS_MAX_STRINGS];
+	size_t				strings_size;
+} progs_builder_t;
+
+// starts out with the reserved globals & the definitions the VM requires
+void progs_init(progs_builder_t *progs);
+
+// a new global holding value; named ones get a definition of that type
+qcvm_global_t progs_global(progs_builder_t *progs, const char *name, const qcvm_deftype_t type, const qcvm_global_t value);
+qcvm_global_t progs_int(progs_builder_t *progs, const int32_t value);
+qcvm_global_t progs_float(progs_builder_t *progs, const vec_t value);
+
+// starts a function at the next statement, with its arguments (one slot each)
+// & locals after them in a fresh range of globals, and returns the global
+// holding it.
+qcvm_global_t progs_function(progs_builder_t *progs, const char *name, const uint32_t num_args, const uint32_t num_locals);
+
+// the first argument or local of the function last started
+qcvm_global_t progs_local(const progs_builder_t *progs, const uint32_t index);
+
+// appends a statement & returns its index
+size_t progs_statement(progs_builder_t *progs, const qcvm_opcode_t opcode, const qcvm_global_t a, const qcvm_global_t b, const qcvm_global_t c);
+
+// the branch offset from statement from to statement to
+qcvm_global_t progs_jump(const size_t from, const size_t to);
+
+// writes the progs to filename, then loads & checks it into a fresh VM
+// whose callbacks print & exit on errors.
+qcvm_t *progs_load(const progs_builder_t *progs, const char *filename);
@@ -0,0 +1,77 @@
+// recursion through a windowed function deep enough to run out of frame
+// stack; the calls that don't fit have to fall back to running out of
+// global_data, and every one of them still has to see its own locals.
+#include "shared/shared.h"
+#include "vm.h"
+#include "tests/progs.h"
+
+// sum(n) = n ? sum(n - 1) + n : 0, with n read again after the call
+static qcvm_function_t *build_sum(progs_builder_t *progs)
+{
+	const qcvm_global_t zero = progs_float(progs, 0), one = progs_float(progs, 1);
+	const qcvm_global_t sum = progs_function(progs, "sum", 1, 2);
+	const qcvm_global_t n = progs_local(progs, 0), cond = progs_local(progs, 1), result = progs_local(progs, 2);
+
+	progs_statement(progs, OP_GT_F, n, zero, cond);
+	const size_t branch = progs_statement(progs, OP_IFNOT_I, cond, 0, 0);
+	progs_statement(progs, OP_SUB_F, n, one, GLOBAL_PARM0);
+	progs_statement(progs, OP_CALL1, sum, 0, 0);
+	progs_statement(progs, OP_ADD_F, GLOBAL_RETURN, n, result);
+	progs_statement(progs, OP_RETURN, result, 0, 0);
+	const size_t bottom = progs_statement(progs, OP_RETURN, zero, 0, 0);
+	progs_statement(progs, OP_DONE, 0, 0, 0);
+
+	progs->statements[branch].args.b = progs_jump(branch, bottom);
+	return &progs->functions[progs->functions_size - 1];
+}
+
+static bool run_sum(qcvm_t *vm, const uint32_t depth)
+{
+	qcvm_function_t *func = qcvm_find_function(vm, "sum");
+	const vec_t n = (vec_t)depth;
+	volatile vec_t expected = 0;
+
+	for (uint32_t i = 1; i <= depth; i++)
+		expected += (vec_t)i;
+
+	qcvm_set_global_typed_value(vec_t, vm, GLOBAL_PARM0, n);
+	qcvm_execute(vm, func);
+
+	const vec_t result = *qcvm_get_global_typed(vec_t, vm, GLOBAL_RETURN);
+
+	printf("sum(%u) = %f, expected %f\n", depth, result, expected);
+
+	if (result != expected)
+		return false;
+	// everything has to be given back on the way out
+	else if (vm->state.frames_size || vm->state.unwindowed || vm->state.current != -1)
+	{
+		printf("frame stack left at %zu, %u unwindowed\n", vm->state.frames_size, vm->state.unwindowed);
+		return false;
+	}
+
+	return true;
+}
+
+int main(void)
+{
+	static progs_builder_t progs;
+
+	progs_init(&progs);
+	const size_t frame_size = build_sum(&progs)->num_args_and_locals;
+
+	qcvm_t *vm = progs_load(&progs, "recursion.dat");
+	const uint32_t deep = (uint32_t)(FRAME_STACK_SIZE / frame_size) * 2;
+
+	if (!vm->frame_sizes[qcvm_find_function(vm, "sum") - vm->functions])
+	{
+		printf("sum isn't windowed, so this doesn't test anything\n");
+		return EXIT_FAILURE;
+	}
+
+	// fits, overflows, then fits again
+	if (!run_sum(vm, 100) || !run_sum(vm, deep) || !run_sum(vm, 100))
+		return EXIT_FAILURE;
+
+	return EXIT_SUCCESS;
+}
@@ -12,6 +12,10 @@
 #include "vm_structlist.h"
 #include "vm_list.h"
 #include "vm_heap.h"
+#include "vm_aot.h"
+#include "vm_cache.h"
+#include "vm_mapping.h"
+#include "vm_jit.h"
 #include "vm_opcodes.h"
 
 #include <time.h>
@@ -97,16 +101,51 @@ qcvm_builtin_t qcvm_builtin_list_get(qcvm_t *vm, const qcvm_func_t func)
 	return vm->builtins.list[index];
 }
 
+static inline qcvm_string_t qcvm_symbol_name(const qcvm_t *vm, const qcvm_symbol_t *symbol)
+{
+	switch (symbol->kind)
+	{
+	case SYMBOL_DEFINITION:
+		return vm->definitions[symbol->index].name_index;
+	case SYMBOL_FIELD:
+		return vm->fields[symbol->index].name_index;
+	default:
+		return vm->functions[symbol->index].name_index;
+	}
+}
+
+// the next symbol of this kind called name after the given one (or the
+// first, if that's NULL). later declarations come first, except for
+// functions, where it's the other way around.
+static const qcvm_symbol_t *qcvm_find_symbol(const qcvm_t *vm, const char *name, const qcvm_symbol_kind_t kind, const qcvm_symbol_t *after)
+{
+	if (!vm->symbol_buckets)
+		return NULL;
+
+	const uint32_t hash = Q_hash_bytes(name, strlen(name));
+
+	for (uint32_t index = after ? after->next : vm->symbol_buckets[hash & vm->symbol_mask]; index; )
+	{
+		const qcvm_symbol_t *symbol = &vm->symbols[index - 1];
+
+		if (symbol->kind == kind && symbol->hash_value == hash && !strcmp(qcvm_get_string(vm, qcvm_symbol_name(vm, symbol)), name))
+			return symbol;
+
+		index = symbol->next;
+	}
+
+	return NULL;
+}
+
 void qcvm_builtin_list_register(qcvm_t *vm, const char *name, qcvm_builtin_t builtin)
 {
 	qcvm_builtin_list_t *list = &vm->builtins;
 
-	for (qcvm_function_t *func = vm->functions; func < vm->functions + vm->functions_size; func++)
+	for (const qcvm_symbol_t *symbol = NULL; (symbol = qcvm_find_symbol(vm, name, SYMBOL_FUNCTION, symbol)); )
 	{
-		if (func->id || func->name_index == STRING_EMPTY)
-			continue;
+		qcvm_function_t *func = &vm->functions[symbol->index];
 
-		if (strcmp(qcvm_get_string(vm, func->name_index), name) == 0)
+		if (!func->id)
 		{
 			if (list->registered == list->count)
 				qcvm_error(vm, "Builtin list overrun");
@@ -153,7 +192,7 @@ void qcvm_register_system_field(qcvm_t *vm, const char *field_name, const size_t
 	system_field->span = field_span;
 }
 
-const char *qcvm_parse_format(const qcvm_string_t formatid, const qcvm_t *vm, const uint8_t start)
+void qcvm_parse_format_append(qcvm_string_builder_t *builder, const qcvm_string_t formatid, const qcvm_t *vm, const uint8_t start)
 {
 	typedef enum
 	{
@@ -162,14 +201,14 @@ const char *qcvm_parse_format(const qcvm_string_t formatid, const qcvm_t *vm, co
 		PT_SKIP
 	} ParseToken;
 
-	static char buffer[0x800];
 	size_t i = 0;
 	const size_t len = qcvm_get_string_length(vm, formatid);
-	static char format_buffer[17];
+	char format_buffer[17];
 	uint8_t param_index = start;
 	const char *format = qcvm_get_string(vm, formatid);
-	char *p = buffer;
-	size_t len_left = sizeof(buffer) - 1;
+
+	// make sure the result is terminated even if nothing gets written
+	qcvm_string_builder_append(vm, builder, "", 0);
 
 	while (true)
 	{
@@ -177,22 +216,11 @@ const char *qcvm_parse_format(const qcvm_string_t formatid, const qcvm_t *vm, co
 
 		if (!next)
 		{
-			const size_t write_len = (format + len) - (format + i);
-			if (len_left < write_len)
-				qcvm_error(vm, "qcvm_parse_format overflow");
-
-			strncpy(p, format + i, write_len);
-			p += write_len;
-			len_left -= write_len;
+			qcvm_string_builder_append(vm, builder, format + i, len - i);
 			break;
 		}
 
-		size_t write_len = (next - format) - i;
-		if (len_left < write_len)
-			qcvm_error(vm, "qcvm_parse_format overflow");
-		strncpy(p, format + i, write_len);
-		p += write_len;
-		len_left -= write_len;
+		qcvm_string_builder_append(vm, builder, format + i, (next - format) - i);
 		i = next - format;
 
 		const char *specifier_start = next;
@@ -225,12 +253,7 @@ const char *qcvm_parse_format(const qcvm_string_t formatid, const qcvm_t *vm, co
 				state = PT_SPECIFIER;
 				continue;
 			case '%':
-				if (len_left < 1)
-					qcvm_error(vm, "qcvm_parse_format overflow");
-		
-				*p = '%';
-				p++;
-				len_left--;
+				qcvm_string_builder_append(vm, builder, "%", 1);
 				state = PT_SKIP;
 				continue;
 			}
@@ -240,8 +263,6 @@ const char *qcvm_parse_format(const qcvm_string_t formatid, const qcvm_t *vm, co
 		{
 			Q_strlcpy(format_buffer, specifier_start, minsz(sizeof(format_buffer), (size_t)((next - specifier_start) + 1 + 1)));
 
-			const char *formatted;
-
 			switch (*next)
 			{
 			case 'd':
@@ -251,7 +272,7 @@ const char *qcvm_parse_format(const qcvm_string_t formatid, const qcvm_t *vm, co
 			case 'X':
 			case 'c':
 			case 'p':
-				formatted = qcvm_temp_format(vm, format_buffer, qcvm_argv_int32(vm, param_index++));
+				qcvm_string_builder_appendf(vm, builder, format_buffer, qcvm_argv_int32(vm, param_index++));
 				break;
 			case 'f':
 			case 'F':
@@ -261,58 +282,70 @@ const char *qcvm_parse_format(const qcvm_string_t formatid, const qcvm_t *vm, co
 			case 'G':
 			case 'a':
 			case 'A':
-				formatted = qcvm_temp_format(vm, format_buffer, qcvm_argv_float(vm, param_index++));
+				qcvm_string_builder_appendf(vm, builder, format_buffer, qcvm_argv_float(vm, param_index++));
 				break;
 			case 's':
-				formatted = qcvm_temp_format(vm, format_buffer, qcvm_argv_string(vm, param_index++));
+				qcvm_string_builder_appendf(vm, builder, format_buffer, qcvm_argv_string(vm, param_index++));
 				break;
 			default:
 				qcvm_error(vm, "invalid specifier");
 			}
-			
-			write_len = strlen(formatted);
-			if (len_left < write_len)
-				qcvm_error(vm, "qcvm_parse_format overflow");
-			strncpy(p, formatted, write_len);
-			p += write_len;
-			len_left -= write_len;
 		}
 
 		i++;
 	}
+}
 
-	*p = 0;
-	return buffer;
+const char *qcvm_parse_format(const qcvm_string_t formatid, qcvm_t *vm, const uint8_t start)
+{
+	qcvm_string_builder_clear(&vm->format_builder);
+	qcvm_parse_format_append(&vm->format_builder, formatid, vm, start);
+	return vm->format_builder.data;
 }
 
 static void qcvm_field_wrap_list_init(qcvm_t *vm)
 {
 	vm->field_wraps = (qcvm_field_wrapper_t *)qcvm_alloc(vm, sizeof(qcvm_field_wrapper_t) * vm->field_real_size);
+	vm->field_wrap_bits = (uint32_t *)qcvm_alloc(vm, sizeof(uint32_t) * ((vm->field_real_size + 31) / 32));
 }
 
-void qcvm_field_wrap_list_register(qcvm_t *vm, const char *field_name, const size_t field_offset, const size_t struct_offset, qcvm_field_setter_t setter)
+static inline bool qcvm_field_is_wrapped(const qcvm_t *vm, const size_t offset)
 {
-	for (qcvm_definition_t *f = vm->fields; f < vm->fields + vm->fields_size; f++)
-	{
-		if (f->name_index == STRING_EMPTY)
-			continue;
-		else if (strcmp(qcvm_get_string(vm, f->name_index), field_name))
-			continue;
+	return vm->field_wrap_bits[offset >> 5] & (1u << (offset & 31));
+}
 
-		assert((f->global_index + field_offset) < vm->field_real_size);
+void qcvm_field_wrap_list_register(qcvm_t *vm, const char *field_name, const size_t field_offset, const size_t struct_offset, qcvm_field_setter_t setter)
+{
+	qcvm_definition_t *f = qcvm_find_field(vm, field_name);
 
-		qcvm_field_wrapper_t *wrapper = &vm->field_wraps[f->global_index + field_offset];
-		*wrapper = (qcvm_field_wrapper_t) {
-			f,
-			f->global_index + field_offset,
-			strncmp(field_name, "client.", 7) == 0,
-			struct_offset,
-			setter
-		};
+	if (!f)
+	{
+		vm->warning("QCVM WARNING: can't find field %s in progs\n", field_name);
 		return;
 	}
 
-	vm->warning("QCVM WARNING: can't find field %s in progs\n", field_name);
+	assert((f->global_index + field_offset) < vm->field_real_size);
+
+	qcvm_field_wrapper_t *wrapper = &vm->field_wraps[f->global_index + field_offset];
+	*wrapper = (qcvm_field_wrapper_t) {
+		f,
+		f->global_index + field_offset,
+		strncmp(field_name, "client.", 7) == 0,
+		struct_offset,
+		setter
+	};
+
+	vm->field_wrap_bits[wrapper->field_offset >> 5] |= 1u << (wrapper->field_offset & 31);
+}
+
+static inline void qcvm_field_wrap_apply(const qcvm_field_wrapper_t *wrap, edict_t *ent, const int32_t *value)
+{
+	void *dst = (void *)(((wrap->is_client) ? (uint8_t *)ent->client : (uint8_t *)ent) + wrap->struct_offset);
+
+	if (wrap->setter)
+		wrap->setter(dst, value);
+	else
+		*(int32_t *)dst = *value;
 }
 
 void qcvm_field_wrap_list_check_set(qcvm_t *vm, const void *ptr, const size_t span)
@@ -331,41 +364,96 @@ void qcvm_field_wrap_list_check_set(qcvm_t *vm, const void *ptr, const size_t sp
 	}
 
 	// check where we're starting
-	void *start = (void *)((uint8_t *)ptr - (uint8_t *)vm->edicts);
-	edict_t *ent = (edict_t *)qcvm_itoe(vm, (int32_t)((ptrdiff_t)start / vm->edict_size));
+	size_t number = (size_t)((const uint8_t *)ptr - (const uint8_t *)vm->edicts) / vm->edict_size;
+	edict_t *ent = (edict_t *)qcvm_itoe(vm, (int32_t)number);
 	size_t offset = (const uint32_t *)ptr - (uint32_t *)ent;
 	const int32_t *sptr = (const int32_t *)ptr;
+	qcvm_deferred_wraps_t *deferred = &vm->deferred_wraps;
 
 	for (size_t i = 0; i < span; i++, sptr++, offset++)
 	{
 		// we're wrapping over to a new entity
 		if (offset >= vm->field_real_size)
 		{
-			ent++;
+			ent = (edict_t *)qcvm_itoe(vm, (int32_t)++number);
 			offset = 0;
 		}
 
-		const qcvm_field_wrapper_t *wrap = &vm->field_wraps[offset];
-
-		if (!wrap->field)
+		if (!qcvm_field_is_wrapped(vm, offset))
 			continue;
 
-		if (wrap->field_offset != offset)
-			continue;
+		const qcvm_field_wrapper_t *wrap = &vm->field_wraps[offset];
 
 		// client wraps may attempt to write to them on non-clients
 		// during memcpy, etc
 		if (wrap->is_client && !ent->client)
 			continue;
 
-		void *dst = (void *)(((wrap->is_client) ? (uint8_t *)ent->client : (uint8_t *)ent) + wrap->struct_offset);
-			
-		if (wrap->setter)
-			wrap->setter(dst, sptr);
-		else
-			*(int32_t *)dst = *sptr;
+		// picked up by qcvm_field_wrap_list_sync, which reads whatever's there by then
+		if (wrap->is_client && number < deferred->num_entities)
+		{
+			deferred->dirty[number * deferred->num_words + (offset >> 5)] |= 1u << (offset & 31);
+			deferred->entity_dirty[number] = deferred->any_dirty = true;
+			continue;
+		}
+
+		qcvm_field_wrap_apply(wrap, ent, sptr);
+	}
+
+	END_TIMER(vm, PROFILE_TIMERS);
+}
+
+void qcvm_field_wrap_list_defer(qcvm_t *vm, const size_t num_entities)
+{
+	qcvm_deferred_wraps_t *deferred = &vm->deferred_wraps;
+
+	deferred->num_entities = num_entities;
+	deferred->num_words = (vm->field_real_size + 31) / 32;
+	deferred->dirty = (uint32_t *)qcvm_alloc(vm, sizeof(uint32_t) * deferred->num_words * num_entities);
+	deferred->entity_dirty = (bool *)qcvm_alloc(vm, sizeof(bool) * num_entities);
+	deferred->any_dirty = false;
+}
+
+void qcvm_field_wrap_list_sync(qcvm_t *vm)
+{
+	qcvm_deferred_wraps_t *deferred = &vm->deferred_wraps;
+
+	if (!deferred->any_dirty)
+		return;
+
+	START_TIMER(vm, WrapApply);
+
+	for (size_t number = 0; number < deferred->num_entities; number++)
+	{
+		if (!deferred->entity_dirty[number])
+			continue;
+
+		edict_t *ent = (edict_t *)qcvm_itoe(vm, (int32_t)number);
+		uint32_t *dirty = deferred->dirty + (number * deferred->num_words);
+
+		deferred->entity_dirty[number] = false;
+
+		for (size_t w = 0; w < deferred->num_words; w++)
+		{
+			if (!dirty[w])
+				continue;
+
+			// the client could have gone away since
+			for (size_t bit = 0; bit < 32 && ent->client; bit++)
+			{
+				if (!(dirty[w] & (1u << bit)))
+					continue;
+
+				const size_t offset = (w << 5) | bit;
+				qcvm_field_wrap_apply(&vm->field_wraps[offset], ent, (const int32_t *)ent + offset);
+			}
+
+			dirty[w] = 0;
+		}
 	}
 
+	deferred->any_dirty = false;
+
 	END_TIMER(vm, PROFILE_TIMERS);
 }
 
@@ -384,6 +472,7 @@ static void qcvm_state_free(qcvm_state_t *state)
 	}
 
 	qcvm_mem_free(state->vm, state->stack);
+	qcvm_mem_free(state->vm, state->frames);
 }
 
 void qcvm_state_needs_resize(qcvm_state_t *state)
@@ -435,8 +524,19 @@ static void qcvm_init(qcvm_t *vm)
 
 static void qcvm_free(qcvm_t *vm)
 {
+#if ALLOW_AOT
+	qcvm_aot_free(vm);
+#endif
+#if ALLOW_JIT
+	qcvm_jit_free(vm);
+#endif
+#if ALLOW_PROGS_CACHE
+	qcvm_cache_free(vm);
+#endif
+	qcvm_unmap_file(&vm->progs_mapping);
 	qcvm_mem_free(vm, vm->string_hashes);
 	qcvm_mem_free(vm, vm->string_hashes_data);
+	qcvm_string_builder_free(vm, &vm->format_builder);
 	qcvm_state_free(&vm->state);
 }
 
@@ -618,7 +718,6 @@ void qcvm_set_global(qcvm_t *vm, const qcvm_global_t global, const void *value,
 	void *dst = qcvm_get_global(vm, global);
 	memcpy(dst, value, value_size);
 	qcvm_string_list_check_ref_unset(vm, dst, value_size / sizeof(qcvm_global_t), false);
-	qcvm_field_wrap_list_check_set(vm, dst, value_size / sizeof(qcvm_global_t));
 }
 
 // safe way of copying globals between other globals
@@ -632,7 +731,6 @@ void qcvm_copy_globals(qcvm_t *vm, const qcvm_global_t dst, const qcvm_global_t
 	memcpy(dst_ptr, src_ptr, size);
 
 	qcvm_string_list_mark_refs_copied(vm, src_ptr, dst_ptr, span);
-	qcvm_field_wrap_list_check_set(vm, dst_ptr, span);
 }
 
 const char *qcvm_stack_entry(const qcvm_t *vm, const qcvm_stack_t *s, const bool compact)
@@ -676,30 +774,23 @@ const char *qcvm_stack_trace(const qcvm_t *vm, const bool compact)
 
 qcvm_definition_t *qcvm_find_definition(qcvm_t *vm, const char *name, const qcvm_deftype_t type)
 {
-	qcvm_definition_hash_t *hashed = vm->definition_hashes[Q_hash_string(name, vm->definitions_size)];
-
-	for (; hashed; hashed = hashed->hash_next)
-		if ((hashed->def->id & ~TYPE_GLOBAL) == type && !strcmp(qcvm_get_string(vm, hashed->def->name_index), name))
-			break;
-
-	if (hashed)
-		return hashed->def;
+	for (const qcvm_symbol_t *symbol = NULL; (symbol = qcvm_find_symbol(vm, name, SYMBOL_DEFINITION, symbol)); )
+		if ((vm->definitions[symbol->index].id & ~TYPE_GLOBAL) == type)
+			return &vm->definitions[symbol->index];
 
 	return NULL;
 }
 
-qcvm_definition_t *qcvm_find_field(qcvm_t *vm, const char *name)
+qcvm_definition_t *qcvm_find_definition_by_name(qcvm_t *vm, const char *name)
 {
-	qcvm_definition_hash_t *hashed = vm->field_hashes[Q_hash_string(name, vm->fields_size)];
-
-	for (; hashed; hashed = hashed->hash_next)
-		if (!strcmp(qcvm_get_string(vm, hashed->def->name_index), name))
-			break;
-
-	if (hashed)
-		return hashed->def;
+	const qcvm_symbol_t *symbol = qcvm_find_symbol(vm, name, SYMBOL_DEFINITION, NULL);
+	return symbol ? &vm->definitions[symbol->index] : NULL;
+}
 
-	return NULL;
+qcvm_definition_t *qcvm_find_field(qcvm_t *vm, const char *name)
+{
+	const qcvm_symbol_t *symbol = qcvm_find_symbol(vm, name, SYMBOL_FIELD, NULL);
+	return symbol ? &vm->fields[symbol->index] : NULL;
 }
 
 #if ALLOW_DEBUGGING
@@ -749,6 +840,9 @@ static qcvm_evaluated_t qcvm_evaluate_from_local_or_global(qcvm_t *vm, const cha
 
 			if (!def || def->name_index == STRING_EMPTY || strcmp(variable, qcvm_get_string(vm, def->name_index)))
 				continue;
+			// windowed, so it's in the frame and not where the def says
+			else if (current->frame)
+				return qcvm_value_from_ptr(def, current->frame + i);
 
 			return qcvm_value_from_global(vm, def);
 		}
@@ -895,13 +989,8 @@ const char *qcvm_function_for(const qcvm_t *vm, const qcvm_statement_t *statemen
 
 qcvm_func_t qcvm_find_function_id(const qcvm_t *vm, const char *name)
 {
-	size_t i = 0;
-
-	for (qcvm_function_t *func = vm->functions; func < vm->functions + vm->functions_size; func++, i++)
-		if (!strcmp(qcvm_get_string(vm, func->name_index), name))
-			return (qcvm_func_t)i;
-
-	return FUNC_VOID;
+	const qcvm_symbol_t *symbol = qcvm_find_symbol(vm, name, SYMBOL_FUNCTION, NULL);
+	return symbol ? (qcvm_func_t)symbol->index : FUNC_VOID;
 }
 
 qcvm_function_t *qcvm_get_function(const qcvm_t *vm, const qcvm_func_t id)
@@ -994,6 +1083,22 @@ qcvm_pointer_t qcvm_get_entity_field_pointer(qcvm_t *vm, edict_t *ent, const int
 	return ptr;
 }
 
+static void qcvm_execute_function(qcvm_t *vm, qcvm_function_t *function)
+{
+#if ALLOW_AOT
+	if (qcvm_aot_execute(vm, function))
+		return;
+#endif
+
+#if ALLOW_JIT
+	if (qcvm_jit_execute(vm, function))
+		return;
+#endif
+
+	qcvm_enter(vm, function);
+	qcvm_interpret(vm, 1);
+}
+
 void qcvm_execute(qcvm_t *vm, qcvm_function_t *function)
 {
 	if (!function || function->id == 0)
@@ -1005,85 +1110,47 @@ void qcvm_execute(qcvm_t *vm, qcvm_function_t *function)
 		return;
 	}
 
-	int32_t enter_depth = 1;
-	const qcvm_statement_t *statement;
+	// QC that a builtin is calling back into; qcvm_analyze_calls can't see
+	// these, so every spill happens as normal until we're back out
+	const bool reentered = vm->state.current >= 0;
 
-	qcvm_enter(vm, function);
-
-	while (1)
-	{
-		// get next statement
-		qcvm_stack_t *current = &vm->state.stack[vm->state.current];
-		statement = ++current->statement;
+	if (reentered)
+		vm->state.reentered++;
 
-#if ALLOW_INSTRUMENTING
-		if (vm->profiling.flags & PROFILE_FIELDS)
-			current->profile->fields[NumInstructions][vm->profiling.mark]++;
-#endif
+	qcvm_execute_function(vm, function);
 
-#if ALLOW_DEBUGGING
-		if (vm->debug.attached)
-		{
-			if (statement->opcode & OP_BREAKPOINT)
-				qcvm_break_on_current_statement(vm);
-			else
-			{
-				// figure out if we need to break here.
-				// step into is easiest: next QC execution that is not on the same function+line combo
-				if (vm->debug.state == DEBUG_STEP_INTO)
-				{
-					if (vm->debug.step_function != current->function || qcvm_line_number_for(vm, vm->debug.step_statement) != qcvm_line_number_for(vm, current->statement))
-						qcvm_break_on_current_statement(vm);
-				}
-				// I lied, step out is the easiest
-				else if (vm->debug.state == DEBUG_STEP_OUT)
-				{
-					if (vm->debug.step_depth > vm->state.current)
-						qcvm_break_on_current_statement(vm);
-				}
-				// step over: either step out, or the next step that is in the same function + stack depth + not on same line
-				else if (vm->debug.state == DEBUG_STEP_OVER)
-				{
-					if (vm->debug.step_depth > vm->state.current ||
-						(vm->debug.step_depth == vm->state.current && vm->debug.step_function == current->function && qcvm_line_number_for(vm, vm->debug.step_statement) != qcvm_line_number_for(vm, current->statement)))
-						qcvm_break_on_current_statement(vm);
-				}
-			}
-		}
+	if (reentered)
+		vm->state.reentered--;
+}
 
-		const qcvm_opcode_t code = statement->opcode & ~OP_BREAKPOINT;
-#else
-		const qcvm_opcode_t code = statement->opcode;
+// the loop is built once as-is, and once with the debugger, instrumentation &
+// profiling hooks; the latter only runs while one of those is actually on.
+#define QCVM_INTERPRET			qcvm_interpret_plain
+#define QCVM_INTERPRET_HOOKED	0
+#include "vm_interpret.c.h"
+#undef QCVM_INTERPRET
+#undef QCVM_INTERPRET_HOOKED
+
+#if ALLOW_DEBUGGING || ALLOW_INSTRUMENTING || ALLOW_PROFILING
+#define QCVM_INTERPRET			qcvm_interpret_hooked
+#define QCVM_INTERPRET_HOOKED	1
+#include "vm_interpret.c.h"
+#undef QCVM_INTERPRET
+#undef QCVM_INTERPRET_HOOKED
 #endif
-		JUMPCODE_LIST;
-
-		START_OPCODE_TIMER(vm, code);
 
-		EXECUTE_JUMPCODE;
-
-		END_TIMER(vm, PROFILE_OPCODES);
-
-#if ALLOW_PROFILING
-		if (vm->profiling.flags & PROFILE_SAMPLES)
-		{
-			if (!--vm->profiling.sampling.id)
-			{
-				vm->profiling.sampling.data[statement - vm->statements].count[vm->profiling.mark]++;
-				vm->profiling.sampling.id = vm->profiling.sampling.rate;
-			}
-		}
+void qcvm_interpret(qcvm_t *vm, int32_t enter_depth)
+{
+	// same conditions the JIT & AOT code stand down for
+	if (!qcvm_can_run_native(vm))
+	{
+#if ALLOW_DEBUGGING || ALLOW_INSTRUMENTING || ALLOW_PROFILING
+		qcvm_interpret_hooked(vm, enter_depth);
+		return;
 #endif
-
-		if (!enter_depth)
-			return;		// all done
 	}
 
-	/*vm->debug_print(qcvm_temp_format(vm, "Infinite loop broken @ %s\n", qcvm_stack_trace(vm, true)));
-	
-	while (vm->state.current != -1)
-		qcvm_leave(vm);*/
-
-JUMPCODE_ASM
+	qcvm_interpret_plain(vm, enter_depth);
 }
 
 static const uint32_t QCVM_VERSION	= 1;
@@ -1173,190 +1240,528 @@ static void VMLoadDefinitions(qcvm_t *vm, FILE *fp, qcvm_definition_t *dst, cons
 	qcvm_mem_free(vm, defs);
 }
 
-void qcvm_load(qcvm_t *vm, const char *engine_name, const char *filename)
+// lengths and folded hashes at every location
+// returns true if string_lengths and string_folded_hashes still have to
+// be filled in by qcvm_measure_strings.
+static bool qcvm_alloc_string_measures(qcvm_t *vm)
 {
-	qcvm_init(vm);
+	size_t lengths_size = 0, folded_hashes_size = 0;
+	const size_t *cached_lengths = (const size_t *)qcvm_cache_section(vm, CACHE_STRING_LENGTHS, &lengths_size);
+	const uint32_t *cached_folded_hashes = (const uint32_t *)qcvm_cache_section(vm, CACHE_STRING_FOLDED_HASHES, &folded_hashes_size);
 
-	vm->engine_name = engine_name;
+	// these are never written to after this, so they can point right into the cache
+	if (cached_lengths && cached_folded_hashes && lengths_size == sizeof(size_t) * vm->string_size && folded_hashes_size == sizeof(uint32_t) * vm->string_size)
+	{
+		vm->string_lengths = (size_t *)cached_lengths;
+		vm->string_folded_hashes = (uint32_t *)cached_folded_hashes;
+		return false;
+	}
 
-	const char *last_slash = strrchr(filename, '\\');
+	vm->string_lengths = (size_t *)qcvm_alloc(vm, sizeof(size_t) * vm->string_size);
+	vm->string_folded_hashes = (uint32_t *)qcvm_alloc(vm, sizeof(uint32_t) * vm->string_size);
+	return true;
+}
 
-	if (!last_slash)
-		last_slash = strrchr(filename, '/');
+static void qcvm_measure_strings(qcvm_t *vm)
+{
+	// back to front, since each one is the one after it plus a character
+	uint32_t folded_hash = STRING_FOLD_HASH_SEED;
+	size_t len = 0;
 
-	if (!last_slash)
-		vm->path[0] = 0;
-	else
-		strncpy(vm->path, filename, last_slash - filename + 1);
+	for (size_t i = vm->string_size; i; i--)
+	{
+		const char c = vm->string_data[i - 1];
 
-	FILE *fp = fopen(filename, "rb");
+		if (!c)
+		{
+			folded_hash = STRING_FOLD_HASH_SEED;
+			len = 0;
+			continue;
+		}
 
-	if (!fp)
-		qcvm_error(vm, "no progs.dat");
+		folded_hash = qcvm_string_fold_hash_step(folded_hash, c);
+		vm->string_folded_hashes[i - 1] = qcvm_string_fold_hash_final(folded_hash);
+		vm->string_lengths[i - 1] = ++len;
+	}
+}
 
-	qcvm_header_t header;
+// relink the string map from the cache, if it has it
+static bool qcvm_load_cached_strings(qcvm_t *vm)
+{
+	size_t buckets_size = 0, entries_size = 0;
+	const uint32_t *buckets = (const uint32_t *)qcvm_cache_section(vm, CACHE_STRING_HASH_BUCKETS, &buckets_size);
+	const qcvm_cache_string_hash_t *entries = (const qcvm_cache_string_hash_t *)qcvm_cache_section(vm, CACHE_STRING_HASH_ENTRIES, &entries_size);
 
-	fread(&header, sizeof(header), 1, fp);
+	if (!buckets || !entries)
+		return false;
 
-	if (header.version != PROGS_Q1 && header.version != PROGS_FTE)
-		qcvm_error(vm, "bad version (only version 6 & 7 progs are supported)");
+	const size_t num_buckets = buckets_size / sizeof(uint32_t), num_entries = entries_size / sizeof(qcvm_cache_string_hash_t);
 
-	vm->global_size = header.sections.globals.size;
+	if (!num_buckets || (num_buckets & (num_buckets - 1)))
+		return false;
 
-	vm->string_size = header.sections.string.size;
-	vm->string_data = (char *)qcvm_alloc(vm, sizeof(char) * vm->string_size);
-	vm->string_lengths = (size_t *)qcvm_alloc(vm, sizeof(size_t) * vm->string_size);
+	vm->string_hash_mask = (uint32_t)(num_buckets - 1);
+	vm->string_hashes = (qcvm_string_hash_t **)qcvm_alloc(vm, sizeof(qcvm_string_hash_t *) * num_buckets);
+	vm->string_hashes_data = (qcvm_string_hash_t *)qcvm_alloc(vm, sizeof(qcvm_string_hash_t) * maxsz(num_entries, 1));
 
-	fseek(fp, header.sections.string.offset, SEEK_SET);
-	fread(vm->string_data, sizeof(char), header.sections.string.size, fp);
-	
-	vm->string_hashes = (qcvm_string_hash_t **)qcvm_alloc(vm, sizeof(qcvm_string_hash_t *) * vm->string_size);
-	vm->string_hashes_data = (qcvm_string_hash_t *)qcvm_alloc(vm, sizeof(qcvm_string_hash_t) * vm->string_size);
+	for (size_t i = 0; i < num_buckets; i++)
+		if (buckets[i] && buckets[i] <= num_entries)
+			vm->string_hashes[i] = &vm->string_hashes_data[buckets[i] - 1];
 
-#ifdef _DEBUG
-	size_t added_hash_values = 0, unique_hash_values = 0, max_hash_depth = 0;
-#endif
-	
-	// create immutable string map, for fast hash action
-	for (size_t i = 0; i < vm->string_size; i++)
+	for (size_t i = 0; i < num_entries; i++)
 	{
-		const char *s = vm->string_data + i;
+		qcvm_string_hash_t *hashed = &vm->string_hashes_data[i];
 
-		if (!*s)
-			continue;
+		hashed->str = vm->string_data + minsz(entries[i].offset, vm->string_size - 1);
+		hashed->hash_value = entries[i].hash_value;
+		hashed->hash_next = (entries[i].next && entries[i].next <= num_entries) ? &vm->string_hashes_data[entries[i].next - 1] : NULL;
+	}
 
-		const size_t s_len = strlen(s);
+	return true;
+}
 
-		for (size_t x = 0; x < s_len; x++)
-		{
-			size_t len = s_len - x;
-			vm->string_lengths[i + x] = len;
-			qcvm_string_hash_t *hashed = &vm->string_hashes_data[i + x];
-			hashed->str = s + x;
-			hashed->hash_value = Q_hash_string(s + x, vm->string_size);
-
-			// if we already have this string hashed, don't hash us again
-			for (qcvm_string_hash_t *existing_hashed = vm->string_hashes[hashed->hash_value]; ; existing_hashed = existing_hashed->hash_next)
-			{
-				if (!existing_hashed)
-				{
-#ifdef _DEBUG
-					if (!vm->string_hashes[hashed->hash_value])
-						unique_hash_values++;
-#endif
+// mark a string id that's used by the progs; string starts are always
+// indexed, so only suffixes need to be remembered.
+static inline void qcvm_mark_string_ref(const qcvm_t *vm, bool *referenced, size_t *num_indexed, const qcvm_global_t id)
+{
+	if (id == 0 || id >= vm->string_size || !vm->string_data[id] || !vm->string_data[id - 1] || referenced[id])
+		return;
+
+	referenced[id] = true;
+	(*num_indexed)++;
+}
 
-					hashed->hash_next = vm->string_hashes[hashed->hash_value];
-					vm->string_hashes[hashed->hash_value] = hashed;
+// scratch space for the parts of qcvm_load that run as tasks; they only ever
+// write to what was allocated for them up front, since vm->alloc & friends
+// can't be called from other threads.
+typedef struct
+{
+	qcvm_t					*vm;
+	bool					measure_strings, index_strings, index_symbols;
+	bool					*referenced;
+	size_t					num_indexed;
+	const qcvm_statement_t	*invalid_statement;
+	bool					invalid_name;
+	qcvm_string_t			invalid_name_index;
+	FILE					*lno;
 #ifdef _DEBUG
-					added_hash_values++;
+	size_t					added_hash_values, unique_hash_values, max_hash_depth;
 #endif
-					break;
-				}
-				else if (!strcmp(existing_hashed->str, hashed->str))
-					break;
-			}
+} qcvm_load_state_t;
 
-#ifdef _DEBUG
-			size_t depth = 1;
+// mark every string id the progs uses, and return how many strings
+// qcvm_index_strings will have to index.
+static size_t qcvm_mark_string_refs(const qcvm_t *vm, bool *referenced)
+{
+	size_t num_indexed = 0;
 
-			for (qcvm_string_hash_t *existing_hashed = vm->string_hashes[hashed->hash_value]; existing_hashed; existing_hashed = existing_hashed->hash_next, depth++) ;
+	for (size_t i = 0; i < vm->string_size; i++)
+		if (vm->string_data[i] && (i == 0 || !vm->string_data[i - 1]))
+			num_indexed++;
 
-			max_hash_depth = maxsz(max_hash_depth, depth);
-#endif
-		}
+	// anything that can hold a string id that isn't a string start
+	for (const qcvm_definition_t *def = vm->definitions; def < vm->definitions + vm->definitions_size; def++)
+	{
+		qcvm_mark_string_ref(vm, referenced, &num_indexed, (qcvm_global_t)def->name_index);
 
-		i += s_len;
+		if ((def->id & ~TYPE_GLOBAL) == TYPE_STRING && def->global_index < vm->global_size)
+			qcvm_mark_string_ref(vm, referenced, &num_indexed, vm->global_data[def->global_index]);
 	}
 
-	qcvm_debug(vm, "String hash table: %u added, %u unique, %u max depth, %u strings total\n", added_hash_values, unique_hash_values, max_hash_depth, vm->string_size);
+	for (const qcvm_definition_t *field = vm->fields; field < vm->fields + vm->fields_size; field++)
+		qcvm_mark_string_ref(vm, referenced, &num_indexed, (qcvm_global_t)field->name_index);
 
-	vm->statements_size = header.sections.statement.size;
-	vm->statements = (qcvm_statement_t *)qcvm_alloc(vm, sizeof(qcvm_statement_t) * vm->statements_size);
+	for (const qcvm_function_t *func = vm->functions; func < vm->functions + vm->functions_size; func++)
+	{
+		qcvm_mark_string_ref(vm, referenced, &num_indexed, (qcvm_global_t)func->name_index);
+		qcvm_mark_string_ref(vm, referenced, &num_indexed, (qcvm_global_t)func->file_index);
+	}
 
-	fseek(fp, header.sections.statement.offset, SEEK_SET);
-	VMLoadStatements(vm, fp, vm->statements, &header);
+	// immediates don't always have a definition; statements don't say which
+	// operands are strings, so this is conservative.
+	for (const qcvm_statement_t *s = vm->statements; s < vm->statements + vm->statements_size; s++)
+	{
+		const qcvm_global_t args[] = { s->args.a, s->args.b, s->args.c };
 
-	for (qcvm_statement_t *s = vm->statements; s < vm->statements + vm->statements_size; s++)
-		if (s->opcode >= OP_NUMOPS || !qcvm_code_funcs[s->opcode])
-			qcvm_error(vm, "opcode invalid or not implemented: %i\n", s->opcode);
-	
-	vm->definitions_size = header.sections.definition.size;
-	vm->definitions = (qcvm_definition_t *)qcvm_alloc(vm, sizeof(qcvm_definition_t) * vm->definitions_size);
+		for (size_t i = 0; i < 3; i++)
+			if (args[i] < vm->global_size)
+				qcvm_mark_string_ref(vm, referenced, &num_indexed, vm->global_data[args[i]]);
+	}
 
-	fseek(fp, header.sections.definition.offset, SEEK_SET);
-	VMLoadDefinitions(vm, fp, vm->definitions, &header, vm->definitions_size);
+	return num_indexed;
+}
 
-	vm->definition_map_by_id = (qcvm_definition_t **)qcvm_alloc(vm, sizeof(qcvm_definition_t) * vm->global_size);
-	vm->definition_hashes = (qcvm_definition_hash_t **)qcvm_alloc(vm, sizeof(qcvm_definition_hash_t *) * vm->definitions_size);
-	vm->definition_hashes_data = (qcvm_definition_hash_t *)qcvm_alloc(vm, sizeof(qcvm_definition_hash_t) * vm->definitions_size);
-	
-	for (qcvm_definition_t *definition = vm->definitions; definition < vm->definitions + vm->definitions_size; definition++)
+static void qcvm_alloc_string_hashes(qcvm_t *vm, const size_t num_indexed)
+{
+	const size_t hash_size = Q_next_pow2(maxsz(num_indexed, 1));
+	vm->string_hash_mask = (uint32_t)(hash_size - 1);
+	vm->string_hashes = (qcvm_string_hash_t **)qcvm_alloc(vm, sizeof(qcvm_string_hash_t *) * hash_size);
+	vm->string_hashes_data = (qcvm_string_hash_t *)qcvm_alloc(vm, sizeof(qcvm_string_hash_t) * maxsz(num_indexed, 1));
+}
+
+// build the immutable string map in one pass; string_lengths and
+// string_folded_hashes must already be filled in, and the strings
+// marked by qcvm_mark_string_refs.
+static void qcvm_index_strings(qcvm_load_state_t *load)
+{
+	qcvm_t *vm = load->vm;
+	const bool *referenced = load->referenced;
+#ifdef _DEBUG
+	size_t added_hash_values = 0, unique_hash_values = 0, max_hash_depth = 0;
+#endif
+	qcvm_string_hash_t *hashed = vm->string_hashes_data;
+
+	for (size_t i = 0; i < vm->string_size; i++)
 	{
-		if (definition->name_index != STRING_EMPTY)
+		if (!vm->string_data[i] || !(i == 0 || !vm->string_data[i - 1] || referenced[i]))
+			continue;
+
+		const char *str = vm->string_data + i;
+		const size_t len = vm->string_lengths[i];
+		const uint32_t hash_value = Q_hash_bytes(str, len);
+		qcvm_string_hash_t **bucket = &vm->string_hashes[hash_value & vm->string_hash_mask];
+		bool found = false;
+#ifdef _DEBUG
+		size_t depth = 1;
+#endif
+
+		// if we already have this string hashed, don't hash us again
+		for (const qcvm_string_hash_t *existing = *bucket; existing; existing = existing->hash_next)
 		{
-			qcvm_definition_hash_t *hashed = &vm->definition_hashes_data[definition - vm->definitions];
-			hashed->def = definition;
-			hashed->hash_value = Q_hash_string(qcvm_get_string(vm, definition->name_index), vm->definitions_size);
-			hashed->hash_next = vm->definition_hashes[hashed->hash_value];
-			vm->definition_hashes[hashed->hash_value] = hashed;
+			if (existing->hash_value == hash_value && vm->string_lengths[existing->str - vm->string_data] == len && !memcmp(existing->str, str, len))
+			{
+				found = true;
+				break;
+			}
+#ifdef _DEBUG
+			depth++;
+#endif
 		}
 
-		vm->definition_map_by_id[definition->global_index] = definition;
+		if (found)
+			continue;
+
+#ifdef _DEBUG
+		if (!*bucket)
+			unique_hash_values++;
+
+		added_hash_values++;
+		max_hash_depth = maxsz(max_hash_depth, depth);
+#endif
+
+		hashed->str = str;
+		hashed->hash_value = hash_value;
+		hashed->hash_next = *bucket;
+		*bucket = hashed++;
 	}
 
-	vm->fields_size = header.sections.field.size;
-	vm->fields = (qcvm_definition_t *)qcvm_alloc(vm, sizeof(qcvm_definition_t) * vm->fields_size);
-	vm->system_fields = (qcvm_system_field_t *)qcvm_alloc(vm, sizeof(qcvm_system_field_t) * vm->fields_size);
+#ifdef _DEBUG
+	load->added_hash_values = added_hash_values;
+	load->unique_hash_values = unique_hash_values;
+	load->max_hash_depth = max_hash_depth;
+#endif
+}
+
+static inline void qcvm_index_symbol(const qcvm_t *vm, qcvm_symbol_t *symbols, uint32_t *buckets, size_t *num_symbols, const qcvm_symbol_kind_t kind, const size_t index, const qcvm_string_t name)
+{
+	if (name == STRING_EMPTY)
+		return;
 
-	fseek(fp, header.sections.field.offset, SEEK_SET);
-	VMLoadDefinitions(vm, fp, vm->fields, &header, vm->fields_size);
+	qcvm_symbol_t *symbol = &symbols[*num_symbols];
+	symbol->hash_value = Q_hash_bytes(qcvm_get_string(vm, name), qcvm_get_string_length(vm, name));
+	symbol->kind = kind;
+	symbol->index = (uint32_t)index;
+	symbol->next = buckets[symbol->hash_value & vm->symbol_mask];
+	buckets[symbol->hash_value & vm->symbol_mask] = (uint32_t)++(*num_symbols);
+}
 
-	vm->field_hashes = (qcvm_definition_hash_t **)qcvm_alloc(vm, sizeof(qcvm_definition_hash_t *) * vm->fields_size);
-	vm->field_hashes_data = (qcvm_definition_hash_t *)qcvm_alloc(vm, sizeof(qcvm_definition_hash_t) * vm->fields_size);
+// returns true if the symbol index still has to be built by qcvm_index_symbols.
+static bool qcvm_alloc_symbols(qcvm_t *vm)
+{
+	size_t symbols_size = 0, buckets_size = 0;
+	const qcvm_symbol_t *cached_symbols = (const qcvm_symbol_t *)qcvm_cache_section(vm, CACHE_SYMBOLS, &symbols_size);
+	const uint32_t *cached_buckets = (const uint32_t *)qcvm_cache_section(vm, CACHE_SYMBOL_BUCKETS, &buckets_size);
 
-	for (qcvm_definition_t *field = vm->fields; field < vm->fields + vm->fields_size; field++)
+	if (cached_symbols && cached_buckets && buckets_size && !((buckets_size / sizeof(uint32_t)) & (buckets_size / sizeof(uint32_t) - 1)))
 	{
-		qcvm_definition_hash_t *hashed = &vm->field_hashes_data[field - vm->fields];
-		hashed->def = field;
-		hashed->hash_value = Q_hash_string(qcvm_get_string(vm, field->name_index), vm->fields_size);
-		hashed->hash_next = vm->field_hashes[hashed->hash_value];
-		vm->field_hashes[hashed->hash_value] = hashed;
+		vm->symbols = cached_symbols;
+		vm->symbols_size = symbols_size / sizeof(qcvm_symbol_t);
+		vm->symbol_buckets = cached_buckets;
+		vm->symbol_mask = (uint32_t)(buckets_size / sizeof(uint32_t) - 1);
+		return false;
 	}
 
-	vm->functions_size = header.sections.function.size;
-	vm->functions = (qcvm_function_t *)qcvm_alloc(vm, sizeof(qcvm_function_t) * vm->functions_size);
+	const size_t max_symbols = vm->definitions_size + vm->fields_size + vm->functions_size;
+	const size_t num_buckets = Q_next_pow2(maxsz(max_symbols, 1));
 
-	fseek(fp, header.sections.function.offset, SEEK_SET);
-	fread(vm->functions, sizeof(qcvm_function_t), vm->functions_size, fp);
-	
-	vm->global_data = (qcvm_global_t *)qcvm_alloc(vm, sizeof(qcvm_global_t) * vm->global_size);
+	vm->symbols = (qcvm_symbol_t *)qcvm_alloc(vm, sizeof(qcvm_symbol_t) * maxsz(max_symbols, 1));
+	vm->symbol_buckets = (uint32_t *)qcvm_alloc(vm, sizeof(uint32_t) * num_buckets);
+	vm->symbol_mask = (uint32_t)(num_buckets - 1);
+	return true;
+}
 
-	fseek(fp, header.sections.globals.offset, SEEK_SET);
-	fread(vm->global_data, sizeof(qcvm_global_t), vm->global_size, fp);
+// build the symbol index; each chain is pushed onto, so the last
+// definition or field with a name is found first. functions go in
+// backwards, so it's the first one for those.
+static void qcvm_index_symbols(qcvm_t *vm)
+{
+	qcvm_symbol_t *symbols = (qcvm_symbol_t *)vm->symbols;
+	uint32_t *buckets = (uint32_t *)vm->symbol_buckets;
+	size_t num_symbols = 0;
 
-	for (qcvm_function_t *func = vm->functions; func < vm->functions + vm->functions_size; func++)
+	for (size_t i = 0; i < vm->definitions_size; i++)
+		qcvm_index_symbol(vm, symbols, buckets, &num_symbols, SYMBOL_DEFINITION, i, vm->definitions[i].name_index);
+
+	for (size_t i = 0; i < vm->fields_size; i++)
+		qcvm_index_symbol(vm, symbols, buckets, &num_symbols, SYMBOL_FIELD, i, vm->fields[i].name_index);
+
+	for (size_t i = vm->functions_size; i; i--)
+		qcvm_index_symbol(vm, symbols, buckets, &num_symbols, SYMBOL_FUNCTION, i - 1, vm->functions[i - 1].name_index);
+
+	vm->symbols_size = num_symbols;
+}
+
+// the tables qcvm_load builds don't depend on each other, only on the sections
+// read before them, so they're built as a couple of rounds of tasks.
+static void qcvm_task_measure_strings(void *data)
+{
+	qcvm_load_state_t *load = (qcvm_load_state_t *)data;
+
+	if (load->measure_strings)
+		qcvm_measure_strings(load->vm);
+}
+
+static void qcvm_task_mark_strings(void *data)
+{
+	qcvm_load_state_t *load = (qcvm_load_state_t *)data;
+
+	if (load->index_strings)
+		load->num_indexed = qcvm_mark_string_refs(load->vm, load->referenced);
+}
+
+static void qcvm_task_check_statements(void *data)
+{
+	qcvm_load_state_t *load = (qcvm_load_state_t *)data;
+	const qcvm_t *vm = load->vm;
+
+	for (const qcvm_statement_t *s = vm->statements; s < vm->statements + vm->statements_size; s++)
 	{
-		if (func->id < 0)
+		if (s->opcode >= OP_NUMOPS || !qcvm_code_funcs[s->opcode])
 		{
-			vm->warning("QCVM WARNING: Code contains old-school negative-indexed builtin \"%s\". Use #0 for all builtins!\n", qcvm_get_string(vm, func->name_index));
-			func->id = 0;
+			load->invalid_statement = s;
+			break;
 		}
-		
-		if (func->id == 0 && func->name_index)
-			vm->builtins.count++;
+	}
+}
 
-		vm->highest_stack = maxsz(vm->highest_stack, func->num_args_and_locals + LOCALS_FIX);
+// qcvm_get_string errors on a bad id, which can't happen on a task thread,
+// so the names qcvm_index_symbols reads are checked up front.
+static inline bool qcvm_check_name(const qcvm_t *vm, qcvm_load_state_t *load, const qcvm_string_t name)
+{
+	if (name >= 0 && (size_t)name < vm->string_size)
+		return true;
 
-		if (func->num_args_and_locals > 128)
-			vm->warning("QCVM WARNING: func \"%s\" has a pretty big stack (%i locals)\n", qcvm_get_string(vm, func->name_index), func->num_args_and_locals);
+	load->invalid_name = true;
+	load->invalid_name_index = name;
+	return false;
+}
+
+static void qcvm_task_check_names(void *data)
+{
+	qcvm_load_state_t *load = (qcvm_load_state_t *)data;
+	const qcvm_t *vm = load->vm;
+
+	if (!load->index_symbols)
+		return;
+
+	for (const qcvm_definition_t *def = vm->definitions; def < vm->definitions + vm->definitions_size; def++)
+		if (!qcvm_check_name(vm, load, def->name_index))
+			return;
+
+	for (const qcvm_definition_t *field = vm->fields; field < vm->fields + vm->fields_size; field++)
+		if (!qcvm_check_name(vm, load, field->name_index))
+			return;
+
+	for (const qcvm_function_t *func = vm->functions; func < vm->functions + vm->functions_size; func++)
+		if (!qcvm_check_name(vm, load, func->name_index))
+			return;
+}
+
+static void qcvm_task_map_definitions(void *data)
+{
+	qcvm_load_state_t *load = (qcvm_load_state_t *)data;
+	qcvm_t *vm = load->vm;
+
+	for (qcvm_definition_t *definition = vm->definitions; definition < vm->definitions + vm->definitions_size; definition++)
+		vm->definition_map_by_id[definition->global_index] = definition;
+}
+
+static void qcvm_task_read_linenumbers(void *data)
+{
+	qcvm_load_state_t *load = (qcvm_load_state_t *)data;
+
+	if (!load->lno)
+		return;
+
+	fread(load->vm->linenumbers, sizeof(int), load->vm->statements_size, load->lno);
+	fclose(load->lno);
+}
+
+static void qcvm_task_index_strings(void *data)
+{
+	qcvm_load_state_t *load = (qcvm_load_state_t *)data;
+
+	if (load->index_strings)
+		qcvm_index_strings(load);
+}
+
+static void qcvm_task_index_symbols(void *data)
+{
+	qcvm_load_state_t *load = (qcvm_load_state_t *)data;
+
+	if (load->index_symbols)
+		qcvm_index_symbols(load->vm);
+}
+
+// run a round of tasks that don't depend on each other; the first one runs
+// on this thread, and the rest get their own if the host can make them.
+static void qcvm_run_tasks(const qcvm_t *vm, const qcvm_task_func_t *tasks, const size_t num_tasks, void *data)
+{
+	enum { MAX_TASK_THREADS = 8 };
+	qcvm_thread_t threads[MAX_TASK_THREADS];
+	size_t num_threads = 0;
+
+	if (vm->tasks.create && vm->tasks.join)
+		for (; num_threads < MAX_TASK_THREADS && num_threads + 1 < num_tasks; num_threads++)
+			threads[num_threads] = vm->tasks.create(tasks[num_threads + 1], data);
+
+	tasks[0](data);
+
+	for (size_t i = num_threads + 1; i < num_tasks; i++)
+		tasks[i](data);
+
+	for (size_t i = 0; i < num_threads; i++)
+		vm->tasks.join(threads[i]);
+}
+
+// a section straight out of the mapped progs, or NULL if the progs isn't mapped
+static void *qcvm_mapped_section(const qcvm_t *vm, const qcvm_offset_t *section, const size_t element_size)
+{
+	const qcvm_mapping_t *mapping = &vm->progs_mapping;
+
+	if (!mapping->data || (section->offset & 3) || section->offset > mapping->size || (uint64_t)section->size * element_size > mapping->size - section->offset)
+		return NULL;
+
+	return (uint8_t *)mapping->data + section->offset;
+}
+
+void qcvm_load(qcvm_t *vm, const char *engine_name, const char *filename)
+{
+	qcvm_init(vm);
+
+	vm->engine_name = engine_name;
+
+	const char *last_slash = strrchr(filename, '\\');
+
+	if (!last_slash)
+		last_slash = strrchr(filename, '/');
+
+	if (!last_slash)
+		vm->path[0] = 0;
+	else
+		strncpy(vm->path, filename, last_slash - filename + 1);
+
+	FILE *fp = fopen(filename, "rb");
+
+	if (!fp)
+		qcvm_error(vm, "no progs.dat");
+
+	qcvm_header_t header;
+
+	fread(&header, sizeof(header), 1, fp);
+
+	if (header.version != PROGS_Q1 && header.version != PROGS_FTE)
+		qcvm_error(vm, "bad version (only version 6 & 7 progs are supported)");
+
+#if ALLOW_PROGS_CACHE
+	if (vm->cache.enabled)
+		qcvm_cache_open(vm, fp, filename);
+#endif
+
+	// 32-bit progs are laid out exactly like the tables, so they can be used in place.
+	// the mapping is copy-on-write, so the pages that are only read stay shared with
+	// every other process that has the same progs mapped.
+	if (vm->map_progs && header.version == PROGS_FTE && header.secondary_version == PROG_SECONDARYVERSION32)
+		qcvm_map_file(filename, true, &vm->progs_mapping);
+
+	vm->global_size = header.sections.globals.size;
+
+	vm->string_size = header.sections.string.size;
+	if (!(vm->string_data = (char *)qcvm_mapped_section(vm, &header.sections.string, sizeof(char))))
+	{
+		vm->string_data = (char *)qcvm_alloc(vm, sizeof(char) * vm->string_size);
+
+		fseek(fp, header.sections.string.offset, SEEK_SET);
+		fread(vm->string_data, sizeof(char), header.sections.string.size, fp);
 	}
 
-	vm->builtins.list = (qcvm_builtin_t *)qcvm_alloc(vm, sizeof(qcvm_builtin_t *) * vm->builtins.count);
+	vm->statements_size = header.sections.statement.size;
+	if (!(vm->statements = (qcvm_statement_t *)qcvm_mapped_section(vm, &header.sections.statement, sizeof(qcvm_statement_t))))
+	{
+		vm->statements = (qcvm_statement_t *)qcvm_alloc(vm, sizeof(qcvm_statement_t) * vm->statements_size);
 
-	qcvm_debug(vm, "QCVM Stack Locals Size: %i bytes\n", vm->highest_stack * 4);
+		fseek(fp, header.sections.statement.offset, SEEK_SET);
+		VMLoadStatements(vm, fp, vm->statements, &header);
+	}
+	
+	vm->definitions_size = header.sections.definition.size;
+	if (!(vm->definitions = (qcvm_definition_t *)qcvm_mapped_section(vm, &header.sections.definition, sizeof(qcvm_definition_t))))
+	{
+		vm->definitions = (qcvm_definition_t *)qcvm_alloc(vm, sizeof(qcvm_definition_t) * vm->definitions_size);
+
+		fseek(fp, header.sections.definition.offset, SEEK_SET);
+		VMLoadDefinitions(vm, fp, vm->definitions, &header, vm->definitions_size);
+	}
+
+	vm->definition_map_by_id = (qcvm_definition_t **)qcvm_alloc(vm, sizeof(qcvm_definition_t) * vm->global_size);
+
+	vm->fields_size = header.sections.field.size;
+	vm->system_fields = (qcvm_system_field_t *)qcvm_alloc(vm, sizeof(qcvm_system_field_t) * vm->fields_size);
+
+	if (!(vm->fields = (qcvm_definition_t *)qcvm_mapped_section(vm, &header.sections.field, sizeof(qcvm_definition_t))))
+	{
+		vm->fields = (qcvm_definition_t *)qcvm_alloc(vm, sizeof(qcvm_definition_t) * vm->fields_size);
+
+		fseek(fp, header.sections.field.offset, SEEK_SET);
+		VMLoadDefinitions(vm, fp, vm->fields, &header, vm->fields_size);
+	}
+
+	vm->functions_size = header.sections.function.size;
+	if (!(vm->functions = (qcvm_function_t *)qcvm_mapped_section(vm, &header.sections.function, sizeof(qcvm_function_t))))
+	{
+		vm->functions = (qcvm_function_t *)qcvm_alloc(vm, sizeof(qcvm_function_t) * vm->functions_size);
+
+		fseek(fp, header.sections.function.offset, SEEK_SET);
+		fread(vm->functions, sizeof(qcvm_function_t), vm->functions_size, fp);
+	}
+	
+	// globals are written to all the time, so they're always copied out
+	vm->global_data = (qcvm_global_t *)qcvm_alloc(vm, sizeof(qcvm_global_t) * vm->global_size);
+
+	const qcvm_global_t *mapped_globals = (const qcvm_global_t *)qcvm_mapped_section(vm, &header.sections.globals, sizeof(qcvm_global_t));
+
+	if (mapped_globals)
+		memcpy(vm->global_data, mapped_globals, sizeof(qcvm_global_t) * vm->global_size);
+	else
+	{
+		fseek(fp, header.sections.globals.offset, SEEK_SET);
+		fread(vm->global_data, sizeof(qcvm_global_t), vm->global_size, fp);
+	}
 
 	fclose(fp);
 
+	qcvm_load_state_t load = { .vm = vm };
+
 	// Check for debugging info
 	fp = fopen(qcvm_temp_format(vm, "%sprogs.lno", vm->path), "rb");
 
@@ -1376,12 +1781,75 @@ void qcvm_load(qcvm_t *vm, const char *engine_name, const char *filename)
 			(size_t)lno_header.numstatements == header.sections.statement.size)
 		{
 			vm->linenumbers = (int *)qcvm_alloc(vm, sizeof(*vm->linenumbers) * header.sections.statement.size);
-			fread(vm->linenumbers, sizeof(int), header.sections.statement.size, fp);
+			load.lno = fp;
 		}
+		else
+			fclose(fp);
+	}
 
-		fclose(fp);
+	// everything the tasks write to is allocated here
+	load.measure_strings = qcvm_alloc_string_measures(vm);
+	load.index_strings = !qcvm_load_cached_strings(vm);
+	load.index_symbols = qcvm_alloc_symbols(vm);
+
+	if (load.index_strings)
+		load.referenced = (bool *)qcvm_alloc(vm, sizeof(bool) * vm->string_size);
+
+	static const qcvm_task_func_t scan_tasks[] = {
+		qcvm_task_measure_strings,
+		qcvm_task_mark_strings,
+		qcvm_task_check_statements,
+		qcvm_task_check_names,
+		qcvm_task_map_definitions,
+		qcvm_task_read_linenumbers
+	};
+
+	qcvm_run_tasks(vm, scan_tasks, sizeof(scan_tasks) / sizeof(*scan_tasks), &load);
+
+	if (load.invalid_statement)
+		qcvm_error(vm, "opcode invalid or not implemented: %i\n", load.invalid_statement->opcode);
+	else if (load.invalid_name)
+		qcvm_error(vm, "bad symbol name: %i\n", load.invalid_name_index);
+
+	if (load.index_strings)
+		qcvm_alloc_string_hashes(vm, load.num_indexed);
+
+	// both of these need the string lengths
+	static const qcvm_task_func_t index_tasks[] = {
+		qcvm_task_index_strings,
+		qcvm_task_index_symbols
+	};
+
+	qcvm_run_tasks(vm, index_tasks, sizeof(index_tasks) / sizeof(*index_tasks), &load);
+
+	if (load.index_strings)
+	{
+		qcvm_mem_free(vm, load.referenced);
+
+		qcvm_debug(vm, "String hash table: %u added, %u unique, %u max depth, %u strings total\n", load.added_hash_values, load.unique_hash_values, load.max_hash_depth, vm->string_size);
+	}
+
+	for (qcvm_function_t *func = vm->functions; func < vm->functions + vm->functions_size; func++)
+	{
+		if (func->id < 0)
+		{
+			vm->warning("QCVM WARNING: Code contains old-school negative-indexed builtin \"%s\". Use #0 for all builtins!\n", qcvm_get_string(vm, func->name_index));
+			func->id = 0;
+		}
+		
+		if (func->id == 0 && func->name_index)
+			vm->builtins.count++;
+
+		vm->highest_stack = maxsz(vm->highest_stack, func->num_args_and_locals + LOCALS_FIX);
+
+		if (func->num_args_and_locals > 128)
+			vm->warning("QCVM WARNING: func \"%s\" has a pretty big stack (%i locals)\n", qcvm_get_string(vm, func->name_index), func->num_args_and_locals);
 	}
 
+	vm->builtins.list = (qcvm_builtin_t *)qcvm_alloc(vm, sizeof(qcvm_builtin_t *) * vm->builtins.count);
+
+	qcvm_debug(vm, "QCVM Stack Locals Size: %i bytes\n", vm->highest_stack * 4);
+
 #if ALLOW_INSTRUMENTING
 	vm->profiling.instrumentation.data = (qcvm_profile_t *)qcvm_alloc(vm, sizeof(qcvm_profile_t) * vm->functions_size);
 #endif
@@ -1499,6 +1967,33 @@ static inline void qcvm_setup_fields(qcvm_t *vm)
 	}
 }
 
+// restores what qcvm_setup_fields & qcvm_init_field_map did from the cache, if it has it
+static bool qcvm_load_cached_fields(qcvm_t *vm)
+{
+	size_t fields_size = 0, globals_size = 0, map_size = 0;
+	const qcvm_definition_t *fields = (const qcvm_definition_t *)qcvm_cache_section(vm, CACHE_FIELDS, &fields_size);
+	const qcvm_cache_global_t *globals = (const qcvm_cache_global_t *)qcvm_cache_section(vm, CACHE_FIELD_GLOBALS, &globals_size);
+	const uint32_t *map = (const uint32_t *)qcvm_cache_section(vm, CACHE_FIELD_MAP, &map_size);
+
+	if (!fields || !globals || !map || fields_size != sizeof(qcvm_definition_t) * vm->fields_size)
+		return false;
+
+	memcpy(vm->fields, fields, fields_size);
+
+	for (const qcvm_cache_global_t *global = globals; global < globals + globals_size / sizeof(*globals); global++)
+		if (global->global < vm->global_size)
+			vm->global_data[global->global] = global->value;
+
+	vm->field_real_size = map_size / sizeof(uint32_t);
+	vm->field_map_by_id = (qcvm_definition_t **)qcvm_alloc(vm, sizeof(qcvm_definition_t *) * maxsz(vm->field_real_size, 1));
+
+	for (size_t i = 0; i < vm->field_real_size; i++)
+		if (map[i] && map[i] < vm->fields_size)
+			vm->field_map_by_id[i] = vm->fields + map[i];
+
+	return true;
+}
+
 static inline void qcvm_init_field_map(qcvm_t *vm)
 {
 	for (qcvm_definition_t *field = vm->fields + 1; field < vm->fields + vm->fields_size; field++)
@@ -1525,33 +2020,1031 @@ static inline void qcvm_check_builtins(qcvm_t *vm)
 	for (qcvm_function_t *func = vm->functions; func < vm->functions + vm->functions_size; func++)
 		if (func->id == 0 && func->name_index != STRING_EMPTY)
 			vm->warning("Missing builtin function: %s\n", qcvm_get_string(vm, func->name_index));
+}
+
+static inline void qcvm_setup_intrinsics(qcvm_t *vm)
+{
+	const qcvm_func_t sqrt_id = qcvm_find_function_id(vm, "sqrt");
+	const qcvm_func_t sin_id = qcvm_find_function_id(vm, "sin");
+	const qcvm_func_t cos_id = qcvm_find_function_id(vm, "cos");
 
-	// Set up intrinsics
 	for (qcvm_statement_t *s = vm->statements; s < vm->statements + vm->statements_size; s++)
 	{
 		if (s->opcode == OP_CALL1H)
 		{
 			qcvm_func_t f = *(vm->global_data + s->args.a);
 
-			if (f == qcvm_find_function_id(vm, "sqrt"))
+			if (f == sqrt_id)
 				s->opcode = OP_INTRIN_SQRT;
-			if (f == qcvm_find_function_id(vm, "sin"))
+			if (f == sin_id)
 				s->opcode = OP_INTRIN_SIN;
-			if (f == qcvm_find_function_id(vm, "cos"))
+			if (f == cos_id)
 				s->opcode = OP_INTRIN_COS;
 		}
 	}
 }
 
-void qcvm_check(qcvm_t *vm)
+typedef struct
 {
-	qcvm_setup_fields(vm);
-	
-	qcvm_init_field_map(vm);
-	
-	qcvm_field_wrap_list_init(vm);
+	qcvm_opcode_t	first, second, fused;
+} qcvm_fusion_t;
+
+static const qcvm_fusion_t qcvm_fusions[] = {
+	{ OP_LOAD_F, OP_STORE_F, OP_FUSE_LOAD_F_STORE_F },
+	{ OP_EQ_F, OP_IFNOT_I, OP_FUSE_EQ_F_IFNOT_I },
+	{ OP_NE_F, OP_IFNOT_I, OP_FUSE_NE_F_IFNOT_I },
+	{ OP_ADDRESS, OP_STOREP_F, OP_FUSE_ADDRESS_STOREP_F },
+	{ OP_MUL_VF, OP_ADD_V, OP_FUSE_MUL_VF_ADD_V }
+};
 
-	qcvm_check_builtins(vm);
+enum { NUM_FUSIONS = sizeof(qcvm_fusions) / sizeof(*qcvm_fusions) };
+
+// peephole pass that merges common statement pairs into one dispatch.
+// the second statement isn't touched, so jump offsets stay valid.
+static inline void qcvm_fuse_statements(qcvm_t *vm)
+{
+	size_t hits[NUM_FUSIONS] = { 0 };
+
+	for (size_t i = 0; i + 1 < vm->statements_size; i++)
+	{
+		// don't swallow the first statement of a line, breakpoints & stepping need it
+		if (vm->linenumbers && vm->linenumbers[i] != vm->linenumbers[i + 1])
+			continue;
+
+		qcvm_statement_t *s = vm->statements + i;
+
+		for (size_t f = 0; f < NUM_FUSIONS; f++)
+		{
+			if (s[0].opcode != qcvm_fusions[f].first || s[1].opcode != qcvm_fusions[f].second)
+				continue;
+
+			s->opcode = qcvm_fusions[f].fused;
+			hits[f]++;
+			i++;
+			break;
+		}
+	}
+
+	for (size_t f = 0; f < NUM_FUSIONS; f++)
+		if (hits[f])
+			qcvm_debug(vm, "QCVM: fused %zu %s\n", hits[f], opcode_names[qcvm_fusions[f].fused]);
+}
+
+static inline bool qcvm_opcode_addresses_globals(const qcvm_opcode_t code)
+{
+	return code == OP_GLOBALADDRESS || (code >= OP_LOADA_F && code <= OP_LOADA_I);
+}
+
+typedef struct
+{
+	qcvm_opcode_t	checked, unchecked;
+	size_t			span;
+} qcvm_unchecked_store_t;
+
+static const qcvm_unchecked_store_t qcvm_unchecked_stores[] = {
+	{ OP_STORE_F, OP_UNCHECKED_STORE_F, 1 },
+	{ OP_STORE_V, OP_UNCHECKED_STORE_V, 3 },
+	{ OP_STORE_ENT, OP_UNCHECKED_STORE_ENT, 1 },
+	{ OP_STORE_FLD, OP_UNCHECKED_STORE_FLD, 1 },
+	{ OP_STORE_FNC, OP_UNCHECKED_STORE_FNC, 1 },
+	{ OP_STORE_I, OP_UNCHECKED_STORE_I, 1 }
+};
+
+enum { NUM_UNCHECKED_STORES = sizeof(qcvm_unchecked_stores) / sizeof(*qcvm_unchecked_stores) };
+
+#if ALLOW_PROGS_CACHE
+uint64_t qcvm_cache_build_key(uint64_t hash)
+{
+	static const char build[] = __DATE__ " " __TIME__;
+	const uint32_t constants[] = { OP_NUMOPS, NUM_FUSIONS, NUM_UNCHECKED_STORES, STRING_FOLD_HASH_SEED };
+
+	hash = qcvm_cache_hash(hash, build, sizeof(build));
+	hash = qcvm_cache_hash(hash, constants, sizeof(constants));
+
+	for (size_t i = 0; i < NUM_FUSIONS; i++)
+	{
+		const uint32_t values[] = { qcvm_fusions[i].first, qcvm_fusions[i].second, qcvm_fusions[i].fused };
+		hash = qcvm_cache_hash(hash, values, sizeof(values));
+	}
+
+	for (size_t i = 0; i < NUM_UNCHECKED_STORES; i++)
+	{
+		const uint32_t values[] = { qcvm_unchecked_stores[i].checked, qcvm_unchecked_stores[i].unchecked, (uint32_t)qcvm_unchecked_stores[i].span };
+		hash = qcvm_cache_hash(hash, values, sizeof(values));
+	}
+
+	return hash;
+}
+#endif
+
+enum
+{
+	SLOT_UNKNOWN,	// no definition covers it
+	SLOT_NUMERIC,	// only number-like definitions cover it, or it's a constant
+	SLOT_REFS		// may hold a string ref at some point
+};
+
+// stores that write to b rather than c
+static inline bool qcvm_opcode_stores_to_b(const qcvm_opcode_t code)
+{
+	switch (code)
+	{
+	case OP_STORE_F:
+	case OP_STORE_V:
+	case OP_STORE_S:
+	case OP_STORE_ENT:
+	case OP_STORE_FLD:
+	case OP_STORE_FNC:
+	case OP_STORE_I:
+	case OP_STORE_IF:
+	case OP_STORE_FI:
+	case OP_STORE_P:
+	case OP_MULSTORE_F:
+	case OP_MULSTORE_VF:
+	case OP_DIVSTORE_F:
+	case OP_ADDSTORE_F:
+	case OP_ADDSTORE_V:
+	case OP_SUBSTORE_F:
+	case OP_SUBSTORE_V:
+	case OP_BITSETSTORE_F:
+	case OP_BITCLRSTORE_F:
+		return true;
+	}
+
+	return false;
+}
+
+static inline bool qcvm_type_is_numeric(const qcvm_deftype_t type)
+{
+	switch (type & ~TYPE_GLOBAL)
+	{
+	case TYPE_FLOAT:
+	case TYPE_VECTOR:
+	case TYPE_ENTITY:
+	case TYPE_FIELD:
+	case TYPE_FUNCTION:
+	case TYPE_INTEGER:
+		return true;
+	}
+
+	return false;
+}
+
+static inline void qcvm_mark_slots(const qcvm_t *vm, uint8_t *slots, const qcvm_global_t global, const size_t span, bool *changed)
+{
+	for (size_t i = 0; i < span && global + i < vm->global_size; i++)
+	{
+		if (slots[global + i] != SLOT_REFS)
+		{
+			slots[global + i] = SLOT_REFS;
+
+			if (changed)
+				*changed = true;
+		}
+	}
+}
+
+static inline bool qcvm_slots_numeric(const qcvm_t *vm, const uint8_t *slots, const qcvm_global_t global, const size_t span)
+{
+	if (!global || global + span > vm->global_size)
+		return false;
+
+	for (size_t i = 0; i < span; i++)
+		if (slots[global + i] != SLOT_NUMERIC)
+			return false;
+
+	return true;
+}
+
+// a global only ever holds a string ref if one is copied into it, and a plain
+// store's destination is never in an entity. so, a store between two globals
+// that are only ever numbers can skip both the ref & the field wrap checks;
+// find those and switch them over to the unchecked stores.
+static void qcvm_classify_stores(qcvm_t *vm)
+{
+	uint8_t *slots = (uint8_t *)qcvm_alloc(vm, sizeof(uint8_t) * vm->global_size);
+
+	// if locals overlap, every definition of a slot has to agree
+	for (const qcvm_definition_t *def = vm->definitions; def < vm->definitions + vm->definitions_size; def++)
+	{
+		if (!qcvm_type_is_numeric(def->id))
+		{
+			qcvm_mark_slots(vm, slots, def->global_index, qcvm_type_span(def->id), NULL);
+			continue;
+		}
+
+		for (size_t i = 0; i < qcvm_type_span(def->id) && def->global_index + i < vm->global_size; i++)
+			if (slots[def->global_index + i] == SLOT_UNKNOWN)
+				slots[def->global_index + i] = SLOT_NUMERIC;
+	}
+
+	// calls pass anything through these
+	qcvm_mark_slots(vm, slots, 0, GLOBAL_QC, NULL);
+
+	// arguments are copied in by calls, and locals can be temps
+	for (const qcvm_function_t *func = vm->functions; func < vm->functions + vm->functions_size; func++)
+		if (func->id > 0)
+			for (size_t i = 0; i < func->num_args_and_locals && func->first_arg + i < vm->global_size; i++)
+				if (slots[func->first_arg + i] == SLOT_UNKNOWN)
+					slots[func->first_arg + i] = SLOT_REFS;
+
+	for (const qcvm_statement_t *s = vm->statements; s < vm->statements + vm->statements_size; s++)
+	{
+		const qcvm_opcode_t code = qcvm_unfused_opcode(s->opcode);
+		const qcvm_global_t dst = qcvm_opcode_stores_to_b(code) ? s->args.b : s->args.c;
+		const size_t span = (code == OP_STORE_V || code == OP_ADDSTORE_V || code == OP_SUBSTORE_V || code == OP_MULSTORE_VF) ? 3 : 1;
+
+		// temps don't have a definition, and could be holding anything
+		for (size_t i = 0; i < span && dst + i < vm->global_size; i++)
+			if (slots[dst + i] == SLOT_UNKNOWN)
+				slots[dst + i] = SLOT_REFS;
+
+		// can be written to through a pointer
+		if (qcvm_opcode_addresses_globals(code))
+			qcvm_mark_slots(vm, slots, s->args.a, 1, NULL);
+
+		switch (code)
+		{
+		case OP_STORE_S:
+			qcvm_mark_slots(vm, slots, s->args.b, 1, NULL);
+			break;
+		case OP_LOAD_S:
+		case OP_LOADA_S:
+		case OP_LOADP_S:
+		case OP_GLOAD_S:
+		case OP_FETCH_GBL_S:
+		case OP_ADD_SF:
+		case OP_SUB_S:
+			qcvm_mark_slots(vm, slots, s->args.c, 1, NULL);
+			break;
+		}
+	}
+
+	// whatever's left is never written to, so it's a constant
+	for (size_t i = 0; i < vm->global_size; i++)
+		if (slots[i] == SLOT_UNKNOWN)
+			slots[i] = SLOT_NUMERIC;
+
+	// refs follow copies, including ones the compiler typed as something else
+	for (bool changed = true; changed; )
+	{
+		changed = false;
+
+		for (const qcvm_statement_t *s = vm->statements; s < vm->statements + vm->statements_size; s++)
+		{
+			const qcvm_opcode_t code = qcvm_unfused_opcode(s->opcode);
+			const size_t span = (code == OP_STORE_V) ? 3 : 1;
+
+			if ((code >= OP_STORE_F && code <= OP_STORE_FNC) || code == OP_STORE_I || code == OP_STORE_IF || code == OP_STORE_FI || code == OP_STORE_P)
+				if (!qcvm_slots_numeric(vm, slots, s->args.a, span))
+					qcvm_mark_slots(vm, slots, s->args.b, span, &changed);
+		}
+	}
+
+	size_t num_unchecked = 0;
+
+	for (qcvm_statement_t *s = vm->statements; s < vm->statements + vm->statements_size; s++)
+	{
+		for (size_t i = 0; i < NUM_UNCHECKED_STORES; i++)
+		{
+			const qcvm_unchecked_store_t *store = &qcvm_unchecked_stores[i];
+
+			if (s->opcode != store->checked)
+				continue;
+
+			if (qcvm_slots_numeric(vm, slots, s->args.a, store->span) && qcvm_slots_numeric(vm, slots, s->args.b, store->span))
+			{
+				s->opcode = store->unchecked;
+				num_unchecked++;
+			}
+
+			break;
+		}
+	}
+
+	qcvm_mem_free(vm, slots);
+
+	qcvm_debug(vm, "QCVM: %zu unchecked stores\n", num_unchecked);
+}
+
+// entity stores that go through the wrap check, and how much they write;
+// the pointer (or field, for STOREF) they write through is in b.
+static size_t qcvm_wrapped_store_span(const qcvm_opcode_t code)
+{
+	switch (code)
+	{
+	case OP_STOREP_F:
+	case OP_STOREP_S:
+	case OP_STOREP_ENT:
+	case OP_STOREP_FLD:
+	case OP_STOREP_FNC:
+	case OP_STOREP_I:
+	case OP_STOREP_IF:
+	case OP_STOREP_FI:
+	case OP_MULSTOREP_F:
+	case OP_DIVSTOREP_F:
+	case OP_ADDSTOREP_F:
+	case OP_SUBSTOREP_F:
+	case OP_STOREF_F:
+	case OP_STOREF_S:
+	case OP_STOREF_I:
+		return 1;
+	case OP_STOREP_V:
+	case OP_MULSTOREP_VF:
+	case OP_ADDSTOREP_V:
+	case OP_SUBSTOREP_V:
+	case OP_STOREF_V:
+		return 3;
+	}
+
+	return 0;
+}
+
+// the value of a global that nothing writes to after loading, if it is one.
+// nothing can write to 0, so unused operands count too.
+static inline bool qcvm_constant_global(const qcvm_t *vm, const uint8_t *written, const qcvm_global_t global, int32_t *value)
+{
+	if (global >= vm->global_size || (global != GLOBAL_NULL && written[global]))
+		return false;
+
+	*value = *(const int32_t *)(vm->global_data + global);
+	return true;
+}
+
+// stores to globals never land in an entity so they never need the wrap check,
+// but ones through pointers & fields might. most of those write to a field
+// that's named right there, either directly (STOREF) or through the
+// pointer ADDRESS made in the statement before, so if that field isn't
+// wrapped they can skip it too.
+void qcvm_field_wrap_list_tag_stores(qcvm_t *vm)
+{
+	uint8_t *written = (uint8_t *)qcvm_alloc(vm, sizeof(uint8_t) * vm->global_size);
+	uint8_t *targets = (uint8_t *)qcvm_alloc(vm, sizeof(uint8_t) * vm->statements_size);
+	size_t num_tagged = 0, num_stores = 0;
+
+	// calls write to these, and arguments are copied in to locals
+	memset(written, 1, minsz(GLOBAL_QC, vm->global_size));
+
+	for (const qcvm_function_t *func = vm->functions; func < vm->functions + vm->functions_size; func++)
+	{
+		if (func->id <= 0)
+			continue;
+
+		if ((size_t)func->id < vm->statements_size)
+			targets[func->id] = true;
+
+		for (size_t i = 0; i < func->num_args_and_locals && func->first_arg + i < vm->global_size; i++)
+			written[func->first_arg + i] = true;
+	}
+
+	for (size_t i = 0; i < vm->statements_size; i++)
+	{
+		const qcvm_statement_t *s = &vm->statements[i];
+		const qcvm_opcode_t code = qcvm_unfused_opcode(s->opcode & ~OP_BREAKPOINT);
+		const qcvm_global_t dst = qcvm_opcode_stores_to_b(code) ? s->args.b : s->args.c;
+
+		// anything that could be a destination, vectors included
+		for (size_t g = 0; g < 3 && dst + g < vm->global_size; g++)
+			written[dst + g] = true;
+
+		if (qcvm_opcode_addresses_globals(code) && s->args.a < vm->global_size)
+			written[s->args.a] = true;
+
+		if (code == OP_GOTO || qcvm_opcode_is_branch(code))
+		{
+			const int64_t target = (int64_t)i + qcvm_branch_offset(code, s->args);
+
+			if (target >= 0 && target < (int64_t)vm->statements_size)
+				targets[target] = true;
+		}
+	}
+
+	for (size_t i = 0; i < vm->statements_size; i++)
+	{
+		qcvm_decoded_statement_t *s = &vm->decoded_statements[i];
+		const qcvm_opcode_t code = qcvm_unfused_opcode(s->opcode);
+		const size_t span = qcvm_wrapped_store_span(code);
+
+		s->skip_wraps = false;
+
+		if (!span)
+			continue;
+
+		num_stores++;
+
+		int32_t field, offset = 0;
+
+		if (code >= OP_STOREF_V && code <= OP_STOREF_I)
+		{
+			if (!qcvm_constant_global(vm, written, s->args.b, &field))
+				continue;
+		}
+		else
+		{
+			// the pointer has to come from the statement before, with no way to jump in between
+			if (!i || targets[i])
+				continue;
+
+			const qcvm_decoded_statement_t *address = &vm->decoded_statements[i - 1];
+
+			if (qcvm_unfused_opcode(address->opcode) != OP_ADDRESS || address->args.c != s->args.b)
+				continue;
+			else if (!qcvm_constant_global(vm, written, address->args.b, &field))
+				continue;
+			else if ((code >= OP_STOREP_F && code <= OP_STOREP_FNC) || (code >= OP_STOREP_I && code <= OP_STOREP_FI))
+				if (!qcvm_constant_global(vm, written, s->args.c, &offset))
+					continue;
+		}
+
+		const int64_t start = (int64_t)field + offset;
+
+		if (start < 0 || start + span > vm->field_real_size)
+			continue;
+
+		bool wrapped = false;
+
+		for (size_t f = 0; f < span; f++)
+			wrapped = wrapped || qcvm_field_is_wrapped(vm, (size_t)start + f);
+
+		if (!wrapped)
+		{
+			s->skip_wraps = true;
+			num_tagged++;
+		}
+	}
+
+	qcvm_mem_free(vm, targets);
+	qcvm_mem_free(vm, written);
+
+	qcvm_debug(vm, "QCVM: %zu/%zu entity stores skip field wraps\n", num_tagged, num_stores);
+}
+
+qcvm_opcode_t qcvm_unfused_opcode(const qcvm_opcode_t code)
+{
+	for (size_t f = 0; f < NUM_FUSIONS; f++)
+		if (qcvm_fusions[f].fused == code)
+			return qcvm_fusions[f].first;
+
+	for (size_t i = 0; i < NUM_UNCHECKED_STORES; i++)
+		if (qcvm_unchecked_stores[i].unchecked == code)
+			return qcvm_unchecked_stores[i].checked;
+
+	return code;
+}
+
+bool qcvm_opcode_is_unchecked_store(const qcvm_opcode_t code)
+{
+	return code >= OP_UNCHECKED_STORE_F && code <= OP_UNCHECKED_STORE_I;
+}
+
+bool qcvm_opcode_is_branch(const qcvm_opcode_t code)
+{
+	switch (code)
+	{
+	case OP_IF_I:
+	case OP_IFNOT_I:
+	case OP_IF_F:
+	case OP_IFNOT_F:
+	case OP_IF_S:
+	case OP_IFNOT_S:
+		return true;
+	}
+
+	return false;
+}
+
+int32_t qcvm_branch_offset(const qcvm_opcode_t code, const qcvm_operands_t args)
+{
+	return (int16_t)(code == OP_GOTO ? args.a : args.b);
+}
+
+enum { PENDING_RESERVE = 64, CALLEES_RESERVE = 256 };
+
+bool qcvm_find_reachable(qcvm_t *vm, const size_t entry, uint8_t *reachable, size_t *first, size_t *last, const size_t max_statements)
+{
+	size_t pending_allocated = PENDING_RESERVE;
+	size_t *pending = (size_t *)qcvm_alloc(vm, sizeof(size_t) * pending_allocated);
+	size_t pending_size = 0, total = 0;
+	bool valid = entry > 0 && entry < vm->statements_size;
+
+	if (valid)
+	{
+		*first = *last = entry;
+		pending[pending_size++] = entry;
+		reachable[entry] = true;
+	}
+
+	while (valid && pending_size)
+	{
+		const size_t index = pending[--pending_size];
+		const qcvm_statement_t *s = &vm->statements[index];
+		const qcvm_opcode_t code = qcvm_unfused_opcode(s->opcode & ~OP_BREAKPOINT);
+		int64_t next[2];
+		size_t num_next = 0;
+
+		if (code == OP_GOTO)
+			next[num_next++] = (int64_t)index + qcvm_branch_offset(code, s->args);
+		else if (code != OP_DONE && code != OP_RETURN)
+		{
+			next[num_next++] = (int64_t)index + 1;
+
+			if (qcvm_opcode_is_branch(code))
+				next[num_next++] = (int64_t)index + qcvm_branch_offset(code, s->args);
+		}
+
+		for (size_t i = 0; i < num_next; i++)
+		{
+			if (next[i] <= 0 || next[i] >= (int64_t)vm->statements_size)
+			{
+				valid = false;
+				break;
+			}
+
+			const size_t target = (size_t)next[i];
+
+			if (reachable[target])
+				continue;
+			else if (++total >= max_statements)
+			{
+				valid = false;
+				break;
+			}
+
+			if (pending_size == pending_allocated)
+			{
+				size_t *old_pending = pending;
+				pending = (size_t *)qcvm_alloc(vm, sizeof(size_t) * pending_allocated * 2);
+				memcpy(pending, old_pending, sizeof(size_t) * pending_size);
+				qcvm_mem_free(vm, old_pending);
+				pending_allocated *= 2;
+			}
+
+			reachable[target] = true;
+			pending[pending_size++] = target;
+			*first = minsz(*first, target);
+			*last = maxsz(*last, target);
+		}
+	}
+
+	qcvm_mem_free(vm, pending);
+	return valid;
+}
+
+bool qcvm_run_statement(qcvm_t *vm, const size_t index)
+{
+	const qcvm_decoded_statement_t *operands = &vm->decoded_statements[index];
+	const qcvm_statement_t *statement = &vm->statements[index];
+	int depth = 0;
+
+	vm->state.stack[vm->state.current].statement = statement;
+	qcvm_code_funcs[qcvm_unfused_opcode(operands->opcode)](vm, operands, &depth);
+
+	// entered a function that has no native code, so interpret it from here
+	if (depth > 0)
+	{
+		qcvm_interpret(vm, depth);
+		return false;
+	}
+	// left the function; the stack entry is gone
+	else if (depth < 0)
+		return false;
+
+	return vm->state.stack[vm->state.current].statement != statement;
+}
+
+// which args of a statement are globals; the rest are immediates
+// (jump offsets, BOUNDCHECK's bounds) and are never decoded or windowed.
+enum
+{
+	OPERAND_A	= 1 << 0,
+	OPERAND_B	= 1 << 1,
+	OPERAND_C	= 1 << 2
+};
+
+static inline uint8_t qcvm_global_operands(const qcvm_opcode_t opcode)
+{
+	const qcvm_opcode_t code = qcvm_unfused_opcode(opcode);
+
+	if (code == OP_GOTO)
+		return 0;
+	else if (code == OP_BOUNDCHECK || qcvm_opcode_is_branch(code))
+		return OPERAND_A;
+
+	return OPERAND_A | OPERAND_B | OPERAND_C;
+}
+
+static inline qcvm_global_t *qcvm_decode_operand(qcvm_t *vm, const uint8_t globals, const uint8_t which, const qcvm_global_t operand)
+{
+	if (!(globals & which) || operand >= vm->global_size)
+		return NULL;
+
+	return vm->global_data + operand;
+}
+
+// must run after anything that rewrites statements
+static inline void qcvm_decode_statements(qcvm_t *vm)
+{
+	vm->decoded_statements = (qcvm_decoded_statement_t *)qcvm_alloc(vm, sizeof(qcvm_decoded_statement_t) * vm->statements_size);
+
+	for (size_t i = 0; i < vm->statements_size; i++)
+	{
+		const qcvm_statement_t *s = vm->statements + i;
+		const qcvm_opcode_t code = s->opcode & ~OP_BREAKPOINT;
+		const uint8_t globals = qcvm_global_operands(code);
+
+		vm->decoded_statements[i] = (qcvm_decoded_statement_t) {
+			.handler = qcvm_code_funcs[code],
+			.a = qcvm_decode_operand(vm, globals, OPERAND_A, s->args.a),
+			.b = qcvm_decode_operand(vm, globals, OPERAND_B, s->args.b),
+			.c = qcvm_decode_operand(vm, globals, OPERAND_C, s->args.c),
+			.args = s->args,
+			.opcode = code
+		};
+	}
+}
+
+// statements that index global_data directly rather than going through their operands
+static inline bool qcvm_global_in_range(const qcvm_global_t global, const qcvm_global_t start, const qcvm_global_t end)
+{
+	return global >= start && global < end;
+}
+
+static inline bool qcvm_operands_in_range(const qcvm_decoded_statement_t *s, const qcvm_global_t start, const qcvm_global_t end)
+{
+	const uint8_t globals = qcvm_global_operands(s->opcode);
+
+	return ((globals & OPERAND_A) && qcvm_global_in_range(s->args.a, start, end)) ||
+		((globals & OPERAND_B) && qcvm_global_in_range(s->args.b, start, end)) ||
+		((globals & OPERAND_C) && qcvm_global_in_range(s->args.c, start, end));
+}
+
+// Functions whose locals can be windowed keep them in a frame on vm->state.frames
+// instead of in global_data, so calling one is just a bump of the frame stack rather
+// than saving & restoring whatever the callee is about to overwrite. Anything that
+// takes the address of a local, or touches the slots past its declared locals (which
+// LOCALS_FIX covers for), keeps the old behavior.
+static void qcvm_window_locals(qcvm_t *vm)
+{
+	vm->frame_sizes = (uint32_t *)qcvm_alloc(vm, sizeof(uint32_t) * vm->functions_size);
+	// RETURN & calls always copy three slots, so the last frame gets the same
+	// slack past its locals that LOCALS_FIX gives them in global_data
+	vm->state.frames = (qcvm_global_t *)qcvm_alloc(vm, sizeof(qcvm_global_t) * (FRAME_STACK_SIZE + LOCALS_FIX));
+	vm->state.frames_allocated = FRAME_STACK_SIZE;
+
+	size_t cached_sizes_size = 0, cached_flags_size = 0;
+	const uint32_t *cached_sizes = (const uint32_t *)qcvm_cache_section(vm, CACHE_FRAME_SIZES, &cached_sizes_size);
+	const uint8_t *cached_flags = (const uint8_t *)qcvm_cache_section(vm, CACHE_FRAME_FLAGS, &cached_flags_size);
+
+	if (cached_sizes && cached_flags && cached_sizes_size == sizeof(uint32_t) * vm->functions_size && cached_flags_size == vm->statements_size)
+	{
+		memcpy(vm->frame_sizes, cached_sizes, cached_sizes_size);
+
+		for (size_t i = 0; i < vm->statements_size; i++)
+		{
+			qcvm_decoded_statement_t *s = &vm->decoded_statements[i];
+			s->frame_a = !!(cached_flags[i] & CACHE_FRAME_A);
+			s->frame_b = !!(cached_flags[i] & CACHE_FRAME_B);
+			s->frame_c = !!(cached_flags[i] & CACHE_FRAME_C);
+		}
+
+		return;
+	}
+
+	uint8_t *reachable = (uint8_t *)qcvm_alloc(vm, vm->statements_size);
+	size_t num_windowed = 0, num_functions = 0;
+
+	for (qcvm_function_t *func = vm->functions; func < vm->functions + vm->functions_size; func++)
+	{
+		if (func->id <= 0 || !func->num_args_and_locals)
+			continue;
+
+		const qcvm_global_t locals_start = func->first_arg, locals_end = func->first_arg + func->num_args_and_locals;
+		size_t first = 0, last = 0;
+		bool windowed = qcvm_find_reachable(vm, (size_t)func->id, reachable, &first, &last, vm->statements_size);
+
+		num_functions++;
+
+		for (size_t i = first; windowed && i <= last; i++)
+		{
+			if (!reachable[i])
+				continue;
+
+			const qcvm_decoded_statement_t *s = &vm->decoded_statements[i];
+
+			if (qcvm_opcode_addresses_globals(qcvm_unfused_opcode(s->opcode)) && qcvm_global_in_range(s->args.a, locals_start, locals_end + LOCALS_FIX))
+				windowed = false;
+			else if (qcvm_operands_in_range(s, locals_end, locals_end + LOCALS_FIX))
+				windowed = false;
+		}
+
+		if (windowed)
+		{
+			vm->frame_sizes[func - vm->functions] = func->num_args_and_locals;
+			num_windowed++;
+
+			for (size_t i = first; i <= last; i++)
+			{
+				if (!reachable[i])
+					continue;
+
+				qcvm_decoded_statement_t *s = &vm->decoded_statements[i];
+				s->frame_a = s->a && qcvm_global_in_range(s->args.a, locals_start, locals_end);
+				s->frame_b = s->b && qcvm_global_in_range(s->args.b, locals_start, locals_end);
+				s->frame_c = s->c && qcvm_global_in_range(s->args.c, locals_start, locals_end);
+			}
+		}
+
+		memset(reachable + first, 0, last - first + 1);
+	}
+
+	qcvm_mem_free(vm, reachable);
+
+	qcvm_debug(vm, "QCVM: windowed locals of %zu/%zu functions\n", num_windowed, num_functions);
+}
+
+static inline bool qcvm_opcode_is_call(const qcvm_opcode_t code)
+{
+	return (code >= OP_CALL0 && code <= OP_CALL8) || (code >= OP_CALL1H && code <= OP_CALL8H);
+}
+
+// the function a call always goes to, or 0 if it's through a variable. a global
+// holding a function that has the same name as the function is its constant,
+// which the compiler won't let anything assign to.
+static qcvm_func_t qcvm_direct_call_target(const qcvm_t *vm, const qcvm_global_t operand)
+{
+	const qcvm_definition_t *def = operand < vm->global_size ? vm->definition_map_by_id[operand] : NULL;
+
+	if (!def || def->id != TYPE_FUNCTION)
+		return 0;
+
+	const qcvm_func_t target = *(const qcvm_func_t *)(vm->global_data + operand);
+
+	if (target <= 0 || (size_t)target >= vm->functions_size || vm->functions[target].name_index != def->name_index)
+		return 0;
+
+	return target;
+}
+
+static inline bool qcvm_ranges_overlap(const qcvm_function_t *a, const qcvm_function_t *b)
+{
+	return a->first_arg < b->first_arg + b->num_args_and_locals + LOCALS_FIX &&
+		b->first_arg < a->first_arg + a->num_args_and_locals + LOCALS_FIX;
+}
+
+// Spilled functions (the ones qcvm_window_locals couldn't window) save the
+// slots they're about to use on entry, in case something further down the stack
+// lives there too. That can only be another spilled function that reaches this one
+// through calls, so anything no such function overlaps with gets to skip it. Calls
+// through variables are assumed to reach everything; QC that builtins call back into
+// isn't in the graph at all, which qcvm_execute covers for at run time.
+static void qcvm_analyze_calls(qcvm_t *vm)
+{
+	size_t cached_size = 0;
+	const bool *cached_saves_locals = (const bool *)qcvm_cache_section(vm, CACHE_SAVES_LOCALS, &cached_size);
+
+	if (cached_saves_locals && cached_size == sizeof(bool) * vm->functions_size)
+	{
+		vm->saves_locals = (bool *)qcvm_alloc(vm, sizeof(bool) * vm->functions_size);
+		memcpy(vm->saves_locals, cached_saves_locals, cached_size);
+		return;
+	}
+
+	uint8_t *reachable = (uint8_t *)qcvm_alloc(vm, vm->statements_size);
+	uint8_t *referenced = (uint8_t *)qcvm_alloc(vm, vm->global_size);
+	// per function: first direct callee in callees, how many, and whether it calls through a variable
+	size_t *callees_start = (size_t *)qcvm_alloc(vm, sizeof(size_t) * vm->functions_size);
+	size_t *callees_count = (size_t *)qcvm_alloc(vm, sizeof(size_t) * vm->functions_size);
+	bool *calls_unknown = (bool *)qcvm_alloc(vm, sizeof(bool) * vm->functions_size);
+	qcvm_func_t *callees = NULL;
+	size_t callees_size = 0, callees_allocated = 0;
+
+	vm->saves_locals = (bool *)qcvm_alloc(vm, sizeof(bool) * vm->functions_size);
+
+	for (const qcvm_statement_t *s = vm->statements; s < vm->statements + vm->statements_size; s++)
+	{
+		if (s->args.a < vm->global_size)
+			referenced[s->args.a] = true;
+		if (s->args.b < vm->global_size)
+			referenced[s->args.b] = true;
+		if (s->args.c < vm->global_size)
+			referenced[s->args.c] = true;
+	}
+
+	for (size_t f = 0; f < vm->functions_size; f++)
+	{
+		const qcvm_function_t *func = &vm->functions[f];
+		size_t first = 0, last = 0;
+
+		callees_start[f] = callees_size;
+
+		if (func->id <= 0)
+			continue;
+
+		if (!qcvm_find_reachable(vm, (size_t)func->id, reachable, &first, &last, vm->statements_size))
+			calls_unknown[f] = true;
+		else
+		{
+			for (size_t i = first; i <= last; i++)
+			{
+				if (!reachable[i] || !qcvm_opcode_is_call(qcvm_unfused_opcode(vm->decoded_statements[i].opcode)))
+					continue;
+
+				const qcvm_func_t target = qcvm_direct_call_target(vm, vm->statements[i].args.a);
+
+				if (!target)
+				{
+					calls_unknown[f] = true;
+					continue;
+				}
+				// builtins don't have locals, and what they call back into is handled separately
+				else if (vm->functions[target].id <= 0)
+					continue;
+
+				if (callees_size == callees_allocated)
+				{
+					qcvm_func_t *old_callees = callees;
+					callees_allocated += CALLEES_RESERVE;
+					callees = (qcvm_func_t *)qcvm_alloc(vm, sizeof(qcvm_func_t) * callees_allocated);
+
+					if (old_callees)
+					{
+						memcpy(callees, old_callees, sizeof(qcvm_func_t) * callees_size);
+						qcvm_mem_free(vm, old_callees);
+					}
+				}
+
+				callees[callees_size++] = target;
+			}
+		}
+
+		callees_count[f] = callees_size - callees_start[f];
+		memset(reachable + first, 0, last - first + 1);
+	}
+
+	// walk everything each spilled function can call into, and make any
+	// spilled function it overlaps with save on entry
+	bool *visited = (bool *)qcvm_alloc(vm, sizeof(bool) * vm->functions_size);
+	qcvm_func_t *pending = (qcvm_func_t *)qcvm_alloc(vm, sizeof(qcvm_func_t) * vm->functions_size);
+	size_t num_saving = 0, num_spilled = 0;
+
+	for (size_t f = 0; f < vm->functions_size; f++)
+	{
+		const qcvm_function_t *func = &vm->functions[f];
+
+		if (func->id <= 0 || vm->frame_sizes[f] || !func->num_args_and_locals)
+			continue;
+
+		num_spilled++;
+
+		// real globals past the declared locals get put back on leave too,
+		// so this has to keep doing that if anything uses them
+		for (qcvm_global_t g = func->first_arg + func->num_args_and_locals; g < func->first_arg + func->num_args_and_locals + LOCALS_FIX && g < vm->global_size; g++)
+			if (referenced[g])
+				vm->saves_locals[f] = true;
+
+		size_t pending_size = 0;
+		bool reaches_all = calls_unknown[f];
+
+		memset(visited, 0, sizeof(bool) * vm->functions_size);
+
+		for (size_t c = 0; c < callees_count[f]; c++)
+			if (!visited[callees[callees_start[f] + c]])
+			{
+				visited[callees[callees_start[f] + c]] = true;
+				pending[pending_size++] = callees[callees_start[f] + c];
+			}
+
+		while (pending_size && !reaches_all)
+		{
+			const qcvm_func_t callee = pending[--pending_size];
+
+			if (calls_unknown[callee])
+				reaches_all = true;
+
+			for (size_t c = 0; c < callees_count[callee]; c++)
+				if (!visited[callees[callees_start[callee] + c]])
+				{
+					visited[callees[callees_start[callee] + c]] = true;
+					pending[pending_size++] = callees[callees_start[callee] + c];
+				}
+		}
+
+		for (size_t t = 0; t < vm->functions_size; t++)
+		{
+			const qcvm_function_t *target = &vm->functions[t];
+
+			if ((reaches_all || visited[t]) && target->id > 0 && !vm->frame_sizes[t] && target->num_args_and_locals && qcvm_ranges_overlap(func, target))
+				vm->saves_locals[t] = true;
+		}
+	}
+
+	for (size_t f = 0; f < vm->functions_size; f++)
+		if (vm->saves_locals[f])
+			num_saving++;
+
+	qcvm_mem_free(vm, pending);
+	qcvm_mem_free(vm, visited);
+	qcvm_mem_free(vm, callees);
+	qcvm_mem_free(vm, calls_unknown);
+	qcvm_mem_free(vm, callees_count);
+	qcvm_mem_free(vm, callees_start);
+	qcvm_mem_free(vm, referenced);
+	qcvm_mem_free(vm, reachable);
+
+	qcvm_debug(vm, "QCVM: %zu/%zu spilled functions need to save locals\n", num_saving, num_spilled);
+}
+
+// gives every call statement its own call cache, and links the ones that
+// always call the same function straight to it.
+static void qcvm_link_calls(qcvm_t *vm)
+{
+	size_t num_linked = 0;
+
+	vm->call_caches_size = 0;
+
+	for (size_t i = 0; i < vm->statements_size; i++)
+		if (qcvm_opcode_is_call(qcvm_unfused_opcode(vm->decoded_statements[i].opcode)))
+			vm->decoded_statements[i].call_cache = (uint32_t)vm->call_caches_size++;
+
+	vm->call_caches = (qcvm_call_cache_t *)qcvm_alloc(vm, sizeof(qcvm_call_cache_t) * maxsz(vm->call_caches_size, 1));
+
+	for (size_t i = 0; i < vm->statements_size; i++)
+	{
+		const qcvm_decoded_statement_t *s = &vm->decoded_statements[i];
+
+		if (!qcvm_opcode_is_call(qcvm_unfused_opcode(s->opcode)))
+			continue;
+
+		const qcvm_func_t target = qcvm_direct_call_target(vm, s->args.a);
+
+		if (!target || !vm->functions[target].id)
+			continue;
+
+		qcvm_function_t *function = &vm->functions[target];
+		qcvm_builtin_t builtin = NULL;
+
+		// builtins registered later get resolved on the first call
+		if (function->id < 0 && !(builtin = qcvm_builtin_list_get(vm, function->id)))
+			continue;
+
+		vm->call_caches[s->call_cache] = (qcvm_call_cache_t) { target, function, builtin };
+		num_linked++;
+	}
+
+	qcvm_debug(vm, "QCVM: linked %zu/%zu call sites\n", num_linked, vm->call_caches_size);
+}
+
+void qcvm_check(qcvm_t *vm)
+{
+#if ALLOW_PROGS_CACHE
+	if (vm->cache.enabled)
+		qcvm_cache_check_fields(vm);
+#endif
+
+	if (!qcvm_load_cached_fields(vm))
+	{
+		qcvm_setup_fields(vm);
+
+		qcvm_init_field_map(vm);
+	}
+	
+	qcvm_field_wrap_list_init(vm);
+
+	qcvm_check_builtins(vm);
+
+	size_t cached_statements_size = 0;
+	const qcvm_statement_t *cached_statements = (const qcvm_statement_t *)qcvm_cache_section(vm, CACHE_STATEMENTS, &cached_statements_size);
+
+	if (cached_statements && cached_statements_size == sizeof(qcvm_statement_t) * vm->statements_size)
+		memcpy(vm->statements, cached_statements, cached_statements_size);
+	else
+	{
+		qcvm_setup_intrinsics(vm);
+
+		qcvm_fuse_statements(vm);
+
+		qcvm_classify_stores(vm);
+	}
+
+	qcvm_decode_statements(vm);
+
+	qcvm_window_locals(vm);
+
+	qcvm_analyze_calls(vm);
+
+	qcvm_link_calls(vm);
+
+#if ALLOW_JIT
+	qcvm_jit_init(vm);
+#endif
+
+#if ALLOW_PROGS_CACHE
+	qcvm_cache_write(vm);
+#endif
+
+	// nothing writes to these after loading, so keep it that way
+	qcvm_protect_mapping(&vm->progs_mapping, vm->string_data, vm->string_size);
+	qcvm_protect_mapping(&vm->progs_mapping, vm->definitions, sizeof(qcvm_definition_t) * vm->definitions_size);
 }
 
 #if ALLOW_INSTRUMENTING
@@ -1578,6 +3071,7 @@ static const char *timer_type_names[TotalTimerFields] =
 	"String PopRef",
 	"String PushRef",
 	"String Find",
+	"String Collect",
 
 	"Wrap Apply"
 };
@@ -1758,7 +3252,7 @@ void qcvm_shutdown(qcvm_t *vm)
 				all_total += timer->time[m];
 			}
 
-			fprintf(fp, "ID,Count,Total (ms),Avg (ns),%%\n");
+			fprintf(fp, "ID,Name,Count,Total (ms),Avg (ns),%%\n");
 
 			for (size_t i = 0; i < OP_NUMOPS; i++)
 			{
@@ -1769,7 +3263,7 @@ void qcvm_shutdown(qcvm_t *vm)
 
 				const float total = timer->time[m];
 
-				fprintf(fp, "%" PRIuPTR ",%" PRIuPTR ",%f,%f,%f\n", i, timer->count[m], total, (total / timer->count[m]) * 1000, (total / all_total) * 100);
+				fprintf(fp, "%" PRIuPTR ",%s,%" PRIuPTR ",%f,%f,%f\n", i, opcode_names[i], timer->count[m], total, (total / timer->count[m]) * 1000, (total / all_total) * 100);
 			}
 
 			fclose(fp);
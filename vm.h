@@ -6,10 +6,16 @@
 typedef struct qcvm_s qcvm_t;
 
 // whether or not to use address-of-label opcode jumps (if supported).
-// if this is disabled, a simple switch(code) is used.
+// if this is disabled, each handler is called through the decoded statement.
 #ifndef USE_GNU_OPCODE_JUMPING
 #define USE_GNU_OPCODE_JUMPING 1
 #endif
+// whether handlers jump straight into the next one through guaranteed
+// tail calls (if supported; clang only for now). takes priority over
+// USE_GNU_OPCODE_JUMPING when debugging & profiling are off.
+#ifndef USE_TAIL_CALL_DISPATCH
+#define USE_TAIL_CALL_DISPATCH 0
+#endif
 // whether the FTEQCC debugger is supported. shouldn't really
 // affect performance.
 #ifndef ALLOW_DEBUGGING
@@ -25,6 +31,26 @@ typedef struct qcvm_s qcvm_t;
 #ifndef ALLOW_PROFILING
 #define ALLOW_PROFILING 1
 #endif
+// whether hot functions may be compiled to native code. only
+// x86-64 with the System V ABI is supported; everywhere else this
+// is forced off and everything runs in the interpreter.
+#ifndef ALLOW_JIT
+#define ALLOW_JIT 1
+#endif
+#if ALLOW_JIT && (!defined(__x86_64__) || defined(_WIN32))
+#undef ALLOW_JIT
+#define ALLOW_JIT 0
+#endif
+// whether progs translated to C ahead of time (see vm_aot.c)
+// can be loaded in place of interpreting.
+#ifndef ALLOW_AOT
+#define ALLOW_AOT 1
+#endif
+// whether what qcvm_load & qcvm_check derive from the progs can be
+// cached next to it (see vm_cache.c) and mapped on the next load.
+#ifndef ALLOW_PROGS_CACHE
+#define ALLOW_PROGS_CACHE 1
+#endif
 
 #if ALLOW_DEBUGGING
 typedef enum
@@ -38,10 +64,12 @@ typedef enum
 } qcvm_debug_state_t;
 
 typedef void *qcvm_mutex_t;
-typedef void *qcvm_thread_t;
 typedef void (*qcvm_thread_func_t) (void);
 #endif
 
+typedef void *qcvm_thread_t;
+typedef void (*qcvm_task_func_t) (void *data);
+
 #include <assert.h>
 
 enum
@@ -128,6 +156,85 @@ typedef struct
 	qcvm_operands_t	args;
 } qcvm_statement_t;
 
+typedef struct qcvm_decoded_statement_s qcvm_decoded_statement_t;
+
+typedef void (*qcvm_opcode_func_t) (qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth);
+
+// statements are decoded once after qcvm_check into a parallel stream that
+// the interpreter runs from; the handler is looked up ahead of time and the
+// operands are resolved to addresses into global_data, so neither has to be done
+// per instruction. operands that aren't valid global indices (jump offsets, bounds
+// for BOUNDCHECK) resolve to NULL, and the raw args are kept for those.
+// operands that are locals of a windowed function (see qcvm_window_locals)
+// still resolve into global_data, but are flagged to be moved to the current
+// frame when they're used.
+typedef struct qcvm_decoded_statement_s
+{
+	qcvm_opcode_func_t	handler;
+	qcvm_global_t		*a, *b, *c;
+	qcvm_operands_t		args;
+	qcvm_opcode_t		opcode;
+	uint8_t				frame_a, frame_b, frame_c;
+	// set by qcvm_field_wrap_list_tag_stores
+	bool				skip_wraps;
+	// calls only; index into call_caches
+	uint32_t			call_cache;
+} qcvm_decoded_statement_t;
+
+#if ALLOW_JIT
+typedef void (*qcvm_jit_code_t) (qcvm_t *vm);
+
+typedef struct
+{
+	qcvm_jit_code_t	code;
+	size_t			code_size;
+	uint32_t		calls;
+	bool			failed;
+} qcvm_jit_function_t;
+
+typedef struct
+{
+	bool				enabled;
+	// indices match up 1:1 with functions
+	qcvm_jit_function_t	*functions;
+} qcvm_jit_t;
+#endif
+
+#if ALLOW_AOT
+typedef void (*qcvm_aot_code_t) (qcvm_t *vm);
+
+typedef struct
+{
+	void			*library;
+	void			*import;
+	// indices match up 1:1 with functions; NULL for ones that weren't translated
+	qcvm_aot_code_t	*functions;
+} qcvm_aot_t;
+#endif
+
+// a file mapped into memory; see vm_mapping.h
+typedef struct
+{
+	void	*data;
+	size_t	size;
+	void	*handle;
+} qcvm_mapping_t;
+
+#if ALLOW_PROGS_CACHE
+typedef struct
+{
+	bool			enabled;
+	char			*filename;
+	uint64_t		key;
+	// the mapped cache file, if it was built from this progs & build
+	qcvm_mapping_t	mapping;
+	// whether the field sections can be used too
+	bool			fields_valid;
+	// global_data from before qcvm_setup_fields, while a cache needs writing
+	qcvm_global_t	*unchecked_globals;
+} qcvm_cache_t;
+#endif
+
 #if ALLOW_INSTRUMENTING
 #define OPCODES_ONLY
 #include "vm_opcodes.h"
@@ -230,6 +337,7 @@ enum
 	StringPopRef,
 	StringPushRef,
 	StringFind,
+	StringCollect,
 
 	WrapApply,
 
@@ -352,6 +460,11 @@ typedef struct
 	qcvm_function_t			*function;
 	const qcvm_statement_t	*statement;
 	qcvm_global_t			*locals;
+	// windowed functions keep their locals here instead of in global_data
+	qcvm_global_t			*frame;
+	uintptr_t				frame_delta;
+	// whether the caller's copy of this function's locals range has to be put back
+	bool					spilled;
 	qcvm_string_backup_t	*ref_strings;
 	size_t					ref_strings_size, ref_strings_allocated;
 
@@ -366,11 +479,56 @@ typedef struct
 	const char	*str;
 	size_t		length;
 	size_t		ref_count;
+
+	// bucket chain in qcvm_string_list_t::hashes
+	uint32_t		hash_value;
+	qcvm_string_t	hash_next;
+
+	// qcvm_string_fold_hash of the contents, or 0 if it hasn't been needed yet
+	uint32_t		folded_hash;
+
+	// if non-zero, this is a slice of that string: str points into the
+	// parent's memory (which the view keeps a ref to), and isn't terminated
+	// unless the slice runs to the end. views aren't hashed, and get copied
+	// out into their own memory once something needs them as a C string.
+	qcvm_string_t	view_of;
+
+	// str is memory the engine handed us for the length of a call; see
+	// qcvm_set_global_str_borrowed
+	bool			borrowed;
 } qcvm_ref_counted_string_t;
 
 static const size_t REF_STRING_RESERVE = 256;
 static const size_t FREE_STRING_RESERVE = 64;
 
+// string bodies are carved out of slabs of this size, in power-of-two size
+// classes from STRING_SLAB_MIN_SIZE to STRING_SLAB_MAX_SIZE; longer bodies
+// are allocated on their own.
+static const size_t STRING_SLAB_SIZE = 0x4000;
+enum
+{
+	STRING_SLAB_MIN_SIZE = 16,
+	STRING_SLAB_MAX_SIZE = 1024,
+	STRING_SLAB_CLASSES = 7
+};
+
+typedef struct
+{
+	// bytes the bodies themselves take (including terminators)
+	size_t	bytes_used;
+	// bytes held in slabs plus oversized bodies; the difference from
+	// bytes_used is what's lost to free chunks and size class rounding
+	size_t	bytes_reserved;
+	// bytes sitting in free chunks
+	size_t	bytes_free;
+	size_t	slabs;
+	// allocations/frees this frame, and the totals from the last frame
+	size_t	allocs, frees;
+	size_t	frame_allocs, frame_frees;
+	// slots scanned and strings freed by the last collection
+	size_t	collect_scanned, collect_freed;
+} qcvm_string_slab_stats_t;
+
 typedef struct qcvm_ref_storage_hash_s
 {
 	const void		*ptr;
@@ -394,18 +552,38 @@ typedef struct qcvm_ref_storage_hash_s
 // less of a hassle and prevents other weird issues (we don't have to think about save/load
 // for instance; we just pop in the strings and away we go). Strings in my QCVM are
 // **immutable** in every circumstance. Other QCVMs allow string mutation.
+// In collect mode (qc_string_gc), copies of strings aren't tracked at all; the ref
+// count only holds pins from engine-side containers, and qcvm_string_list_collect
+// frees whatever isn't pinned or found in VM memory at a safe point.
 typedef struct
 {
+	bool	collect;
+	bool	*marks;
+	size_t	marks_allocated;
+
 	// Mapped list to dynamic strings
 	qcvm_ref_counted_string_t	*strings;
 	size_t						strings_size, strings_allocated;
+	// heads of the hash buckets for live strings, one per allocated string
+	qcvm_string_t				*hashes;
+
+	// free chunk lists for each slab size class; a free chunk stores the
+	// next one in its first bytes
+	void						*slab_free[STRING_SLAB_CLASSES];
+	qcvm_string_slab_stats_t	slab_stats;
 
 	// stores a list of free indices that were explicitly freed
 	qcvm_string_t	*free_indices;
 	size_t			free_indices_size, free_indices_allocated;
 
-	// mapped list of addresses that contain(ed) strings
+	// refs held in global_data, the edicts or the frame stack are kept in these
+	// instead, one id per slot (0 if the slot holds no ref); they're allocated
+	// the first time a ref lands in their range.
+	qcvm_string_t	*global_refs, *edict_refs, *frame_refs;
+
+	// mapped list of other addresses that contain(ed) strings
 	qcvm_ref_storage_hash_t	*ref_storage_data, **ref_storage_hashes, *ref_storage_free;
+	// number of refs held, both in the shadows and the hash
 	size_t					ref_storage_stored, ref_storage_allocated;
 } qcvm_string_list_t;
 
@@ -425,9 +603,46 @@ bool qcvm_find_string(qcvm_t *vm, const char *value, qcvm_string_t *rstr);
 qcvm_string_t qcvm_store_or_find_string(qcvm_t *vm, const char *value, const size_t len, const bool copy);
 const char *qcvm_get_string(const qcvm_t *vm, const qcvm_string_t str);
 size_t qcvm_get_string_length(const qcvm_t *vm, const qcvm_string_t str);
+// case-folded string hashes are built back to front, so every suffix of a string in
+// the static table gets its hash from the one after it.
+enum { STRING_FOLD_HASH_SEED = 5381 };
+
+inline uint32_t qcvm_string_fold_hash_step(const uint32_t hash, const char c)
+{
+	return (hash * 33) ^ (uint8_t)tolower((unsigned char)c);
+}
+
+// 0 is kept free to mean "not computed"
+inline uint32_t qcvm_string_fold_hash_final(const uint32_t hash)
+{
+	return hash ? hash : 1;
+}
+
+// whether two strings are equal, honoring strcasesensitive. lengths and case-folded
+// hashes are compared before any characters are.
+bool qcvm_strings_equal(qcvm_t *vm, const qcvm_string_t a, const qcvm_string_t b);
+// like qcvm_get_string, but the result is only valid for the string's length
+// and may not be terminated; this never has to copy a view.
+const char *qcvm_get_string_chars(const qcvm_t *vm, const qcvm_string_t str);
+// makes a string holding len characters of parent starting at offset,
+// sharing the parent's memory where it can.
+qcvm_string_t qcvm_string_slice(qcvm_t *vm, const qcvm_string_t parent, const size_t offset, const size_t len);
+
+// rolls over the per-frame string allocation counters; called once the
+// game frame is done.
+void qcvm_string_list_end_frame(qcvm_t *vm);
+// in collect mode, frees every dynamic string that isn't pinned or referenced from
+// global_data, the edicts or a handle's memory. only does anything outside of
+// execution.
+void qcvm_string_list_collect(qcvm_t *vm);
+// marks any string ids in the span as reachable; for handle descriptors' mark_strings.
+void qcvm_string_list_mark_span(qcvm_t *vm, const void *ptr, const size_t span);
 
 #ifdef QCVM_INTERNAL
-// Note: ownership of the pointer is transferred to the string list here.
+// allocates room for a string body of len characters plus the terminator
+char *qcvm_string_list_alloc(qcvm_t *vm, const size_t len);
+// Note: ownership of the pointer is transferred to the string list here; it
+// must have come from qcvm_string_list_alloc with the same length.
 qcvm_string_t qcvm_string_list_store(qcvm_t *vm, const char *str, const size_t len);
 void qcvm_string_list_unstore(qcvm_t *vm, const qcvm_string_t id);
 qcvm_string_t *qcvm_string_list_has_ref(qcvm_t *vm, const void *ptr, qcvm_ref_storage_hash_t **hashed_ptr);
@@ -441,6 +656,14 @@ void qcvm_string_list_write_state(qcvm_t *vm, FILE *fp);
 void qcvm_string_list_dump_refs(FILE *fp, qcvm_t *vm);
 #endif
 
+// growable buffer for building strings up in place; data is always
+// null-terminated once anything has been appended.
+typedef struct
+{
+	char	*data;
+	size_t	length, allocated;
+} qcvm_string_builder_t;
+
 typedef void (*qcvm_builtin_t) (qcvm_t *vm);
 
 typedef struct
@@ -452,6 +675,16 @@ typedef struct
 void qcvm_builtin_list_register(qcvm_t *vm, const char *name, qcvm_builtin_t builtin);
 qcvm_builtin_t qcvm_builtin_list_get(qcvm_t *vm, const qcvm_func_t func);
 
+// what a call site last resolved its function to. most only ever call the
+// one function, so the next call can skip straight to entering it; the ones
+// that call through a constant are filled in at load (see qcvm_link_calls).
+typedef struct
+{
+	qcvm_func_t		func;
+	qcvm_function_t	*function;
+	qcvm_builtin_t	builtin;
+} qcvm_call_cache_t;
+
 // Helpful macro for quickly registering a builtin
 #define qcvm_register_builtin(name) \
 	qcvm_builtin_list_register(vm, #name, QC_ ## name)
@@ -481,8 +714,30 @@ typedef struct qcvm_field_wrapper_s
 
 void qcvm_field_wrap_list_register(qcvm_t *vm, const char *field_name, const size_t field_offset, const size_t client_offset, qcvm_field_setter_t setter);
 void qcvm_field_wrap_list_check_set(qcvm_t *vm, const void *ptr, const size_t span);
+// call once every wrap is registered; flags the entity stores that can
+// be proven to never land on a wrapped field so they skip the check.
+void qcvm_field_wrap_list_tag_stores(qcvm_t *vm);
+// from here on, client wraps on the first num_entities entities aren't
+// applied when they're stored to, just marked dirty until the next sync.
+void qcvm_field_wrap_list_defer(qcvm_t *vm, const size_t num_entities);
+// applies every dirty client wrap; call before the engine reads client state.
+void qcvm_field_wrap_list_sync(qcvm_t *vm);
+
+typedef struct
+{
+	size_t		num_entities;
+	size_t		num_words;
+	// num_words per entity, one bit per wrapped field offset
+	uint32_t	*dirty;
+	bool		*entity_dirty;
+	bool		any_dirty;
+} qcvm_deferred_wraps_t;
 
 static const size_t STACK_RESERVE = 32;
+static const size_t FRAME_STACK_SIZE = 0x10000;
+// native code calls into native code on the C stack, so past this many
+// levels calls go through the interpreter, which doesn't
+static const uint32_t MAX_NATIVE_DEPTH = 256;
 
 typedef struct
 {
@@ -492,6 +747,21 @@ typedef struct
 	uint8_t	argc;
 	int32_t current;
 
+	// stack that windowed functions' frames are carved out of; this never moves,
+	// since native code holds on to frame addresses for as long as it runs.
+	qcvm_global_t	*frames;
+	size_t			frames_size, frames_allocated;
+	// distance in bytes from the current function's locals in global_data
+	// to where they actually are in its frame
+	uintptr_t		frame_delta;
+	// how many qcvm_execute calls from builtins are running; see qcvm_analyze_calls
+	uint32_t		reentered;
+	// how many JIT or AOT functions are running
+	uint32_t		native_depth;
+	// how many windowed functions are running out of global_data because the
+	// frame stack was full; see qcvm_enter
+	uint32_t		unwindowed;
+
 #if ALLOW_INSTRUMENTING
 	qcvm_profiler_mark_t	profile_mark_backup;
 	size_t					profile_mark_depth;
@@ -511,13 +781,23 @@ typedef struct qcvm_string_hash_s
 	struct qcvm_string_hash_s	*hash_next;
 } qcvm_string_hash_t;
 
-typedef struct qcvm_definition_hash_s
+typedef enum
 {
-	qcvm_definition_t	*def;
+	SYMBOL_DEFINITION,
+	SYMBOL_FIELD,
+	SYMBOL_FUNCTION
+} qcvm_symbol_kind_t;
 
-	uint32_t						hash_value;
-	struct qcvm_definition_hash_s	*hash_next;
-} qcvm_definition_hash_t;
+// every named definition, field and function is in one index, keyed by name.
+// index is into the table of that kind, and chains are 1-based indices into
+// the entries, so the whole thing can be used straight out of the progs cache.
+typedef struct
+{
+	uint32_t	hash_value;
+	uint32_t	kind;
+	uint32_t	index;
+	uint32_t	next;
+} qcvm_symbol_t;
 
 // HANDLES
 // Quake2C uses handles for various things, like files and advanced containers
@@ -535,6 +815,8 @@ typedef struct
 	void	(*write)			(qcvm_t *vm, void *handle, FILE *fp);
 	void	*(*read)			(qcvm_t *vm, FILE *fp);
 	bool	(*resolve_pointer)	(const qcvm_t *vm, void *handle, const size_t offset, const size_t len, void **address);
+	// for handles whose memory can hold strings; see qcvm_string_list_collect
+	void	(*mark_strings)		(qcvm_t *vm, void *handle);
 } qcvm_handle_descriptor_t;
 
 typedef int32_t qcvm_handle_id_t;
@@ -594,8 +876,12 @@ void qcvm_set_global(qcvm_t *vm, const qcvm_global_t global, const void *value,
 	qcvm_set_global(vm, global, value_ptr, sizeof(type))
 
 // VM
+// the last definition called name of the given type
 qcvm_definition_t *qcvm_find_definition(qcvm_t *vm, const char *name, const qcvm_deftype_t type);
 
+// the last definition called name, of any type
+qcvm_definition_t *qcvm_find_definition_by_name(qcvm_t *vm, const char *name);
+
 qcvm_definition_t *qcvm_find_field(qcvm_t *vm, const char *name);
 
 int qcvm_line_number_for(const qcvm_t *vm, const qcvm_statement_t *statement);
@@ -613,12 +899,36 @@ const char *qcvm_stack_entry(const qcvm_t *vm, const qcvm_stack_t *s, const bool
 const char *qcvm_stack_trace(const qcvm_t *vm, const bool compact);
 
 void qcvm_execute(qcvm_t *vm, qcvm_function_t *function);
+
+#ifdef QCVM_INTERNAL
+// runs the interpreter from the current stack until enter_depth functions have returned
+void qcvm_interpret(qcvm_t *vm, int32_t enter_depth);
+
+// the opcode a fused statement or unchecked store started out as
+qcvm_opcode_t qcvm_unfused_opcode(const qcvm_opcode_t code);
+
+// stores that skip string ref & field wrap bookkeeping; see qcvm_classify_stores
+bool qcvm_opcode_is_unchecked_store(const qcvm_opcode_t code);
+
+// conditional branches, and the statement offset of any branch or GOTO
+bool qcvm_opcode_is_branch(const qcvm_opcode_t code);
+int32_t qcvm_branch_offset(const qcvm_opcode_t code, const qcvm_operands_t args);
+
+// marks every statement control can reach from entry, and the range they cover.
+// returns false if control leaves the statement list or max_statements is exceeded.
+bool qcvm_find_reachable(qcvm_t *vm, const size_t entry, uint8_t *reachable, size_t *first, size_t *last, const size_t max_statements);
+
+// runs a single statement for native code, through the same handler the interpreter
+// uses. a call into an interpreted function runs until it returns. returns whether the
+// statement jumped.
+bool qcvm_run_statement(qcvm_t *vm, const size_t index);
+#endif
 	
 void qcvm_write_state(qcvm_t *vm, FILE *fp);
 
 void qcvm_read_state(qcvm_t *vm, FILE *fp);
 
-const char *qcvm_parse_format(const qcvm_string_t formatid, const qcvm_t *vm, const uint8_t start);
+const char *qcvm_parse_format(const qcvm_string_t formatid, qcvm_t *vm, const uint8_t start);
 
 void qcvm_load(qcvm_t *vm, const char *engine_name, const char *filename);
 
@@ -636,7 +946,6 @@ typedef struct qcvm_s
 	qcvm_definition_t		*definitions;
 	size_t					definitions_size;
 	qcvm_definition_t		**definition_map_by_id;
-	qcvm_definition_hash_t	**definition_hashes, *definition_hashes_data;
 	// fields are entity fields; after all remapping and such is done (see below)
 	// the highest potential field is the final size of a single entity structure, which
 	// is stored in field_real_size and used later on. It's a bit confusing, but a
@@ -650,10 +959,21 @@ typedef struct qcvm_s
 	size_t					fields_size;
 	qcvm_definition_t		**field_map_by_id;
 	size_t					field_real_size;
-	qcvm_definition_hash_t	**field_hashes, *field_hashes_data;
+	// name -> definition, field or function; see qcvm_symbol_t. the other way
+	// around is definition_map_by_id & field_map_by_id.
+	const qcvm_symbol_t		*symbols;
+	size_t					symbols_size;
+	const uint32_t			*symbol_buckets;
+	uint32_t				symbol_mask;
 	// this is the actual binary opcode data, straight list of binary opcodes.
 	qcvm_statement_t		*statements;
 	size_t					statements_size;
+	// pre-decoded version of the above, which is what actually gets executed.
+	// indices match up 1:1 with statements.
+	qcvm_decoded_statement_t	*decoded_statements;
+	// one per call statement
+	qcvm_call_cache_t		*call_caches;
+	size_t					call_caches_size;
 	// special .lno file which maps statements to line numbers
 	int		*linenumbers;
 	// functions are.. uh.. functions.
@@ -667,6 +987,12 @@ typedef struct qcvm_s
 	// this is used for allocating stack space for locals
 	// that will be clobbered by other functions.
 	size_t	highest_stack;
+	// size of each function's frame if its locals are windowed, or 0
+	// if they're saved & restored around calls instead.
+	uint32_t	*frame_sizes;
+	// whether entering a spilled function has to save its locals range
+	// first, since something that might be running under it uses it too.
+	bool		*saves_locals;
 	// globals. these are a bit of a misnomer, but this is basically
 	// the "heap" space that the QCVM has. This space is also used for
 	// function locals (usually at the end of the table), as well as
@@ -677,12 +1003,20 @@ typedef struct qcvm_s
 	// be modified. I also cache string lengths at every location (since a
 	// compact string table may refer to locations that aren't the beginning
 	// of a string) as well as hashed string data, for quick lookups.
+	// only string starts and suffixes that the progs actually refer to are
+	// hashed; see qcvm_index_strings.
 	char				*string_data;
 	size_t				*string_lengths;
+	// case-folded hash of the string at every location; see qcvm_string_fold_hash
+	uint32_t			*string_folded_hashes;
 	size_t				string_size;
 	qcvm_string_hash_t	**string_hashes, *string_hashes_data;
+	// string_hashes is a power of two in size
+	uint32_t			string_hash_mask;
 	// see qcvm_string_list_t for more info about dynamic strings
 	qcvm_string_list_t	dynamic_strings;
+	// scratch space for va, strconcat & qcvm_parse_format
+	qcvm_string_builder_t	format_builder;
 	// pointer to global of "strcasesensitive" in QC. this isn't a QC thing, but rather
 	// my attempt to workaround stricmp being a hot spot. Function calls are expensive, so
 	// rather than use functions, you can turn string case sensitiveness on/off for string
@@ -697,6 +1031,10 @@ typedef struct qcvm_s
 	// fields in Q2, since we have special requirements like ptrs that can't exactly
 	// be resolved by a simple mapping.
 	qcvm_field_wrapper_t	*field_wraps;
+	// one bit per field offset, set if it's wrapped; what the wrap check tests
+	uint32_t				*field_wrap_bits;
+	// see qcvm_field_wrap_list_defer
+	qcvm_deferred_wraps_t	deferred_wraps;
 	// fields in QC use a zero-indexed system which is basically a direct map into an entity's data.
 	// think of an entity as int*, sized by the highest possible field value, and when a field is read/write
 	// it's just (int *)(edicts + size)[index] as the start position. In Q1 this is all fields used by QC, and
@@ -709,6 +1047,9 @@ typedef struct qcvm_s
 	// entity pointer over to it.
 	qcvm_system_field_t		*system_fields;
 	size_t					system_fields_size;
+	// progs.dat itself, if it was mapped (see map_progs); the tables above
+	// point into it rather than into their own memory.
+	qcvm_mapping_t			progs_mapping;
 
 	// state of the VM
 	qcvm_state_t	state;
@@ -719,6 +1060,8 @@ typedef struct qcvm_s
 	// path to progs.dat, used for relativeness for placing
 	// profiles and other files
 	char	path[MAX_QPATH];
+	// map 32-bit progs rather than reading them into memory
+	bool	map_progs;
 	// mirrored data from globals, here so we don't "depend" on Q2's API directly
 	void	*edicts;
 	size_t	system_edict_size;
@@ -730,6 +1073,16 @@ typedef struct qcvm_s
 	void	(*debug_print)(const char *str);
 	void	*(*alloc)(const size_t size);
 	void	(*free)(void *ptr);
+	// runs a task on a thread of its own, and waits for it to finish. if these
+	// are set, the independent parts of qcvm_load are run in parallel. the
+	// callbacks above are never called from those threads; anything a task
+	// finds wrong is recorded and raised through error once they're joined.
+	// create may run the task inline and return NULL, which join ignores.
+	struct
+	{
+		qcvm_thread_t	(*create)(qcvm_task_func_t func, void *data);
+		void			(*join)(qcvm_thread_t thread);
+	} tasks;
 
 	// handles!
 	// see qcvm_handle_list_t
@@ -781,6 +1134,21 @@ typedef struct qcvm_s
 #endif
 	} profiling;
 #endif
+
+	// native code for hot functions; see vm_jit.c
+#if ALLOW_JIT
+	qcvm_jit_t	jit;
+#endif
+
+	// progs translated ahead of time; see vm_aot.c
+#if ALLOW_AOT
+	qcvm_aot_t	aot;
+#endif
+
+	// derived load data; see vm_cache.c
+#if ALLOW_PROGS_CACHE
+	qcvm_cache_t	cache;
+#endif
 } qcvm_t;
 
 qcvm_noreturn void qcvm_error(const qcvm_t *vm, const char *format, ...);
@@ -924,6 +1292,13 @@ inline qcvm_string_t qcvm_set_global_str(qcvm_t *vm, const qcvm_global_t global,
 	return qcvm_set_string_ptr(vm, qcvm_get_global(vm, global), value, len, copy);
 }
 
+// hands QC a string that lives in the caller's memory without copying or
+// interning it. the caller has to end the borrow with qcvm_end_borrow once the
+// call is done and before the memory goes away; if QC kept the string
+// anywhere, it gets its own copy then.
+qcvm_string_t qcvm_set_global_str_borrowed(qcvm_t *vm, const qcvm_global_t global, const char *value, const size_t len);
+void qcvm_end_borrow(qcvm_t *vm, const qcvm_string_t id, const qcvm_global_t global);
+
 // Return and arguments
 inline edict_t *qcvm_argv_entity(const qcvm_t *vm, const uint8_t d)
 {
@@ -1002,6 +1377,9 @@ inline void qcvm_return_func(qcvm_t *vm, const qcvm_func_t func)
 inline void qcvm_return_string_id(qcvm_t *vm, const qcvm_string_t str)
 {
 	qcvm_set_global_typed_value(qcvm_func_t, vm, GLOBAL_RETURN, str);
+
+	if (str < 0 && qcvm_string_list_is_ref_counted(vm, str))
+		qcvm_string_list_mark_ref_copy(vm, str, qcvm_get_global(vm, GLOBAL_RETURN));
 }
 
 inline void qcvm_return_string(qcvm_t *vm, const char *str)
@@ -1064,13 +1442,8 @@ qcvm_always_inline
 #else
 inline
 #endif
-static void qcvm_call_builtin(qcvm_t *vm, qcvm_function_t *function)
+static void qcvm_run_builtin(qcvm_t *vm, qcvm_function_t *function, qcvm_builtin_t func)
 {
-	qcvm_builtin_t func;
-
-	if (!(func = qcvm_builtin_list_get(vm, function->id)))
-		qcvm_error(vm, "Bad builtin call number");
-
 #if ALLOW_INSTRUMENTING
 	qcvm_profile_t *profile = &vm->profiling.instrumentation.data[function - vm->functions];
 
@@ -1110,6 +1483,38 @@ static void qcvm_call_builtin(qcvm_t *vm, qcvm_function_t *function)
 #endif
 }
 
+#ifndef _DEBUG
+qcvm_always_inline
+#else
+inline
+#endif
+static void qcvm_call_builtin(qcvm_t *vm, qcvm_function_t *function)
+{
+	qcvm_builtin_t func;
+
+	if (!(func = qcvm_builtin_list_get(vm, function->id)))
+		qcvm_error(vm, "Bad builtin call number");
+
+	qcvm_run_builtin(vm, function, func);
+}
+
+// native code (JIT or AOT) doesn't keep profiling data up to date
+// or stop at breakpoints, so the interpreter has to take over for those.
+static inline bool qcvm_can_run_native(const qcvm_t *vm)
+{
+#if ALLOW_INSTRUMENTING || ALLOW_PROFILING
+	if (vm->profiling.flags)
+		return false;
+#endif
+
+#if ALLOW_DEBUGGING
+	if (vm->debug.attached)
+		return false;
+#endif
+
+	return true;
+}
+
 #ifndef _DEBUG
 qcvm_always_inline
 #else
@@ -1127,18 +1532,46 @@ static void qcvm_enter(qcvm_t *vm, qcvm_function_t *function)
 #endif
 
 	qcvm_stack_t *cur_stack = (vm->state.current >= 0) ? &vm->state.stack[vm->state.current] : NULL;
+	const uint32_t frame_size = vm->frame_sizes[function - vm->functions];
+	qcvm_global_t *frame = NULL;
+	bool spill = false;
+
+	// windowed functions get a fresh frame, so nothing of ours is overwritten.
+	// if the frame stack is full, it runs out of global_data like a spilled
+	// function instead; frame operands with no frame_delta land there anyway.
+	if (frame_size)
+	{
+		if (vm->state.frames_size + frame_size > vm->state.frames_allocated)
+			vm->state.unwindowed++;
+		else
+		{
+			frame = vm->state.frames + vm->state.frames_size;
+			vm->state.frames_size += frame_size;
+			memset(frame, 0, sizeof(qcvm_global_t) * frame_size);
+		}
+	}
 
-	// save current stack space that will be overwritten by the new function
+	// save current stack space that will be overwritten by the new function.
+	// qcvm_analyze_calls assumes windowed functions never touch global_data,
+	// so while one is, every spill happens.
 	if (cur_stack && function->num_args_and_locals)
 	{
-		memcpy(cur_stack->locals, qcvm_get_global(vm, function->first_arg), sizeof(qcvm_global_t) * (function->num_args_and_locals + LOCALS_FIX));
-		
-		for (qcvm_global_t i = 0, arg = function->first_arg; i < (function->num_args_and_locals + LOCALS_FIX); i++, arg++)
-		{
-			const void *ptr = qcvm_get_global(vm, (qcvm_global_t)arg);
+		spill = !frame && (vm->saves_locals[function - vm->functions] || vm->state.reentered || vm->state.unwindowed);
 
-			if (qcvm_string_list_has_ref(vm, ptr, NULL))
-				qcvm_stack_push_ref_string(cur_stack, qcvm_string_list_pop_ref(vm, ptr));
+		if (spill)
+		{
+			memcpy(cur_stack->locals, qcvm_get_global(vm, function->first_arg), sizeof(qcvm_global_t) * (function->num_args_and_locals + LOCALS_FIX));
+		
+			if (vm->dynamic_strings.ref_storage_stored)
+			{
+				for (qcvm_global_t i = 0, arg = function->first_arg; i < (function->num_args_and_locals + LOCALS_FIX); i++, arg++)
+				{
+					const void *ptr = qcvm_get_global(vm, (qcvm_global_t)arg);
+
+					if (qcvm_string_list_has_ref(vm, ptr, NULL))
+						qcvm_stack_push_ref_string(cur_stack, qcvm_string_list_pop_ref(vm, ptr));
+				}
+			}
 		}
 
 #if ALLOW_INSTRUMENTING
@@ -1157,10 +1590,32 @@ static void qcvm_enter(qcvm_t *vm, qcvm_function_t *function)
 	// set up current stack
 	new_stack->function = function;
 	new_stack->statement = &vm->statements[function->id - 1];
+	new_stack->frame = frame;
+	new_stack->spilled = spill;
 
-	// copy parameters
-	for (qcvm_global_t i = 0, arg_id = function->first_arg; i < function->num_args; arg_id += function->arg_sizes[i], i++)
-		qcvm_copy_globals(vm, arg_id, qcvm_global_offset(GLOBAL_PARM0, i * 3), sizeof(qcvm_global_t) * function->arg_sizes[i]);
+	if (frame)
+	{
+		new_stack->frame_delta = vm->state.frame_delta = (uintptr_t)frame - (uintptr_t)qcvm_get_global(vm, function->first_arg);
+
+		// copy parameters
+		for (qcvm_global_t i = 0, arg = 0; i < function->num_args; arg += function->arg_sizes[i], i++)
+		{
+			const qcvm_global_t *src = qcvm_get_global(vm, qcvm_global_offset(GLOBAL_PARM0, i * 3));
+
+			memcpy(frame + arg, src, sizeof(qcvm_global_t) * function->arg_sizes[i]);
+
+			if (vm->dynamic_strings.ref_storage_stored)
+				qcvm_string_list_mark_refs_copied(vm, src, frame + arg, function->arg_sizes[i]);
+		}
+	}
+	else
+	{
+		new_stack->frame_delta = vm->state.frame_delta = 0;
+
+		// copy parameters
+		for (qcvm_global_t i = 0, arg_id = function->first_arg; i < function->num_args; arg_id += function->arg_sizes[i], i++)
+			qcvm_copy_globals(vm, arg_id, qcvm_global_offset(GLOBAL_PARM0, i * 3), sizeof(qcvm_global_t) * function->arg_sizes[i]);
+	}
 
 #if ALLOW_INSTRUMENTING
 	if (vm->profiling.flags & (PROFILE_FUNCTIONS | PROFILE_FIELDS))
@@ -1187,14 +1642,32 @@ static void qcvm_leave(qcvm_t *vm)
 	qcvm_state_stack_pop(&vm->state);
 	qcvm_stack_t *prev_stack = (vm->state.current == -1) ? NULL : &vm->state.stack[vm->state.current];
 
+	// the frame's locals die with it, so drop anything they were holding on to
+	if (current_stack->frame)
+	{
+		const size_t frame_size = vm->frame_sizes[current_stack->function - vm->functions];
+
+		if (vm->dynamic_strings.ref_storage_stored)
+			qcvm_string_list_check_ref_unset(vm, current_stack->frame, frame_size, true);
+
+		vm->state.frames_size -= frame_size;
+	}
+	else if (vm->frame_sizes[current_stack->function - vm->functions])
+		vm->state.unwindowed--;
+
+	vm->state.frame_delta = prev_stack ? prev_stack->frame_delta : 0;
+
 	if (prev_stack && current_stack->function->num_args_and_locals)
 	{
-		memcpy(qcvm_get_global(vm, current_stack->function->first_arg), prev_stack->locals, sizeof(qcvm_global_t) * (current_stack->function->num_args_and_locals + LOCALS_FIX));
+		if (current_stack->spilled)
+		{
+			memcpy(qcvm_get_global(vm, current_stack->function->first_arg), prev_stack->locals, sizeof(qcvm_global_t) * (current_stack->function->num_args_and_locals + LOCALS_FIX));
 
-		for (const qcvm_string_backup_t *str = prev_stack->ref_strings; str < prev_stack->ref_strings + prev_stack->ref_strings_size; str++)
-			qcvm_string_list_push_ref(vm, str);
+			for (const qcvm_string_backup_t *str = prev_stack->ref_strings; str < prev_stack->ref_strings + prev_stack->ref_strings_size; str++)
+				qcvm_string_list_push_ref(vm, str);
 
-		prev_stack->ref_strings_size = 0;
+			prev_stack->ref_strings_size = 0;
+		}
 
 #if ALLOW_INSTRUMENTING
 		if (vm->profiling.flags & PROFILE_FUNCTIONS)
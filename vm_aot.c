@@ -0,0 +1,476 @@
+#define QCVM_INTERNAL
+#include "shared/shared.h"
+#include "vm.h"
+#include "vm_string.h"
+#include "vm_aot.h"
+
+#if ALLOW_AOT
+#define OPCODES_ONLY
+#include "vm_opcodes.h"
+#undef OPCODES_ONLY
+
+#ifdef WINDOWS
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+// Ahead-of-time translation of a whole progs to C. Every function becomes a C
+// function with a label per jump target; the same simple opcodes the JIT inlines
+// are written out as plain C on the globals, and everything else goes back through
+// qcvm_run_statement so it runs the interpreter's own handler. The generated code
+// only knows the small interface below, which the game DLL hands it when loading.
+
+enum { QCVM_AOT_VERSION = 2 };
+
+enum { AOT_MAX_STATEMENTS = 0x10000 };
+
+#define QCVM_AOT_STRINGIFY(...) #__VA_ARGS__
+
+// this is compiled here and also pasted into the generated source, so the
+// two sides can't disagree about the layout.
+#define QCVM_AOT_INTERFACE(...) \
+	__VA_ARGS__ \
+	static const char qcvm_aot_interface[] = QCVM_AOT_STRINGIFY(__VA_ARGS__);
+
+QCVM_AOT_INTERFACE(
+typedef union
+{
+	float	f;
+	int32_t	i;
+} qcvm_aot_global_t;
+
+typedef struct
+{
+	uint32_t			version;
+	qcvm_aot_global_t	*globals;
+	const size_t		*ref_storage_stored;
+	const uintptr_t		*frame_delta;
+	int32_t				(*run_statement)(qcvm_t *vm, size_t index);
+	void				(*set)(qcvm_t *vm, qcvm_aot_global_t *dst, size_t span);
+	void				(*copy)(qcvm_t *vm, const qcvm_aot_global_t *src, qcvm_aot_global_t *dst, size_t span);
+} qcvm_aot_import_t;
+
+typedef struct
+{
+	uint32_t	version;
+	uint64_t	checksum;
+	size_t		num_functions;
+	void		(*const *functions)(qcvm_t *vm);
+} qcvm_aot_export_t;
+
+typedef const qcvm_aot_export_t *(*qcvm_aot_main_t)(const qcvm_aot_import_t *import);
+)
+
+static int32_t qcvm_aot_run_statement(qcvm_t *vm, size_t index)
+{
+	return qcvm_run_statement(vm, index);
+}
+
+static void qcvm_aot_set(qcvm_t *vm, qcvm_aot_global_t *dst, size_t span)
+{
+	qcvm_string_list_check_ref_unset(vm, dst, span, false);
+}
+
+static void qcvm_aot_copy(qcvm_t *vm, const qcvm_aot_global_t *src, qcvm_aot_global_t *dst, size_t span)
+{
+	qcvm_string_list_mark_refs_copied(vm, src, dst, span);
+}
+
+// FNV-1a over everything the generated code bakes in
+static uint64_t qcvm_aot_hash(uint64_t hash, const void *data, const size_t size)
+{
+	for (const uint8_t *p = (const uint8_t *)data; p < (const uint8_t *)data + size; p++)
+		hash = (hash ^ *p) * 0x100000001B3ull;
+
+	return hash;
+}
+
+static uint64_t qcvm_aot_checksum(const qcvm_t *vm)
+{
+	uint64_t hash = 0xCBF29CE484222325ull;
+
+	hash = qcvm_aot_hash(hash, &vm->global_size, sizeof(vm->global_size));
+
+	for (const qcvm_statement_t *s = vm->statements; s < vm->statements + vm->statements_size; s++)
+	{
+		const qcvm_opcode_t code = qcvm_unfused_opcode(s->opcode & ~OP_BREAKPOINT);
+		hash = qcvm_aot_hash(hash, &code, sizeof(code));
+		hash = qcvm_aot_hash(hash, &s->args, sizeof(s->args));
+	}
+
+	for (const qcvm_function_t *f = vm->functions; f < vm->functions + vm->functions_size; f++)
+	{
+		hash = qcvm_aot_hash(hash, &f->id, sizeof(f->id));
+		hash = qcvm_aot_hash(hash, &f->first_arg, sizeof(f->first_arg));
+		hash = qcvm_aot_hash(hash, &f->num_args_and_locals, sizeof(f->num_args_and_locals));
+		hash = qcvm_aot_hash(hash, &vm->frame_sizes[f - vm->functions], sizeof(*vm->frame_sizes));
+	}
+
+	return hash;
+}
+
+// plain C for the simple opcodes; returns false if it has to go through the handler
+static bool qcvm_aot_write_native(FILE *fp, const qcvm_t *vm, const qcvm_decoded_statement_t *s, const qcvm_opcode_t code)
+{
+	const qcvm_global_t a = s->args.a, b = s->args.b, c = s->args.c;
+	// windowed locals are in the frame, f, rather than in g
+	const char ga = s->frame_a ? 'f' : 'g', gb = s->frame_b ? 'f' : 'g', gc = s->frame_c ? 'f' : 'g';
+	const char *op;
+
+	switch (code)
+	{
+	case OP_STORE_F:
+	case OP_STORE_S:
+	case OP_STORE_ENT:
+	case OP_STORE_FLD:
+	case OP_STORE_FNC:
+	case OP_STORE_I:
+	case OP_STORE_P:
+		if (!s->a || !s->b)
+			return false;
+
+		fprintf(fp, "\t%c[%u] = %c[%u];", gb, b, ga, a);
+
+		if (!qcvm_opcode_is_unchecked_store(s->opcode))
+			fprintf(fp, " COPY(%c[%u], %c[%u], 1);", ga, a, gb, b);
+
+		fprintf(fp, "\n");
+		return true;
+	case OP_STORE_V:
+		if (!s->a || !s->b)
+			return false;
+
+		fprintf(fp, "\t%c[%u] = %c[%u]; %c[%u] = %c[%u]; %c[%u] = %c[%u];", gb, b, ga, a, gb, b + 1, ga, a + 1, gb, b + 2, ga, a + 2);
+
+		if (!qcvm_opcode_is_unchecked_store(s->opcode))
+			fprintf(fp, " COPY(%c[%u], %c[%u], 3);", ga, a, gb, b);
+
+		fprintf(fp, "\n");
+		return true;
+	}
+
+	if (!s->a || !s->b || !s->c || s->c == vm->global_data)
+		return false;
+
+	switch (code)
+	{
+	case OP_ADD_F:
+		op = "+";
+		goto float_op;
+	case OP_SUB_F:
+		op = "-";
+		goto float_op;
+	case OP_MUL_F:
+		op = "*";
+		goto float_op;
+	case OP_DIV_F:
+		op = "/";
+		goto float_op;
+	case OP_EQ_F:
+		op = "==";
+		goto float_op;
+	case OP_NE_F:
+		op = "!=";
+		goto float_op;
+	case OP_LT_F:
+		op = "<";
+		goto float_op;
+	case OP_GT_F:
+		op = ">";
+		goto float_op;
+	case OP_LE_F:
+		op = "<=";
+		goto float_op;
+	case OP_GE_F:
+		op = ">=";
+float_op:
+		fprintf(fp, "\t%c[%u].f = %c[%u].f %s %c[%u].f; SET(%c[%u], 1);\n", gc, c, ga, a, op, gb, b, gc, c);
+		return true;
+	case OP_NOT_F:
+		fprintf(fp, "\t%c[%u].f = !%c[%u].f; SET(%c[%u], 1);\n", gc, c, ga, a, gc, c);
+		return true;
+
+	// signed overflow would be undefined in C, so do these unsigned
+	case OP_ADD_I:
+		op = "+";
+		goto int_op;
+	case OP_SUB_I:
+		op = "-";
+		goto int_op;
+	case OP_MUL_I:
+		op = "*";
+int_op:
+		fprintf(fp, "\t%c[%u].i = (int32_t)((uint32_t)%c[%u].i %s (uint32_t)%c[%u].i); SET(%c[%u], 1);\n", gc, c, ga, a, op, gb, b, gc, c);
+		return true;
+
+	// vector results are all computed before storing, in case c overlaps a or b
+	case OP_ADD_V:
+	case OP_SUB_V:
+		op = (code == OP_ADD_V) ? "+" : "-";
+		fprintf(fp, "\t{ const float x = %c[%u].f %s %c[%u].f, y = %c[%u].f %s %c[%u].f, z = %c[%u].f %s %c[%u].f; ", ga, a, op, gb, b, ga, a + 1, op, gb, b + 1, ga, a + 2, op, gb, b + 2);
+		fprintf(fp, "%c[%u].f = x; %c[%u].f = y; %c[%u].f = z; } SET(%c[%u], 3);\n", gc, c, gc, c + 1, gc, c + 2, gc, c);
+		return true;
+	case OP_MUL_VF:
+	case OP_MUL_FV:
+	{
+		const qcvm_global_t v = (code == OP_MUL_VF) ? a : b, f = (code == OP_MUL_VF) ? b : a;
+		const char gv = (code == OP_MUL_VF) ? ga : gb, gf = (code == OP_MUL_VF) ? gb : ga;
+		fprintf(fp, "\t{ const float x = %c[%u].f * %c[%u].f, y = %c[%u].f * %c[%u].f, z = %c[%u].f * %c[%u].f; ", gv, v, gf, f, gv, v + 1, gf, f, gv, v + 2, gf, f);
+		fprintf(fp, "%c[%u].f = x; %c[%u].f = y; %c[%u].f = z; } SET(%c[%u], 3);\n", gc, c, gc, c + 1, gc, c + 2, gc, c);
+		return true;
+	}
+	}
+
+	return false;
+}
+
+static void qcvm_aot_write_statement(FILE *fp, const qcvm_t *vm, const size_t index)
+{
+	const qcvm_decoded_statement_t *s = &vm->decoded_statements[index];
+	const qcvm_opcode_t code = qcvm_unfused_opcode(s->opcode);
+	const size_t target = index + qcvm_branch_offset(code, s->args);
+	const char ga = s->frame_a ? 'f' : 'g';
+
+	if (code == OP_DONE || code == OP_RETURN)
+		fprintf(fp, "\tRUN(%zu); return;\n", index);
+	else if (code == OP_GOTO)
+		fprintf(fp, "\tgoto s%zu;\n", target);
+	else if (qcvm_opcode_is_branch(code))
+	{
+		if (s->a && code == OP_IF_I)
+			fprintf(fp, "\tif (%c[%u].f) goto s%zu;\n", ga, s->args.a, target);
+		else if (s->a && code == OP_IFNOT_I)
+			fprintf(fp, "\tif (!%c[%u].f) goto s%zu;\n", ga, s->args.a, target);
+		else if (s->a && code == OP_IF_F)
+			fprintf(fp, "\tif (%c[%u].i) goto s%zu;\n", ga, s->args.a, target);
+		else if (s->a && code == OP_IFNOT_F)
+			fprintf(fp, "\tif (!%c[%u].i) goto s%zu;\n", ga, s->args.a, target);
+		else
+			fprintf(fp, "\tif (RUN(%zu)) goto s%zu;\n", index, target);
+	}
+	else if (!qcvm_aot_write_native(fp, vm, s, code))
+		fprintf(fp, "\tRUN(%zu); // %s\n", index, opcode_names[code]);
+}
+
+static bool qcvm_aot_write_function(FILE *fp, qcvm_t *vm, const size_t func_index, uint8_t *reachable, uint8_t *targets)
+{
+	const qcvm_function_t *function = &vm->functions[func_index];
+	const size_t entry = (size_t)function->id;
+	size_t first = entry, last = entry;
+
+	if (function->id <= 0)
+		return false;
+
+	const bool valid = qcvm_find_reachable(vm, entry, reachable, &first, &last, AOT_MAX_STATEMENTS);
+
+	if (valid)
+	{
+		targets[entry] = entry != first;
+
+		for (size_t i = first; i <= last; i++)
+		{
+			if (!reachable[i])
+				continue;
+
+			const qcvm_opcode_t code = qcvm_unfused_opcode(vm->decoded_statements[i].opcode);
+
+			if (code == OP_GOTO || qcvm_opcode_is_branch(code))
+				targets[i + qcvm_branch_offset(code, vm->statements[i].args)] = true;
+		}
+
+		fprintf(fp, "// %s\nstatic void qcvm_aot_func_%zu(qcvm_t *vm)\n{\n", qcvm_get_string(vm, function->name_index), func_index);
+		fprintf(fp, "\tqcvm_aot_global_t *const g = qi->globals;\n");
+
+		// the frame stack never moves, so this holds until we return
+		if (vm->frame_sizes[func_index])
+			fprintf(fp, "\tqcvm_aot_global_t *const f = (qcvm_aot_global_t *)((uintptr_t)g + *qi->frame_delta);\n");
+
+		if (entry != first)
+			fprintf(fp, "\tgoto s%zu;\n", entry);
+
+		for (size_t i = first; i <= last; i++)
+		{
+			if (!reachable[i])
+				continue;
+
+			if (targets[i])
+				fprintf(fp, "s%zu:\n", i);
+
+			qcvm_aot_write_statement(fp, vm, i);
+		}
+
+		fprintf(fp, "}\n\n");
+	}
+
+	// only clear what we touched, these span the whole statement list
+	memset(reachable + first, 0, last - first + 1);
+	memset(targets + first, 0, last - first + 1);
+	return valid;
+}
+
+void qcvm_aot_generate(qcvm_t *vm, const char *filename)
+{
+	FILE *fp = fopen(filename, "wb");
+
+	if (!fp)
+	{
+		vm->warning("AOT: can't write to %s\n", filename);
+		return;
+	}
+
+	fprintf(fp, "// generated by %s from %s; do not edit.\n", vm->engine_name, vm->path);
+	fprintf(fp, "// build this as a shared library and point qc_aot_library at it.\n");
+	fprintf(fp, "#include <stddef.h>\n#include <stdint.h>\n\n");
+	fprintf(fp, "#ifdef _WIN32\n#define QCVM_AOT_EXPORT __declspec(dllexport)\n#else\n#define QCVM_AOT_EXPORT __attribute__((visibility(\"default\")))\n#endif\n\n");
+	fprintf(fp, "typedef struct qcvm_s qcvm_t;\n\n%s\n\n", qcvm_aot_interface);
+	fprintf(fp, "static const qcvm_aot_import_t *qi;\n\n");
+	fprintf(fp, "#define SET(p, n) if (*qi->ref_storage_stored) qi->set(vm, &p, n)\n");
+	fprintf(fp, "#define COPY(s, d, n) if (*qi->ref_storage_stored) qi->copy(vm, &s, &d, n)\n");
+	fprintf(fp, "#define RUN(i) qi->run_statement(vm, i)\n\n");
+
+	uint8_t *reachable = (uint8_t *)qcvm_alloc(vm, vm->statements_size);
+	uint8_t *targets = (uint8_t *)qcvm_alloc(vm, vm->statements_size);
+	bool *written = (bool *)qcvm_alloc(vm, sizeof(bool) * vm->functions_size);
+	size_t num_written = 0;
+
+	memset(reachable, 0, vm->statements_size);
+	memset(targets, 0, vm->statements_size);
+
+	for (size_t i = 0; i < vm->functions_size; i++)
+		if ((written[i] = qcvm_aot_write_function(fp, vm, i, reachable, targets)))
+			num_written++;
+
+	fprintf(fp, "static void (*const functions[%zu])(qcvm_t *vm) = {\n", vm->functions_size);
+
+	for (size_t i = 0; i < vm->functions_size; i++)
+	{
+		if (written[i])
+			fprintf(fp, "\tqcvm_aot_func_%zu,\n", i);
+		else
+			fprintf(fp, "\tNULL,\n");
+	}
+
+	fprintf(fp, "};\n\n");
+	fprintf(fp, "static const qcvm_aot_export_t exports = { %u, 0x%" PRIx64 "ull, %zu, functions };\n\n", QCVM_AOT_VERSION, qcvm_aot_checksum(vm), vm->functions_size);
+	fprintf(fp, "QCVM_AOT_EXPORT const qcvm_aot_export_t *qcvm_aot_main(const qcvm_aot_import_t *import)\n{\n");
+	fprintf(fp, "\tif (import->version != %u)\n\t\treturn NULL;\n\n\tqi = import;\n\treturn &exports;\n}\n", QCVM_AOT_VERSION);
+
+	fclose(fp);
+
+	qcvm_mem_free(vm, written);
+	qcvm_mem_free(vm, targets);
+	qcvm_mem_free(vm, reachable);
+
+	vm->debug_print(qcvm_temp_format(vm, "AOT: wrote %zu/%zu functions to %s\n", num_written, vm->functions_size, filename));
+}
+
+static void *qcvm_aot_open(const char *filename)
+{
+#ifdef WINDOWS
+	return (void *)LoadLibraryA(filename);
+#else
+	return dlopen(filename, RTLD_NOW | RTLD_LOCAL);
+#endif
+}
+
+static void *qcvm_aot_symbol(void *library, const char *name)
+{
+#ifdef WINDOWS
+	return (void *)GetProcAddress((HMODULE)library, name);
+#else
+	return dlsym(library, name);
+#endif
+}
+
+static void qcvm_aot_close(void *library)
+{
+#ifdef WINDOWS
+	FreeLibrary((HMODULE)library);
+#else
+	dlclose(library);
+#endif
+}
+
+bool qcvm_aot_load(qcvm_t *vm, const char *filename)
+{
+	void *library = qcvm_aot_open(filename);
+
+	if (!library)
+	{
+		vm->warning("AOT: couldn't load %s\n", filename);
+		return false;
+	}
+
+	const qcvm_aot_main_t aot_main = (qcvm_aot_main_t)qcvm_aot_symbol(library, "qcvm_aot_main");
+
+	if (!aot_main)
+	{
+		vm->warning("AOT: %s isn't a translated progs\n", filename);
+		qcvm_aot_close(library);
+		return false;
+	}
+
+	qcvm_aot_import_t *import = (qcvm_aot_import_t *)qcvm_alloc(vm, sizeof(qcvm_aot_import_t));
+	*import = (qcvm_aot_import_t) {
+		.version = QCVM_AOT_VERSION,
+		.globals = (qcvm_aot_global_t *)vm->global_data,
+		.ref_storage_stored = &vm->dynamic_strings.ref_storage_stored,
+		.frame_delta = &vm->state.frame_delta,
+		.run_statement = qcvm_aot_run_statement,
+		.set = qcvm_aot_set,
+		.copy = qcvm_aot_copy
+	};
+
+	const qcvm_aot_export_t *exports = aot_main(import);
+
+	if (!exports || exports->version != QCVM_AOT_VERSION || exports->num_functions != vm->functions_size || exports->checksum != qcvm_aot_checksum(vm))
+	{
+		vm->warning("AOT: %s was built from a different progs or version, ignoring it\n", filename);
+		qcvm_mem_free(vm, import);
+		qcvm_aot_close(library);
+		return false;
+	}
+
+	vm->aot.library = library;
+	vm->aot.import = import;
+	vm->aot.functions = (qcvm_aot_code_t *)qcvm_alloc(vm, sizeof(qcvm_aot_code_t) * vm->functions_size);
+
+	size_t num_loaded = 0;
+
+	for (size_t i = 0; i < vm->functions_size; i++)
+		if ((vm->aot.functions[i] = exports->functions[i]))
+			num_loaded++;
+
+	vm->debug_print(qcvm_temp_format(vm, "AOT: loaded %zu/%zu functions from %s\n", num_loaded, vm->functions_size, filename));
+	return true;
+}
+
+bool qcvm_aot_execute(qcvm_t *vm, qcvm_function_t *function)
+{
+	if (!vm->aot.functions)
+		return false;
+
+	const qcvm_aot_code_t code = vm->aot.functions[function - vm->functions];
+
+	if (!code || !qcvm_can_run_native(vm) || vm->state.native_depth >= MAX_NATIVE_DEPTH)
+		return false;
+
+	qcvm_enter(vm, function);
+	vm->state.native_depth++;
+	code(vm);
+	vm->state.native_depth--;
+	return true;
+}
+
+void qcvm_aot_free(qcvm_t *vm)
+{
+	if (!vm->aot.library)
+		return;
+
+	qcvm_mem_free(vm, vm->aot.functions);
+	qcvm_mem_free(vm, vm->aot.import);
+	qcvm_aot_close(vm->aot.library);
+	vm->aot = (qcvm_aot_t) { 0 };
+}
+#endif
@@ -0,0 +1,18 @@
+#pragma once
+
+#if ALLOW_AOT
+// writes C source for every function in the loaded progs; this has to be
+// called after qcvm_check.
+void qcvm_aot_generate(qcvm_t *vm, const char *filename);
+
+// loads a library built from qcvm_aot_generate's output. returns false (and
+// warns) if it can't be loaded or was built from a different progs, in which
+// case everything is just interpreted as normal.
+bool qcvm_aot_load(qcvm_t *vm, const char *filename);
+
+// runs the function's translated code if there is any; returns false if the
+// interpreter should run it instead.
+bool qcvm_aot_execute(qcvm_t *vm, qcvm_function_t *function);
+
+void qcvm_aot_free(qcvm_t *vm);
+#endif
@@ -0,0 +1,325 @@
+#define QCVM_INTERNAL
+#include "shared/shared.h"
+#include "vm.h"
+#include "vm_string.h"
+#include "vm_cache.h"
+#include "vm_mapping.h"
+
+#if ALLOW_PROGS_CACHE
+// Everything qcvm_load & qcvm_check work out from the progs (string lengths &
+// hashes, the patched statements, the field layout, which functions get frames)
+// is written next to it, and on the next load the file is mapped and used in
+// place of working it out again. A cache is only used if it was built from the
+// same progs bytes by the same build of the game; anything else is ignored and
+// overwritten once the load is done.
+
+// bump this whenever a pass whose results are cached changes, or the layout
+// of anything stored does; qcvm_cache_build_key only catches the tables.
+enum { QCVM_CACHE_VERSION = 4 };
+
+enum { CACHE_ALIGN = 16 };
+
+static const char qcvm_cache_magic[4] = { 'Q', 'C', 'V', 'C' };
+
+typedef struct
+{
+	uint64_t	offset;
+	uint64_t	size;
+} qcvm_cache_offset_t;
+
+typedef struct
+{
+	char				magic[4];
+	uint32_t			version;
+	uint64_t			key;
+	uint64_t			fields_key;
+	qcvm_cache_offset_t	sections[CACHE_NUM_SECTIONS];
+} qcvm_cache_header_t;
+
+// FNV-1a
+uint64_t qcvm_cache_hash(uint64_t hash, const void *data, const size_t size)
+{
+	for (const uint8_t *p = (const uint8_t *)data; p < (const uint8_t *)data + size; p++)
+		hash = (hash ^ *p) * 0x100000001B3ull;
+
+	return hash;
+}
+
+// the progs itself, and anything about this build that changes what's derived from it
+static uint64_t qcvm_cache_key(qcvm_t *vm, FILE *fp)
+{
+	const uint32_t version = QCVM_CACHE_VERSION;
+	const uint8_t sizes[] = { sizeof(size_t), sizeof(bool), sizeof(qcvm_statement_t), sizeof(qcvm_definition_t) };
+	uint64_t hash = 0xCBF29CE484222325ull;
+	uint8_t *buffer = (uint8_t *)qcvm_alloc(vm, 0x10000);
+	size_t num_read;
+
+	hash = qcvm_cache_hash(hash, &version, sizeof(version));
+	hash = qcvm_cache_build_key(hash);
+	hash = qcvm_cache_hash(hash, sizes, sizeof(sizes));
+	hash = qcvm_cache_hash(hash, vm->engine_name, strlen(vm->engine_name));
+
+	fseek(fp, 0, SEEK_SET);
+
+	while ((num_read = fread(buffer, 1, 0x10000, fp)))
+		hash = qcvm_cache_hash(hash, buffer, num_read);
+
+	qcvm_mem_free(vm, buffer);
+	return hash;
+}
+
+// the engine's fields, and line numbers since statements on different lines aren't fused
+static uint64_t qcvm_cache_fields_key(const qcvm_t *vm)
+{
+	uint64_t hash = qcvm_cache_hash(vm->cache.key, &vm->system_edict_size, sizeof(vm->system_edict_size));
+
+	for (const qcvm_system_field_t *field = vm->system_fields; field < vm->system_fields + vm->system_fields_size; field++)
+	{
+		const uint64_t values[] = { (uint64_t)(field->def - vm->definitions), (uint64_t)(field->field - vm->fields), field->offset, field->span };
+		hash = qcvm_cache_hash(hash, values, sizeof(values));
+	}
+
+	const bool has_lines = vm->linenumbers != NULL;
+	hash = qcvm_cache_hash(hash, &has_lines, sizeof(has_lines));
+
+	if (has_lines)
+		hash = qcvm_cache_hash(hash, vm->linenumbers, sizeof(*vm->linenumbers) * vm->statements_size);
+
+	return hash;
+}
+
+static inline const qcvm_cache_header_t *qcvm_cache_header(const qcvm_t *vm)
+{
+	return (const qcvm_cache_header_t *)vm->cache.mapping.data;
+}
+
+void qcvm_cache_open(qcvm_t *vm, FILE *fp, const char *filename)
+{
+	// progs.dat -> progs.cache
+	const char *name = strrchr(filename, '/'), *backslash = strrchr(filename, '\\');
+
+	if (!name || (backslash && backslash > name))
+		name = backslash;
+
+	const char *ext = strrchr(name ? name : filename, '.');
+	const size_t base_len = ext ? (size_t)(ext - filename) : strlen(filename);
+
+	vm->cache.filename = (char *)qcvm_alloc(vm, base_len + sizeof(".cache"));
+	memcpy(vm->cache.filename, filename, base_len);
+	memcpy(vm->cache.filename + base_len, ".cache", sizeof(".cache"));
+
+	vm->cache.key = qcvm_cache_key(vm, fp);
+
+	if (!qcvm_map_file(vm->cache.filename, false, &vm->cache.mapping))
+		return;
+
+	const qcvm_cache_header_t *header = qcvm_cache_header(vm);
+	bool valid = vm->cache.mapping.size >= sizeof(*header) && !memcmp(header->magic, qcvm_cache_magic, sizeof(qcvm_cache_magic)) &&
+		header->version == QCVM_CACHE_VERSION && header->key == vm->cache.key;
+
+	for (size_t i = 0; valid && i < CACHE_NUM_SECTIONS; i++)
+		if (header->sections[i].offset > vm->cache.mapping.size || header->sections[i].size > vm->cache.mapping.size - header->sections[i].offset)
+			valid = false;
+
+	if (!valid)
+	{
+		qcvm_unmap_file(&vm->cache.mapping);
+		return;
+	}
+
+	qcvm_debug(vm, "QCVM: using cache %s\n", vm->cache.filename);
+}
+
+void qcvm_cache_check_fields(qcvm_t *vm)
+{
+	vm->cache.fields_valid = vm->cache.mapping.data && qcvm_cache_header(vm)->fields_key == qcvm_cache_fields_key(vm);
+
+	// qcvm_setup_fields writes to some globals; the ones it changes are
+	// found by comparing against these once it's done
+	if (!vm->cache.fields_valid)
+	{
+		vm->cache.unchecked_globals = (qcvm_global_t *)qcvm_alloc(vm, sizeof(qcvm_global_t) * vm->global_size);
+		memcpy(vm->cache.unchecked_globals, vm->global_data, sizeof(qcvm_global_t) * vm->global_size);
+	}
+}
+
+const void *qcvm_cache_section(const qcvm_t *vm, const qcvm_cache_section_t section, size_t *size)
+{
+	if (!vm->cache.mapping.data || (section >= CACHE_FIRST_FIELDS_SECTION && !vm->cache.fields_valid))
+		return NULL;
+
+	const qcvm_cache_offset_t *offset = &qcvm_cache_header(vm)->sections[section];
+	*size = (size_t)offset->size;
+	return (const uint8_t *)vm->cache.mapping.data + offset->offset;
+}
+
+typedef struct
+{
+	const void	*data;
+	size_t		size;
+} qcvm_cache_data_t;
+
+static bool qcvm_cache_write_file(qcvm_t *vm, const char *filename, const qcvm_cache_data_t *sections)
+{
+	FILE *fp = fopen(filename, "wb");
+
+	if (!fp)
+		return false;
+
+	qcvm_cache_header_t header = {
+		.version = QCVM_CACHE_VERSION,
+		.key = vm->cache.key,
+		.fields_key = qcvm_cache_fields_key(vm)
+	};
+	uint64_t offset = (sizeof(header) + CACHE_ALIGN - 1) & ~(uint64_t)(CACHE_ALIGN - 1);
+
+	memcpy(header.magic, qcvm_cache_magic, sizeof(qcvm_cache_magic));
+
+	for (size_t i = 0; i < CACHE_NUM_SECTIONS; i++)
+	{
+		header.sections[i] = (qcvm_cache_offset_t) { offset, sections[i].size };
+		offset = (offset + sections[i].size + CACHE_ALIGN - 1) & ~(uint64_t)(CACHE_ALIGN - 1);
+	}
+
+	static const uint8_t padding[CACHE_ALIGN] = { 0 };
+	bool written = fwrite(&header, sizeof(header), 1, fp) == 1;
+	uint64_t position = sizeof(header);
+
+	for (size_t i = 0; written && i < CACHE_NUM_SECTIONS; i++)
+	{
+		written = fwrite(padding, 1, (size_t)(header.sections[i].offset - position), fp) == header.sections[i].offset - position &&
+			fwrite(sections[i].data, 1, sections[i].size, fp) == sections[i].size;
+		position = header.sections[i].offset + sections[i].size;
+	}
+
+	return !fclose(fp) && written;
+}
+
+void qcvm_cache_write(qcvm_t *vm)
+{
+	if (!vm->cache.enabled || vm->cache.fields_valid)
+		return;
+
+	qcvm_cache_data_t sections[CACHE_NUM_SECTIONS];
+
+	sections[CACHE_STRING_LENGTHS] = (qcvm_cache_data_t) { vm->string_lengths, sizeof(size_t) * vm->string_size };
+	sections[CACHE_STRING_FOLDED_HASHES] = (qcvm_cache_data_t) { vm->string_folded_hashes, sizeof(uint32_t) * vm->string_size };
+
+	// hash chains as indices into the entries
+	const size_t num_buckets = (size_t)vm->string_hash_mask + 1;
+	uint32_t *buckets = (uint32_t *)qcvm_alloc(vm, sizeof(uint32_t) * num_buckets);
+	size_t num_entries = 0;
+
+	for (size_t i = 0; i < num_buckets; i++)
+	{
+		if (vm->string_hashes[i])
+			buckets[i] = (uint32_t)(vm->string_hashes[i] - vm->string_hashes_data) + 1;
+
+		for (const qcvm_string_hash_t *hashed = vm->string_hashes[i]; hashed; hashed = hashed->hash_next)
+			num_entries++;
+	}
+
+	qcvm_cache_string_hash_t *entries = (qcvm_cache_string_hash_t *)qcvm_alloc(vm, sizeof(qcvm_cache_string_hash_t) * maxsz(num_entries, 1));
+
+	for (size_t i = 0; i < num_entries; i++)
+	{
+		const qcvm_string_hash_t *hashed = &vm->string_hashes_data[i];
+
+		entries[i] = (qcvm_cache_string_hash_t) {
+			.offset = (uint32_t)(hashed->str - vm->string_data),
+			.hash_value = hashed->hash_value,
+			.next = hashed->hash_next ? (uint32_t)(hashed->hash_next - vm->string_hashes_data) + 1 : 0
+		};
+	}
+
+	sections[CACHE_STRING_HASH_BUCKETS] = (qcvm_cache_data_t) { buckets, sizeof(uint32_t) * num_buckets };
+	sections[CACHE_STRING_HASH_ENTRIES] = (qcvm_cache_data_t) { entries, sizeof(qcvm_cache_string_hash_t) * num_entries };
+
+	// already position-independent
+	sections[CACHE_SYMBOLS] = (qcvm_cache_data_t) { vm->symbols, sizeof(qcvm_symbol_t) * vm->symbols_size };
+	sections[CACHE_SYMBOL_BUCKETS] = (qcvm_cache_data_t) { vm->symbol_buckets, sizeof(uint32_t) * ((size_t)vm->symbol_mask + 1) };
+
+	sections[CACHE_STATEMENTS] = (qcvm_cache_data_t) { vm->statements, sizeof(qcvm_statement_t) * vm->statements_size };
+	sections[CACHE_FIELDS] = (qcvm_cache_data_t) { vm->fields, sizeof(qcvm_definition_t) * vm->fields_size };
+
+	size_t num_globals = 0;
+
+	for (size_t i = 0; i < vm->global_size; i++)
+		if (vm->global_data[i] != vm->cache.unchecked_globals[i])
+			num_globals++;
+
+	qcvm_cache_global_t *globals = (qcvm_cache_global_t *)qcvm_alloc(vm, sizeof(qcvm_cache_global_t) * maxsz(num_globals, 1));
+	num_globals = 0;
+
+	for (size_t i = 0; i < vm->global_size; i++)
+		if (vm->global_data[i] != vm->cache.unchecked_globals[i])
+			globals[num_globals++] = (qcvm_cache_global_t) { (qcvm_global_t)i, vm->global_data[i] };
+
+	sections[CACHE_FIELD_GLOBALS] = (qcvm_cache_data_t) { globals, sizeof(qcvm_cache_global_t) * num_globals };
+
+	uint32_t *field_map = (uint32_t *)qcvm_alloc(vm, sizeof(uint32_t) * maxsz(vm->field_real_size, 1));
+
+	for (size_t i = 0; i < vm->field_real_size; i++)
+		if (vm->field_map_by_id[i])
+			field_map[i] = (uint32_t)(vm->field_map_by_id[i] - vm->fields);
+
+	sections[CACHE_FIELD_MAP] = (qcvm_cache_data_t) { field_map, sizeof(uint32_t) * vm->field_real_size };
+	sections[CACHE_FRAME_SIZES] = (qcvm_cache_data_t) { vm->frame_sizes, sizeof(uint32_t) * vm->functions_size };
+	sections[CACHE_SAVES_LOCALS] = (qcvm_cache_data_t) { vm->saves_locals, sizeof(bool) * vm->functions_size };
+
+	uint8_t *frame_flags = (uint8_t *)qcvm_alloc(vm, maxsz(vm->statements_size, 1));
+
+	for (size_t i = 0; i < vm->statements_size; i++)
+	{
+		const qcvm_decoded_statement_t *s = &vm->decoded_statements[i];
+		frame_flags[i] = (s->frame_a ? CACHE_FRAME_A : 0) | (s->frame_b ? CACHE_FRAME_B : 0) | (s->frame_c ? CACHE_FRAME_C : 0);
+	}
+
+	sections[CACHE_FRAME_FLAGS] = (qcvm_cache_data_t) { frame_flags, vm->statements_size };
+
+	// written to the side & moved over, so a crash halfway can't leave a bad cache
+	const char *temp_filename = qcvm_temp_format(vm, "%s.tmp", vm->cache.filename);
+
+	if (!qcvm_cache_write_file(vm, temp_filename, sections))
+	{
+		vm->warning("QCVM WARNING: couldn't write progs cache %s\n", temp_filename);
+		remove(temp_filename);
+	}
+	else
+	{
+		remove(vm->cache.filename);
+
+		if (rename(temp_filename, vm->cache.filename))
+		{
+			vm->warning("QCVM WARNING: couldn't replace progs cache %s\n", vm->cache.filename);
+			remove(temp_filename);
+		}
+		else
+			qcvm_debug(vm, "QCVM: wrote cache %s\n", vm->cache.filename);
+	}
+
+	qcvm_mem_free(vm, frame_flags);
+	qcvm_mem_free(vm, field_map);
+	qcvm_mem_free(vm, globals);
+	qcvm_mem_free(vm, entries);
+	qcvm_mem_free(vm, buckets);
+
+	qcvm_mem_free(vm, vm->cache.unchecked_globals);
+	vm->cache.unchecked_globals = NULL;
+}
+
+void qcvm_cache_free(qcvm_t *vm)
+{
+	qcvm_unmap_file(&vm->cache.mapping);
+	vm->cache.fields_valid = false;
+
+	if (vm->cache.unchecked_globals)
+		qcvm_mem_free(vm, vm->cache.unchecked_globals);
+
+	if (vm->cache.filename)
+		qcvm_mem_free(vm, vm->cache.filename);
+
+	vm->cache.unchecked_globals = NULL;
+	vm->cache.filename = NULL;
+}
+#endif
@@ -0,0 +1,79 @@
+#pragma once
+
+// everything qcvm_load & qcvm_check derive from the progs that can be
+// stored as-is. the ones from CACHE_STATEMENTS on also depend on the
+// system fields the engine registers, so they're keyed separately.
+typedef enum
+{
+	CACHE_STRING_LENGTHS,
+	CACHE_STRING_FOLDED_HASHES,
+	CACHE_STRING_HASH_BUCKETS,
+	CACHE_STRING_HASH_ENTRIES,
+	CACHE_SYMBOLS,
+	CACHE_SYMBOL_BUCKETS,
+
+	CACHE_STATEMENTS,
+	CACHE_FIELDS,
+	CACHE_FIELD_GLOBALS,
+	CACHE_FIELD_MAP,
+	CACHE_FRAME_SIZES,
+	CACHE_SAVES_LOCALS,
+	CACHE_FRAME_FLAGS,
+
+	CACHE_NUM_SECTIONS,
+	CACHE_FIRST_FIELDS_SECTION = CACHE_STATEMENTS
+} qcvm_cache_section_t;
+
+// indices are 1-based; 0 is the end of a chain
+typedef struct
+{
+	uint32_t	offset;
+	uint32_t	hash_value;
+	uint32_t	next;
+} qcvm_cache_string_hash_t;
+
+// a global written by qcvm_setup_fields
+typedef struct
+{
+	qcvm_global_t	global;
+	qcvm_global_t	value;
+} qcvm_cache_global_t;
+
+// frame flags of a decoded statement
+enum
+{
+	CACHE_FRAME_A	= 1 << 0,
+	CACHE_FRAME_B	= 1 << 1,
+	CACHE_FRAME_C	= 1 << 2
+};
+
+#if ALLOW_PROGS_CACHE
+// FNV-1a, continuing from hash.
+uint64_t qcvm_cache_hash(uint64_t hash, const void *data, const size_t size);
+
+// in vm.c; folds in the opcode & pass tables, and when vm.c was built,
+// since those decide what's derived from the progs.
+uint64_t qcvm_cache_build_key(uint64_t hash);
+
+// called by qcvm_load once the header is read; hashes the progs and maps
+// its cache file, if there is one built from the same progs & build.
+void qcvm_cache_open(qcvm_t *vm, FILE *fp, const char *filename);
+
+// called by qcvm_check once the system fields are registered; the field
+// sections are only used if they were built against the same ones.
+void qcvm_cache_check_fields(qcvm_t *vm);
+
+// the contents of a section & its size, or NULL if it can't be used.
+// mapped read-only, so it must never be written to.
+const void *qcvm_cache_section(const qcvm_t *vm, const qcvm_cache_section_t section, size_t *size);
+
+// writes everything qcvm_check has derived, unless it all came from the cache.
+void qcvm_cache_write(qcvm_t *vm);
+
+void qcvm_cache_free(qcvm_t *vm);
+#else
+static inline const void *qcvm_cache_section(const qcvm_t *vm, const qcvm_cache_section_t section, size_t *size)
+{
+	return NULL;
+}
+#endif
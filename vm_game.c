@@ -105,16 +105,12 @@ static void QC_entity_key_parse(qcvm_t *vm)
 	const char *key = qcvm_argv_string(vm, 1);
 	const char *value = qcvm_argv_string(vm, 2);
 
-	qcvm_definition_hash_t *hashed = vm->definition_hashes[Q_hash_string(key, vm->definitions_size)];
+	const qcvm_definition_t *def = qcvm_find_definition(vm, key, TYPE_FIELD);
 
-	for (; hashed; hashed = hashed->hash_next)
-		if ((hashed->def->id & ~TYPE_GLOBAL) == TYPE_FIELD && !strcmp(qcvm_get_string(vm, hashed->def->name_index), key))
-			break;
-
-	if (!hashed)
+	if (!def)
 		qcvm_error(vm, "Bad field %s", key);
 
-	const qcvm_global_t field = vm->global_data[hashed->def->global_index];
+	const qcvm_global_t field = vm->global_data[def->global_index];
 
 	qcvm_definition_t *f = vm->field_map_by_id[field];
 
@@ -136,19 +132,14 @@ static void QC_struct_key_parse(qcvm_t *vm)
 	const char *value = qcvm_argv_string(vm, 2);
 	
 	const char *full_name = qcvm_temp_format(vm, "%s.%s", struct_name, key_name);
-	qcvm_definition_hash_t *hashed = vm->definition_hashes[Q_hash_string(full_name, vm->definitions_size)];
-
-	for (; hashed; hashed = hashed->hash_next)
-		if (!strcmp(qcvm_get_string(vm, hashed->def->name_index), full_name))
-			break;
+	qcvm_definition_t *g = qcvm_find_definition_by_name(vm, full_name);
 
-	if (!hashed)
+	if (!g)
 	{
 		qcvm_return_int32(vm, 0);
 		return;
 	}
 
-	qcvm_definition_t *g = hashed->def;
 	void *global = qcvm_get_global(vm, g->global_index);
 	QC_parse_value_into_ptr(vm, g->id & ~TYPE_GLOBAL, value, global);
 	qcvm_return_int32(vm, 1);
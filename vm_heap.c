@@ -29,10 +29,17 @@ static bool	qcvm_heap_resolve_pointer(const qcvm_t *vm, void *handle, const size
 	return false;
 }
 
+static void qcvm_heap_mark_strings(qcvm_t *vm, void *handle)
+{
+	qcvm_heap_t *list = (qcvm_heap_t *)handle;
+	qcvm_string_list_mark_span(vm, list->ptr, list->size / sizeof(qcvm_global_t));
+}
+
 static const qcvm_handle_descriptor_t list_descriptor =
 {
 	.free = qcvm_heap_free,
-	.resolve_pointer = qcvm_heap_resolve_pointer
+	.resolve_pointer = qcvm_heap_resolve_pointer,
+	.mark_strings = qcvm_heap_mark_strings
 };
 
 static void QC_heap_alloc(qcvm_t *vm)
@@ -0,0 +1,98 @@
+// This is the interpreter loop, which vm.c includes once per variant of it.
+// QCVM_INTERPRET is the name to give it, and QCVM_INTERPRET_HOOKED is whether
+// it checks for the debugger, instrumentation & profiling on every statement.
+
+static void QCVM_INTERPRET(qcvm_t *vm, int32_t enter_depth)
+{
+#if !QCVM_INTERPRET_HOOKED && QCVM_TAIL_DISPATCH
+	qcvm_tail_dispatch(vm, NULL, &enter_depth);
+#elif !QCVM_INTERPRET_HOOKED && QCVM_THREADED_DISPATCH
+	const qcvm_decoded_statement_t *decoded;
+
+	JUMPCODE_LIST;
+
+	THREADED_DISPATCH;
+
+	THREADED_JUMPCODE_ASM
+#else
+	const qcvm_statement_t *statement;
+	const qcvm_decoded_statement_t *decoded;
+
+	while (1)
+	{
+		// get next statement
+		qcvm_stack_t *current = &vm->state.stack[vm->state.current];
+		statement = ++current->statement;
+		decoded = vm->decoded_statements + (statement - vm->statements);
+
+#if QCVM_INTERPRET_HOOKED && ALLOW_INSTRUMENTING
+		if (vm->profiling.flags & PROFILE_FIELDS)
+			current->profile->fields[NumInstructions][vm->profiling.mark]++;
+#endif
+
+#if QCVM_INTERPRET_HOOKED && ALLOW_DEBUGGING
+		if (vm->debug.attached)
+		{
+			if (statement->opcode & OP_BREAKPOINT)
+				qcvm_break_on_current_statement(vm);
+			else
+			{
+				// figure out if we need to break here.
+				// step into is easiest: next QC execution that is not on the same function+line combo
+				if (vm->debug.state == DEBUG_STEP_INTO)
+				{
+					if (vm->debug.step_function != current->function || qcvm_line_number_for(vm, vm->debug.step_statement) != qcvm_line_number_for(vm, current->statement))
+						qcvm_break_on_current_statement(vm);
+				}
+				// I lied, step out is the easiest
+				else if (vm->debug.state == DEBUG_STEP_OUT)
+				{
+					if (vm->debug.step_depth > vm->state.current)
+						qcvm_break_on_current_statement(vm);
+				}
+				// step over: either step out, or the next step that is in the same function + stack depth + not on same line
+				else if (vm->debug.state == DEBUG_STEP_OVER)
+				{
+					if (vm->debug.step_depth > vm->state.current ||
+						(vm->debug.step_depth == vm->state.current && vm->debug.step_function == current->function && qcvm_line_number_for(vm, vm->debug.step_statement) != qcvm_line_number_for(vm, current->statement)))
+						qcvm_break_on_current_statement(vm);
+				}
+			}
+		}
+#endif
+
+		JUMPCODE_LIST;
+
+#if QCVM_INTERPRET_HOOKED
+		START_OPCODE_TIMER(vm, decoded->opcode);
+#endif
+
+		EXECUTE_JUMPCODE;
+
+#if QCVM_INTERPRET_HOOKED
+		END_TIMER(vm, PROFILE_OPCODES);
+#endif
+
+#if QCVM_INTERPRET_HOOKED && ALLOW_PROFILING
+		if (vm->profiling.flags & PROFILE_SAMPLES)
+		{
+			if (!--vm->profiling.sampling.id)
+			{
+				vm->profiling.sampling.data[statement - vm->statements].count[vm->profiling.mark]++;
+				vm->profiling.sampling.id = vm->profiling.sampling.rate;
+			}
+		}
+#endif
+
+		if (!enter_depth)
+			return;		// all done
+	}
+
+	/*vm->debug_print(qcvm_temp_format(vm, "Infinite loop broken @ %s\n", qcvm_stack_trace(vm, true)));
+	
+	while (vm->state.current != -1)
+		qcvm_leave(vm);*/
+
+JUMPCODE_ASM
+#endif
+}
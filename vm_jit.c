@@ -0,0 +1,713 @@
+#define _DEFAULT_SOURCE
+#define QCVM_INTERNAL
+#include "shared/shared.h"
+#include "vm.h"
+#include "vm_jit.h"
+
+#if ALLOW_JIT
+#define OPCODES_ONLY
+#include "vm_opcodes.h"
+#undef OPCODES_ONLY
+
+#include <sys/mman.h>
+
+// Hot functions are translated to x86-64 one statement at a time. Float/int math,
+// compares, stores between globals and branches are emitted inline; everything else
+// goes through qcvm_run_statement, which calls the exact same handler the interpreter
+// would, so the two never disagree. Calls land back in here if the callee is compiled,
+// or interpret it otherwise.
+//
+// Register use inside compiled code:
+//   rbx = vm
+//   r12 = vm->global_data
+//   r13 = &vm->dynamic_strings.ref_storage_stored
+//   r14 = r12 moved over to this call's frame, for windowed locals
+//   r15 = unused; only pushed to keep the stack aligned
+
+enum
+{
+	JIT_HOT_CALLS = 32,
+	JIT_MAX_STATEMENTS = 0x8000,
+	JIT_CODE_RESERVE = 4096,
+	JIT_STATEMENT_MAX_SIZE = 256,
+	JIT_FIXUP_RESERVE = 64
+};
+
+enum
+{
+	REG_RAX = 0,
+	REG_RCX = 1,
+	REG_RDX = 2,
+	REG_RSI = 6,
+	REG_RDI = 7
+};
+
+enum
+{
+	SSE_MOVSS_LOAD = 0x10,
+	SSE_MOVSS_STORE = 0x11,
+	SSE_ADDSS = 0x58,
+	SSE_MULSS = 0x59,
+	SSE_SUBSS = 0x5C,
+	SSE_DIVSS = 0x5E,
+	SSE_CMPSS = 0xC2
+};
+
+enum
+{
+	CMP_EQ = 0,
+	CMP_LT = 1,
+	CMP_LE = 2,
+	CMP_NEQ = 4
+};
+
+enum
+{
+	JCC_JP = 0x8A,
+	JCC_JE = 0x84,
+	JCC_JNE = 0x85
+};
+
+typedef struct
+{
+	size_t	pos;
+	size_t	target;
+} qcvm_jit_fixup_t;
+
+typedef struct
+{
+	qcvm_t				*vm;
+	uint8_t				*code;
+	size_t				code_size, code_allocated;
+	qcvm_jit_fixup_t	*fixups;
+	size_t				fixups_size, fixups_allocated;
+	// range of statements being compiled, and where each one starts in code
+	size_t				first, count;
+	uint32_t			*labels;
+} qcvm_jit_state_t;
+
+static void *qcvm_jit_grow(qcvm_t *vm, void *ptr, const size_t size, const size_t new_size)
+{
+	void *grown = qcvm_alloc(vm, new_size);
+
+	if (ptr)
+	{
+		memcpy(grown, ptr, size);
+		qcvm_mem_free(vm, ptr);
+	}
+
+	return grown;
+}
+
+static void qcvm_jit_reserve(qcvm_jit_state_t *jit, const size_t size)
+{
+	if (jit->code_size + size <= jit->code_allocated)
+		return;
+
+	const size_t new_allocated = maxsz(jit->code_allocated * 2, jit->code_size + size + JIT_CODE_RESERVE);
+	jit->code = (uint8_t *)qcvm_jit_grow(jit->vm, jit->code, jit->code_size, new_allocated);
+	jit->code_allocated = new_allocated;
+}
+
+static inline void qcvm_jit_u8(qcvm_jit_state_t *jit, const uint8_t value)
+{
+	jit->code[jit->code_size++] = value;
+}
+
+static inline void qcvm_jit_u32(qcvm_jit_state_t *jit, const uint32_t value)
+{
+	memcpy(jit->code + jit->code_size, &value, sizeof(value));
+	jit->code_size += sizeof(value);
+}
+
+static inline void qcvm_jit_u64(qcvm_jit_state_t *jit, const uint64_t value)
+{
+	memcpy(jit->code + jit->code_size, &value, sizeof(value));
+	jit->code_size += sizeof(value);
+}
+
+// offsets with this set are relative to r14 instead of r12
+enum { JIT_FRAME = 0x80000000u };
+
+static inline uint32_t qcvm_jit_offset(const qcvm_t *vm, const qcvm_global_t *operand, const bool frame)
+{
+	return (uint32_t)((operand - vm->global_data) * sizeof(qcvm_global_t)) | (frame ? JIT_FRAME : 0);
+}
+
+// modrm (+ sib) for [r12 + offset] or [r14 + offset]; both need REX.B,
+// so the prefixes don't change
+static void qcvm_jit_global(qcvm_jit_state_t *jit, const uint8_t reg, const uint32_t offset)
+{
+	if (offset & JIT_FRAME)
+		qcvm_jit_u8(jit, 0x86 | ((reg & 7) << 3));
+	else
+	{
+		qcvm_jit_u8(jit, 0x84 | ((reg & 7) << 3));
+		qcvm_jit_u8(jit, 0x24);
+	}
+
+	qcvm_jit_u32(jit, offset & ~JIT_FRAME);
+}
+
+// scalar single op between xmm and [r12/r14 + offset]
+static void qcvm_jit_sse(qcvm_jit_state_t *jit, const uint8_t op, const uint8_t xmm, const uint32_t offset)
+{
+	qcvm_jit_u8(jit, 0xF3);
+	qcvm_jit_u8(jit, 0x41);
+	qcvm_jit_u8(jit, 0x0F);
+	qcvm_jit_u8(jit, op);
+	qcvm_jit_global(jit, xmm, offset);
+}
+
+// 32-bit op between eax and [r12/r14 + offset]
+static void qcvm_jit_int(qcvm_jit_state_t *jit, const uint8_t op, const uint32_t offset)
+{
+	qcvm_jit_u8(jit, 0x41);
+
+	// imul has a two-byte opcode
+	if (op == 0xAF)
+		qcvm_jit_u8(jit, 0x0F);
+
+	qcvm_jit_u8(jit, op);
+	qcvm_jit_global(jit, REG_RAX, offset);
+}
+
+// lea reg, [r12/r14 + offset]
+static void qcvm_jit_lea(qcvm_jit_state_t *jit, const uint8_t reg, const uint32_t offset)
+{
+	qcvm_jit_u8(jit, 0x49);
+	qcvm_jit_u8(jit, 0x8D);
+	qcvm_jit_global(jit, reg, offset);
+}
+
+static void qcvm_jit_mov_imm64(qcvm_jit_state_t *jit, const uint8_t reg, const uint64_t value)
+{
+	qcvm_jit_u8(jit, 0x48);
+	qcvm_jit_u8(jit, 0xB8 + reg);
+	qcvm_jit_u64(jit, value);
+}
+
+static void qcvm_jit_mov_imm32(qcvm_jit_state_t *jit, const uint8_t reg, const uint32_t value)
+{
+	qcvm_jit_u8(jit, 0xB8 + reg);
+	qcvm_jit_u32(jit, value);
+}
+
+static void qcvm_jit_call_native(qcvm_jit_state_t *jit, const void *func)
+{
+	qcvm_jit_mov_imm64(jit, REG_RAX, (uint64_t)(uintptr_t)func);
+	// call rax
+	qcvm_jit_u8(jit, 0xFF);
+	qcvm_jit_u8(jit, 0xD0);
+}
+
+// mov rdi, rbx
+static void qcvm_jit_arg_vm(qcvm_jit_state_t *jit)
+{
+	qcvm_jit_u8(jit, 0x48);
+	qcvm_jit_u8(jit, 0x89);
+	qcvm_jit_u8(jit, 0xDF);
+}
+
+static void qcvm_jit_fixup(qcvm_jit_state_t *jit, const size_t target)
+{
+	if (jit->fixups_size == jit->fixups_allocated)
+	{
+		const size_t new_allocated = jit->fixups_allocated + JIT_FIXUP_RESERVE;
+		jit->fixups = (qcvm_jit_fixup_t *)qcvm_jit_grow(jit->vm, jit->fixups, sizeof(qcvm_jit_fixup_t) * jit->fixups_size, sizeof(qcvm_jit_fixup_t) * new_allocated);
+		jit->fixups_allocated = new_allocated;
+	}
+
+	jit->fixups[jit->fixups_size++] = (qcvm_jit_fixup_t) { jit->code_size, target };
+	qcvm_jit_u32(jit, 0);
+}
+
+static void qcvm_jit_jump(qcvm_jit_state_t *jit, const size_t target)
+{
+	qcvm_jit_u8(jit, 0xE9);
+	qcvm_jit_fixup(jit, target);
+}
+
+static void qcvm_jit_jump_cond(qcvm_jit_state_t *jit, const uint8_t jcc, const size_t target)
+{
+	qcvm_jit_u8(jit, 0x0F);
+	qcvm_jit_u8(jit, jcc);
+	qcvm_jit_fixup(jit, target);
+}
+
+// start of a "skip this if there are no string refs anywhere" block;
+// returns the rel8 to patch with qcvm_jit_end_ref_check
+static size_t qcvm_jit_begin_ref_check(qcvm_jit_state_t *jit)
+{
+	// cmp qword [r13], 0
+	qcvm_jit_u8(jit, 0x49);
+	qcvm_jit_u8(jit, 0x83);
+	qcvm_jit_u8(jit, 0x7D);
+	qcvm_jit_u8(jit, 0x00);
+	qcvm_jit_u8(jit, 0x00);
+	// je skip
+	qcvm_jit_u8(jit, 0x74);
+	qcvm_jit_u8(jit, 0x00);
+	return jit->code_size;
+}
+
+static void qcvm_jit_end_ref_check(qcvm_jit_state_t *jit, const size_t start)
+{
+	jit->code[start - 1] = (uint8_t)(jit->code_size - start);
+}
+
+// what qcvm_set_operand does after writing a global
+static void qcvm_jit_set_hook(qcvm_jit_state_t *jit, const uint32_t offset, const size_t span)
+{
+	const size_t skip = qcvm_jit_begin_ref_check(jit);
+	qcvm_jit_arg_vm(jit);
+	qcvm_jit_lea(jit, REG_RSI, offset);
+	qcvm_jit_mov_imm32(jit, REG_RDX, (uint32_t)span);
+	qcvm_jit_mov_imm32(jit, REG_RCX, false);
+	qcvm_jit_call_native(jit, qcvm_string_list_check_ref_unset);
+	qcvm_jit_end_ref_check(jit, skip);
+}
+
+// what qcvm_copy_operands does after copying between globals
+static void qcvm_jit_copy_hook(qcvm_jit_state_t *jit, const uint32_t src, const uint32_t dst, const size_t span)
+{
+	const size_t skip = qcvm_jit_begin_ref_check(jit);
+	qcvm_jit_arg_vm(jit);
+	qcvm_jit_lea(jit, REG_RSI, src);
+	qcvm_jit_lea(jit, REG_RDX, dst);
+	qcvm_jit_mov_imm32(jit, REG_RCX, (uint32_t)span);
+	qcvm_jit_call_native(jit, qcvm_string_list_mark_refs_copied);
+	qcvm_jit_end_ref_check(jit, skip);
+}
+
+// turns a cmpss mask in xmm0 into 0.0/1.0
+static void qcvm_jit_mask_to_float(qcvm_jit_state_t *jit)
+{
+	// mov eax, 1.0f
+	qcvm_jit_mov_imm32(jit, REG_RAX, 0x3F800000);
+	// movd xmm1, eax
+	qcvm_jit_u8(jit, 0x66);
+	qcvm_jit_u8(jit, 0x0F);
+	qcvm_jit_u8(jit, 0x6E);
+	qcvm_jit_u8(jit, 0xC8);
+	// andps xmm0, xmm1
+	qcvm_jit_u8(jit, 0x0F);
+	qcvm_jit_u8(jit, 0x54);
+	qcvm_jit_u8(jit, 0xC1);
+}
+
+static void qcvm_jit_prologue(qcvm_jit_state_t *jit)
+{
+	// push rbx; push r12; push r13; push r14; push r15
+	qcvm_jit_u8(jit, 0x53);
+	qcvm_jit_u8(jit, 0x41);
+	qcvm_jit_u8(jit, 0x54);
+	qcvm_jit_u8(jit, 0x41);
+	qcvm_jit_u8(jit, 0x55);
+	qcvm_jit_u8(jit, 0x41);
+	qcvm_jit_u8(jit, 0x56);
+	qcvm_jit_u8(jit, 0x41);
+	qcvm_jit_u8(jit, 0x57);
+	// mov rbx, rdi
+	qcvm_jit_u8(jit, 0x48);
+	qcvm_jit_u8(jit, 0x89);
+	qcvm_jit_u8(jit, 0xFB);
+	// mov r12, global_data
+	qcvm_jit_u8(jit, 0x49);
+	qcvm_jit_u8(jit, 0xBC);
+	qcvm_jit_u64(jit, (uint64_t)(uintptr_t)jit->vm->global_data);
+	// mov r13, &ref_storage_stored
+	qcvm_jit_u8(jit, 0x49);
+	qcvm_jit_u8(jit, 0xBD);
+	qcvm_jit_u64(jit, (uint64_t)(uintptr_t)&jit->vm->dynamic_strings.ref_storage_stored);
+	// mov r14, [rbx + frame_delta]; add r14, r12
+	// the frame stack never moves, so this holds until we return
+	qcvm_jit_u8(jit, 0x4C);
+	qcvm_jit_u8(jit, 0x8B);
+	qcvm_jit_u8(jit, 0xB3);
+	qcvm_jit_u32(jit, (uint32_t)offsetof(qcvm_t, state.frame_delta));
+	qcvm_jit_u8(jit, 0x4D);
+	qcvm_jit_u8(jit, 0x01);
+	qcvm_jit_u8(jit, 0xE6);
+}
+
+static void qcvm_jit_epilogue(qcvm_jit_state_t *jit)
+{
+	// pop r15; pop r14; pop r13; pop r12; pop rbx; ret
+	qcvm_jit_u8(jit, 0x41);
+	qcvm_jit_u8(jit, 0x5F);
+	qcvm_jit_u8(jit, 0x41);
+	qcvm_jit_u8(jit, 0x5E);
+	qcvm_jit_u8(jit, 0x41);
+	qcvm_jit_u8(jit, 0x5D);
+	qcvm_jit_u8(jit, 0x41);
+	qcvm_jit_u8(jit, 0x5C);
+	qcvm_jit_u8(jit, 0x5B);
+	qcvm_jit_u8(jit, 0xC3);
+}
+
+// rdi = vm, rsi = statement index; see qcvm_run_statement
+static void qcvm_jit_run_statement(qcvm_jit_state_t *jit, const size_t index)
+{
+	qcvm_jit_arg_vm(jit);
+	qcvm_jit_mov_imm64(jit, REG_RSI, index);
+	qcvm_jit_call_native(jit, qcvm_run_statement);
+}
+
+// inline versions of simple opcodes; returns false if the handler should be called instead
+static bool qcvm_jit_native(qcvm_jit_state_t *jit, const qcvm_decoded_statement_t *s, const qcvm_opcode_t code)
+{
+	const qcvm_t *vm = jit->vm;
+
+	if (!s->a || !s->b || !s->c || s->c == vm->global_data)
+		return false;
+
+	const uint32_t a = qcvm_jit_offset(vm, s->a, s->frame_a), b = qcvm_jit_offset(vm, s->b, s->frame_b), c = qcvm_jit_offset(vm, s->c, s->frame_c);
+	uint8_t op;
+
+	switch (code)
+	{
+	case OP_ADD_F:
+		op = SSE_ADDSS;
+		goto float_math;
+	case OP_SUB_F:
+		op = SSE_SUBSS;
+		goto float_math;
+	case OP_MUL_F:
+		op = SSE_MULSS;
+		goto float_math;
+	case OP_DIV_F:
+		op = SSE_DIVSS;
+float_math:
+		qcvm_jit_sse(jit, SSE_MOVSS_LOAD, 0, a);
+		qcvm_jit_sse(jit, op, 0, b);
+		qcvm_jit_sse(jit, SSE_MOVSS_STORE, 0, c);
+		qcvm_jit_set_hook(jit, c, 1);
+		return true;
+
+	case OP_EQ_F:
+		qcvm_jit_sse(jit, SSE_MOVSS_LOAD, 0, a);
+		qcvm_jit_sse(jit, SSE_CMPSS, 0, b);
+		qcvm_jit_u8(jit, CMP_EQ);
+		goto float_compare;
+	case OP_NE_F:
+		qcvm_jit_sse(jit, SSE_MOVSS_LOAD, 0, a);
+		qcvm_jit_sse(jit, SSE_CMPSS, 0, b);
+		qcvm_jit_u8(jit, CMP_NEQ);
+		goto float_compare;
+	case OP_LT_F:
+		qcvm_jit_sse(jit, SSE_MOVSS_LOAD, 0, a);
+		qcvm_jit_sse(jit, SSE_CMPSS, 0, b);
+		qcvm_jit_u8(jit, CMP_LT);
+		goto float_compare;
+	case OP_LE_F:
+		qcvm_jit_sse(jit, SSE_MOVSS_LOAD, 0, a);
+		qcvm_jit_sse(jit, SSE_CMPSS, 0, b);
+		qcvm_jit_u8(jit, CMP_LE);
+		goto float_compare;
+	// a > b is b < a
+	case OP_GT_F:
+		qcvm_jit_sse(jit, SSE_MOVSS_LOAD, 0, b);
+		qcvm_jit_sse(jit, SSE_CMPSS, 0, a);
+		qcvm_jit_u8(jit, CMP_LT);
+		goto float_compare;
+	case OP_GE_F:
+		qcvm_jit_sse(jit, SSE_MOVSS_LOAD, 0, b);
+		qcvm_jit_sse(jit, SSE_CMPSS, 0, a);
+		qcvm_jit_u8(jit, CMP_LE);
+		goto float_compare;
+	// !a is 0 == a
+	case OP_NOT_F:
+		// xorps xmm0, xmm0
+		qcvm_jit_u8(jit, 0x0F);
+		qcvm_jit_u8(jit, 0x57);
+		qcvm_jit_u8(jit, 0xC0);
+		qcvm_jit_sse(jit, SSE_CMPSS, 0, a);
+		qcvm_jit_u8(jit, CMP_EQ);
+float_compare:
+		qcvm_jit_mask_to_float(jit);
+		qcvm_jit_sse(jit, SSE_MOVSS_STORE, 0, c);
+		qcvm_jit_set_hook(jit, c, 1);
+		return true;
+
+	// vector results are all computed before storing, in case c overlaps a or b
+	case OP_ADD_V:
+	case OP_SUB_V:
+		op = (code == OP_ADD_V) ? SSE_ADDSS : SSE_SUBSS;
+
+		for (uint8_t i = 0; i < 3; i++)
+		{
+			qcvm_jit_sse(jit, SSE_MOVSS_LOAD, i, a + (i * sizeof(vec_t)));
+			qcvm_jit_sse(jit, op, i, b + (i * sizeof(vec_t)));
+		}
+		goto vector_store;
+	case OP_MUL_VF:
+		for (uint8_t i = 0; i < 3; i++)
+		{
+			qcvm_jit_sse(jit, SSE_MOVSS_LOAD, i, a + (i * sizeof(vec_t)));
+			qcvm_jit_sse(jit, SSE_MULSS, i, b);
+		}
+		goto vector_store;
+	case OP_MUL_FV:
+		for (uint8_t i = 0; i < 3; i++)
+		{
+			qcvm_jit_sse(jit, SSE_MOVSS_LOAD, i, b + (i * sizeof(vec_t)));
+			qcvm_jit_sse(jit, SSE_MULSS, i, a);
+		}
+vector_store:
+		for (uint8_t i = 0; i < 3; i++)
+			qcvm_jit_sse(jit, SSE_MOVSS_STORE, i, c + (i * sizeof(vec_t)));
+		qcvm_jit_set_hook(jit, c, 3);
+		return true;
+
+	case OP_ADD_I:
+		op = 0x03;
+		goto int_math;
+	case OP_SUB_I:
+		op = 0x2B;
+		goto int_math;
+	case OP_MUL_I:
+		op = 0xAF;
+int_math:
+		qcvm_jit_int(jit, 0x8B, a);
+		qcvm_jit_int(jit, op, b);
+		qcvm_jit_int(jit, 0x89, c);
+		qcvm_jit_set_hook(jit, c, 1);
+		return true;
+	}
+
+	return false;
+}
+
+// stores only use a & b, so these get their own check
+static bool qcvm_jit_native_store(qcvm_jit_state_t *jit, const qcvm_decoded_statement_t *s, const qcvm_opcode_t code)
+{
+	const qcvm_t *vm = jit->vm;
+	size_t span;
+
+	switch (code)
+	{
+	case OP_STORE_F:
+	case OP_STORE_S:
+	case OP_STORE_ENT:
+	case OP_STORE_FLD:
+	case OP_STORE_FNC:
+	case OP_STORE_I:
+	case OP_STORE_P:
+		span = 1;
+		break;
+	case OP_STORE_V:
+		span = 3;
+		break;
+	default:
+		return false;
+	}
+
+	if (!s->a || !s->b)
+		return false;
+
+	const uint32_t src = qcvm_jit_offset(vm, s->a, s->frame_a), dst = qcvm_jit_offset(vm, s->b, s->frame_b);
+
+	for (size_t i = 0; i < span; i++)
+	{
+		qcvm_jit_int(jit, 0x8B, src + (uint32_t)(i * sizeof(qcvm_global_t)));
+		qcvm_jit_int(jit, 0x89, dst + (uint32_t)(i * sizeof(qcvm_global_t)));
+	}
+
+	if (!qcvm_opcode_is_unchecked_store(s->opcode))
+		qcvm_jit_copy_hook(jit, src, dst, span);
+	return true;
+}
+
+static void qcvm_jit_statement(qcvm_jit_state_t *jit, const size_t index)
+{
+	const qcvm_decoded_statement_t *s = &jit->vm->decoded_statements[index];
+	const qcvm_opcode_t code = qcvm_unfused_opcode(s->opcode);
+
+	qcvm_jit_reserve(jit, JIT_STATEMENT_MAX_SIZE);
+
+	if (code == OP_DONE || code == OP_RETURN)
+	{
+		qcvm_jit_run_statement(jit, index);
+		qcvm_jit_epilogue(jit);
+		return;
+	}
+	else if (code == OP_GOTO)
+	{
+		qcvm_jit_jump(jit, index + qcvm_branch_offset(code, s->args));
+		return;
+	}
+	else if (qcvm_opcode_is_branch(code))
+	{
+		const size_t target = index + qcvm_branch_offset(code, s->args);
+
+		if (s->a && (code == OP_IF_F || code == OP_IFNOT_F))
+		{
+			// cmp dword [a], 0
+			qcvm_jit_u8(jit, 0x41);
+			qcvm_jit_u8(jit, 0x83);
+			qcvm_jit_global(jit, 7, qcvm_jit_offset(jit->vm, s->a, s->frame_a));
+			qcvm_jit_u8(jit, 0x00);
+			qcvm_jit_jump_cond(jit, code == OP_IF_F ? JCC_JNE : JCC_JE, target);
+		}
+		else if (s->a && (code == OP_IF_I || code == OP_IFNOT_I))
+		{
+			qcvm_jit_sse(jit, SSE_MOVSS_LOAD, 0, qcvm_jit_offset(jit->vm, s->a, s->frame_a));
+			// xorps xmm1, xmm1; ucomiss xmm0, xmm1
+			qcvm_jit_u8(jit, 0x0F);
+			qcvm_jit_u8(jit, 0x57);
+			qcvm_jit_u8(jit, 0xC9);
+			qcvm_jit_u8(jit, 0x0F);
+			qcvm_jit_u8(jit, 0x2E);
+			qcvm_jit_u8(jit, 0xC1);
+
+			// NaN is truthy, so unordered counts as not equal
+			if (code == OP_IF_I)
+			{
+				qcvm_jit_jump_cond(jit, JCC_JP, target);
+				qcvm_jit_jump_cond(jit, JCC_JNE, target);
+			}
+			else
+			{
+				// jp over the je
+				qcvm_jit_u8(jit, 0x7A);
+				qcvm_jit_u8(jit, 0x06);
+				qcvm_jit_jump_cond(jit, JCC_JE, target);
+			}
+		}
+		else
+		{
+			qcvm_jit_run_statement(jit, index);
+			// test al, al
+			qcvm_jit_u8(jit, 0x84);
+			qcvm_jit_u8(jit, 0xC0);
+			qcvm_jit_jump_cond(jit, JCC_JNE, target);
+		}
+		return;
+	}
+
+	if (qcvm_jit_native(jit, s, code) || qcvm_jit_native_store(jit, s, code))
+		return;
+
+	// calls and everything else
+	qcvm_jit_run_statement(jit, index);
+}
+
+static bool qcvm_jit_compile(qcvm_t *vm, qcvm_function_t *function, qcvm_jit_function_t *out)
+{
+	const size_t entry = (size_t)function->id;
+	uint8_t *reachable = (uint8_t *)qcvm_alloc(vm, vm->statements_size);
+	memset(reachable, 0, vm->statements_size);
+
+	qcvm_jit_state_t jit = { .vm = vm };
+	bool valid = qcvm_find_reachable(vm, entry, reachable, &jit.first, &jit.count, JIT_MAX_STATEMENTS);
+
+	if (valid)
+	{
+		jit.count = jit.count - jit.first + 1;
+		jit.labels = (uint32_t *)qcvm_alloc(vm, sizeof(uint32_t) * jit.count);
+
+		qcvm_jit_reserve(&jit, JIT_CODE_RESERVE);
+		qcvm_jit_prologue(&jit);
+
+		if (entry != jit.first)
+			qcvm_jit_jump(&jit, entry);
+
+		for (size_t i = jit.first; i < jit.first + jit.count; i++)
+		{
+			if (!reachable[i])
+				continue;
+
+			jit.labels[i - jit.first] = (uint32_t)jit.code_size;
+			qcvm_jit_statement(&jit, i);
+		}
+
+		for (const qcvm_jit_fixup_t *fixup = jit.fixups; fixup < jit.fixups + jit.fixups_size; fixup++)
+		{
+			const int32_t rel = (int32_t)jit.labels[fixup->target - jit.first] - (int32_t)(fixup->pos + sizeof(int32_t));
+			memcpy(jit.code + fixup->pos, &rel, sizeof(rel));
+		}
+
+		void *code = mmap(NULL, jit.code_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+		if (code == MAP_FAILED)
+			valid = false;
+		else
+		{
+			memcpy(code, jit.code, jit.code_size);
+
+			if (mprotect(code, jit.code_size, PROT_READ | PROT_EXEC))
+			{
+				munmap(code, jit.code_size);
+				valid = false;
+			}
+			else
+			{
+				out->code = (qcvm_jit_code_t)code;
+				out->code_size = jit.code_size;
+			}
+		}
+
+		qcvm_debug(vm, "JIT: %s, %zu statements -> %zu bytes\n", qcvm_get_string(vm, function->name_index), jit.count, jit.code_size);
+
+		qcvm_mem_free(vm, jit.labels);
+		qcvm_mem_free(vm, jit.code);
+		if (jit.fixups)
+			qcvm_mem_free(vm, jit.fixups);
+	}
+
+	qcvm_mem_free(vm, reachable);
+	return valid;
+}
+
+static inline bool qcvm_jit_active(const qcvm_t *vm)
+{
+	return vm->jit.enabled && vm->jit.functions && qcvm_can_run_native(vm);
+}
+
+void qcvm_jit_init(qcvm_t *vm)
+{
+	vm->jit.functions = (qcvm_jit_function_t *)qcvm_alloc(vm, sizeof(qcvm_jit_function_t) * vm->functions_size);
+	memset(vm->jit.functions, 0, sizeof(qcvm_jit_function_t) * vm->functions_size);
+	vm->jit.enabled = true;
+}
+
+bool qcvm_jit_execute(qcvm_t *vm, qcvm_function_t *function)
+{
+	if (!qcvm_jit_active(vm) || vm->state.native_depth >= MAX_NATIVE_DEPTH)
+		return false;
+
+	qcvm_jit_function_t *jit = &vm->jit.functions[function - vm->functions];
+
+	if (!jit->code)
+	{
+		if (jit->failed || ++jit->calls < JIT_HOT_CALLS)
+			return false;
+
+		if (!qcvm_jit_compile(vm, function, jit))
+		{
+			jit->failed = true;
+			return false;
+		}
+	}
+
+	qcvm_enter(vm, function);
+	vm->state.native_depth++;
+	jit->code(vm);
+	vm->state.native_depth--;
+	return true;
+}
+
+void qcvm_jit_free(qcvm_t *vm)
+{
+	if (!vm->jit.functions)
+		return;
+
+	for (qcvm_jit_function_t *jit = vm->jit.functions; jit < vm->jit.functions + vm->functions_size; jit++)
+		if (jit->code)
+			munmap((void *)jit->code, jit->code_size);
+
+	qcvm_mem_free(vm, vm->jit.functions);
+	vm->jit.functions = NULL;
+}
+#endif
@@ -0,0 +1,11 @@
+#pragma once
+
+#if ALLOW_JIT
+void qcvm_jit_init(qcvm_t *vm);
+
+// runs the function natively if it has been (or just got) compiled;
+// returns false if the interpreter should run it instead.
+bool qcvm_jit_execute(qcvm_t *vm, qcvm_function_t *function);
+
+void qcvm_jit_free(qcvm_t *vm);
+#endif
@@ -31,10 +31,17 @@ static bool	qcvm_list_resolve_pointer(const qcvm_t *vm, void *handle, const size
 	return false;
 }
 
+static void qcvm_list_mark_strings(qcvm_t *vm, void *handle)
+{
+	qcvm_list_t *list = (qcvm_list_t *)handle;
+	qcvm_string_list_mark_span(vm, list->values, (list->size * sizeof(qcvm_variant_t)) / sizeof(qcvm_global_t));
+}
+
 static const qcvm_handle_descriptor_t list_descriptor =
 {
 	.free = qcvm_list_free,
-	.resolve_pointer = qcvm_list_resolve_pointer
+	.resolve_pointer = qcvm_list_resolve_pointer,
+	.mark_strings = qcvm_list_mark_strings
 };
 
 static void QC_list_alloc(qcvm_t *vm)
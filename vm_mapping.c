@@ -0,0 +1,110 @@
+#define QCVM_INTERNAL
+#include "shared/shared.h"
+#include "vm.h"
+#include "vm_mapping.h"
+
+#ifdef WINDOWS
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+bool qcvm_map_file(const char *filename, const bool copy_on_write, qcvm_mapping_t *mapping)
+{
+	*mapping = (qcvm_mapping_t) { 0 };
+
+#ifdef WINDOWS
+	HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	HANDLE handle = NULL;
+
+	if (GetFileSizeEx(file, &size) && size.QuadPart)
+		handle = CreateFileMappingA(file, NULL, copy_on_write ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, NULL);
+
+	CloseHandle(file);
+
+	if (!handle)
+		return false;
+
+	void *data = MapViewOfFile(handle, copy_on_write ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0);
+
+	if (!data)
+	{
+		CloseHandle(handle);
+		return false;
+	}
+
+	mapping->handle = handle;
+	mapping->size = (size_t)size.QuadPart;
+#else
+	const int fd = open(filename, O_RDONLY);
+
+	if (fd == -1)
+		return false;
+
+	struct stat st;
+	void *data = MAP_FAILED;
+
+	if (fstat(fd, &st) == 0 && st.st_size)
+		data = mmap(NULL, (size_t)st.st_size, copy_on_write ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_PRIVATE, fd, 0);
+
+	close(fd);
+
+	if (data == MAP_FAILED)
+		return false;
+
+	mapping->size = (size_t)st.st_size;
+#endif
+
+	mapping->data = data;
+	return true;
+}
+
+void qcvm_protect_mapping(const qcvm_mapping_t *mapping, const void *data, const size_t size)
+{
+	if (!mapping->data || (const uint8_t *)data < (const uint8_t *)mapping->data || (const uint8_t *)data + size > (const uint8_t *)mapping->data + mapping->size)
+		return;
+
+#ifdef WINDOWS
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	const uintptr_t page_size = info.dwPageSize;
+#else
+	const uintptr_t page_size = (uintptr_t)sysconf(_SC_PAGESIZE);
+#endif
+
+	const uintptr_t start = ((uintptr_t)data + page_size - 1) & ~(page_size - 1);
+	const uintptr_t end = ((uintptr_t)data + size) & ~(page_size - 1);
+
+	if (end <= start)
+		return;
+
+#ifdef WINDOWS
+	DWORD old_protect;
+	VirtualProtect((void *)start, end - start, PAGE_READONLY, &old_protect);
+#else
+	mprotect((void *)start, end - start, PROT_READ);
+#endif
+}
+
+void qcvm_unmap_file(qcvm_mapping_t *mapping)
+{
+	if (!mapping->data)
+		return;
+
+#ifdef WINDOWS
+	UnmapViewOfFile(mapping->data);
+	CloseHandle((HANDLE)mapping->handle);
+#else
+	munmap(mapping->data, mapping->size);
+#endif
+
+	*mapping = (qcvm_mapping_t) { 0 };
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+// maps a whole file into memory; returns false if it can't be opened or is empty.
+// a copy_on_write mapping can be written to, and the pages that are get copied
+// for this process alone; the rest stay shared with anything else mapping the file.
+bool qcvm_map_file(const char *filename, const bool copy_on_write, qcvm_mapping_t *mapping);
+
+// makes the pages entirely within the range read-only, so writing to them
+// faults rather than silently unsharing them. ranges that aren't in the
+// mapping are left alone.
+void qcvm_protect_mapping(const qcvm_mapping_t *mapping, const void *data, const size_t size);
+
+void qcvm_unmap_file(qcvm_mapping_t *mapping);
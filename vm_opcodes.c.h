@@ -1,29 +1,109 @@
 #pragma once
-typedef void(*qcvm_opcode_func_t) (qcvm_t *vm, const qcvm_operands_t operands, int *depth);
 
 // This is the "source" component of vm_opcodes.h that is included alongside it.
-static void F_OP_DONE(qcvm_t *vm, const qcvm_operands_t operands, int *depth)
+
+// Operands are resolved to addresses once, in qcvm_decode_statements, so the
+// handlers below use these instead of qcvm_get_global/qcvm_set_global/qcvm_copy_globals.
+// Locals of windowed functions are moved over to the current frame here; the
+// mask keeps this free of branches.
+#define qcvm_operand(vm, operands, x) \
+	((qcvm_global_t *)((uintptr_t)(operands)->x + ((vm)->state.frame_delta & -(uintptr_t)(operands)->frame_##x)))
+
+static qcvm_always_inline qcvm_global_t *qcvm_fetch_operand(qcvm_t *vm, qcvm_global_t *operand)
+{
+#if ALLOW_INSTRUMENTING
+	if ((vm->profiling.flags & PROFILE_FIELDS) && vm->state.current >= 0 && vm->state.stack[vm->state.current].profile)
+		vm->state.stack[vm->state.current].profile->fields[NumGlobalsFetched][vm->profiling.mark]++;
+#endif
+
+	return operand;
+}
+
+#define qcvm_operand_typed(type, vm, operand) \
+	((type *)qcvm_fetch_operand(vm, operand))
+
+static qcvm_always_inline void qcvm_set_operand(qcvm_t *vm, qcvm_global_t *operand, const void *value, const size_t value_size)
+{
+#if ALLOW_INSTRUMENTING
+	if ((vm->profiling.flags & PROFILE_FIELDS) && vm->state.current >= 0 && vm->state.stack[vm->state.current].profile)
+		vm->state.stack[vm->state.current].profile->fields[NumGlobalsSet][vm->profiling.mark]++;
+#endif
+
+	if (operand == vm->global_data)
+		qcvm_error(vm, "attempt to overwrite 0");
+
+	memcpy(operand, value, value_size);
+	if (vm->dynamic_strings.ref_storage_stored)
+		qcvm_string_list_check_ref_unset(vm, operand, value_size / sizeof(qcvm_global_t), false);
+}
+
+// stores through pointers & to entity fields; operands never point into
+// an entity, so only these need the wrap check, and not even all of them
+// (see qcvm_field_wrap_list_tag_stores)
+static qcvm_always_inline void qcvm_check_store_wraps(qcvm_t *vm, const qcvm_decoded_statement_t *operands, const void *dst, const size_t span)
+{
+	if (!operands->skip_wraps)
+		qcvm_field_wrap_list_check_set(vm, dst, span);
+}
+
+// NOTE: do *not* use this to pass pointers! this is for value types only
+#define qcvm_set_operand_typed_value(type, vm, operand, value) \
+	qcvm_set_operand(vm, operand, &(value), sizeof(type))
+
+// NOTE: do *not* use this to pass values! this is for pointers only
+#define qcvm_set_operand_typed_ptr(type, vm, operand, value_ptr) \
+	qcvm_set_operand(vm, operand, value_ptr, sizeof(type))
+
+static qcvm_always_inline void qcvm_copy_operands(qcvm_t *vm, qcvm_global_t *dst, const qcvm_global_t *src, const size_t size)
+{
+	const size_t span = size / sizeof(qcvm_global_t);
+
+	memcpy(dst, src, size);
+
+	if (vm->dynamic_strings.ref_storage_stored)
+		qcvm_string_list_mark_refs_copied(vm, src, dst, span);
+}
+
+#define qcvm_copy_operands_typed(type, vm, dst, src) \
+	qcvm_copy_operands(vm, dst, src, sizeof(type))
+
+#define qcvm_copy_operands_safe(TDst, TSrc, vm, dst, src) \
+	{ \
+		assert(sizeof(TDst) == sizeof(TSrc)); \
+\
+		const size_t span = sizeof(TDst) / sizeof(qcvm_global_t); \
+\
+		const TSrc *src_ptr = qcvm_operand_typed(TSrc, vm, src); \
+		TDst *dst_ptr = qcvm_operand_typed(TDst, vm, dst); \
+\
+		*(dst_ptr) = *(src_ptr); \
+\
+		if (vm->dynamic_strings.ref_storage_stored) \
+			qcvm_string_list_mark_refs_copied(vm, src_ptr, dst_ptr, span); \
+	}
+
+static void F_OP_DONE(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth)
 {
 	qcvm_leave(vm);
 	(*depth)--;
 }
 
-static void F_OP_RETURN(qcvm_t *vm, const qcvm_operands_t operands, int *depth)
+static void F_OP_RETURN(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth)
 {
-	if (operands.a != GLOBAL_NULL)
-		qcvm_copy_globals_typed(qcvm_global_t[3], vm, GLOBAL_RETURN, operands.a);
+	if (operands->args.a != GLOBAL_NULL)
+		qcvm_copy_operands_typed(qcvm_global_t[3], vm, vm->global_data + GLOBAL_RETURN, qcvm_operand(vm, operands, a));
 
 	qcvm_leave(vm);
 	(*depth)--;
 }
 
 #define F_OP_MUL(F_OP, TLeft, TRight, TResult) \
-static void F_OP(qcvm_t *vm, const qcvm_operands_t operands, int *depth) \
+static void F_OP(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth) \
 { \
-	const TLeft a = *qcvm_get_global_typed(TLeft, vm, operands.a); \
-	const TRight b = *qcvm_get_global_typed(TRight, vm, operands.b); \
+	const TLeft a = *qcvm_operand_typed(TLeft, vm, qcvm_operand(vm, operands, a)); \
+	const TRight b = *qcvm_operand_typed(TRight, vm, qcvm_operand(vm, operands, b)); \
 	const TResult result = a * b; \
-	qcvm_set_global_typed_value(TResult, vm, operands.c, result); \
+	qcvm_set_operand_typed_value(TResult, vm, qcvm_operand(vm, operands, c), result); \
 }
 
 F_OP_MUL(F_OP_MUL_F, vec_t, vec_t, vec_t)
@@ -32,53 +112,53 @@ F_OP_MUL(F_OP_MUL_IF, int32_t, vec_t, vec_t)
 F_OP_MUL(F_OP_MUL_FI, vec_t, int32_t, vec_t)
 #undef F_OP_MUL
 
-static void F_OP_MUL_V(qcvm_t *vm, const qcvm_operands_t operands, int *depth)
+static void F_OP_MUL_V(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth)
 {
-	const vec3_t a = *qcvm_get_global_typed(vec3_t, vm, operands.a);
-	const vec3_t b = *qcvm_get_global_typed(vec3_t, vm, operands.b);
+	const vec3_t a = *qcvm_operand_typed(vec3_t, vm, qcvm_operand(vm, operands, a));
+	const vec3_t b = *qcvm_operand_typed(vec3_t, vm, qcvm_operand(vm, operands, b));
 	const vec_t result = DotProduct(a, b);
-	qcvm_set_global_typed_value(vec_t, vm, operands.c, result);
+	qcvm_set_operand_typed_value(vec_t, vm, qcvm_operand(vm, operands, c), result);
 }
 
-static void F_OP_MUL_VF(qcvm_t *vm, const qcvm_operands_t operands, int *depth)
+static void F_OP_MUL_VF(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth)
 {
-	const vec3_t a = *qcvm_get_global_typed(vec3_t, vm, operands.a);
-	const vec_t b = *qcvm_get_global_typed(vec_t, vm, operands.b);
+	const vec3_t a = *qcvm_operand_typed(vec3_t, vm, qcvm_operand(vm, operands, a));
+	const vec_t b = *qcvm_operand_typed(vec_t, vm, qcvm_operand(vm, operands, b));
 	const vec3_t result = VectorScaleF(a, b);
-	qcvm_set_global_typed_value(vec3_t, vm, operands.c, result);
+	qcvm_set_operand_typed_value(vec3_t, vm, qcvm_operand(vm, operands, c), result);
 }
 
-static void F_OP_MUL_FV(qcvm_t *vm, const qcvm_operands_t operands, int *depth)
+static void F_OP_MUL_FV(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth)
 {
-	const vec_t a = *qcvm_get_global_typed(vec_t, vm, operands.a);
-	const vec3_t b = *qcvm_get_global_typed(vec3_t, vm, operands.b);
+	const vec_t a = *qcvm_operand_typed(vec_t, vm, qcvm_operand(vm, operands, a));
+	const vec3_t b = *qcvm_operand_typed(vec3_t, vm, qcvm_operand(vm, operands, b));
 	const vec3_t result = VectorScaleF(b, a);
-	qcvm_set_global_typed_value(vec3_t, vm, operands.c, result);
+	qcvm_set_operand_typed_value(vec3_t, vm, qcvm_operand(vm, operands, c), result);
 }
 
-static void F_OP_MUL_VI(qcvm_t *vm, const qcvm_operands_t operands, int *depth)
+static void F_OP_MUL_VI(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth)
 {
-	const vec3_t a = *qcvm_get_global_typed(vec3_t, vm, operands.a);
-	const int32_t b = *qcvm_get_global_typed(int32_t, vm, operands.b);
+	const vec3_t a = *qcvm_operand_typed(vec3_t, vm, qcvm_operand(vm, operands, a));
+	const int32_t b = *qcvm_operand_typed(int32_t, vm, qcvm_operand(vm, operands, b));
 	const vec3_t result = VectorScaleI(a, b);
-	qcvm_set_global_typed_value(vec3_t, vm, operands.c, result);
+	qcvm_set_operand_typed_value(vec3_t, vm, qcvm_operand(vm, operands, c), result);
 }
 
-static void F_OP_MUL_IV(qcvm_t *vm, const qcvm_operands_t operands, int *depth)
+static void F_OP_MUL_IV(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth)
 {
-	const int32_t a = *qcvm_get_global_typed(int32_t, vm, operands.a);
-	const vec3_t b = *qcvm_get_global_typed(vec3_t, vm, operands.b);
+	const int32_t a = *qcvm_operand_typed(int32_t, vm, qcvm_operand(vm, operands, a));
+	const vec3_t b = *qcvm_operand_typed(vec3_t, vm, qcvm_operand(vm, operands, b));
 	const vec3_t result = VectorScaleI(b, a);
-	qcvm_set_global_typed_value(vec3_t, vm, operands.c, result);
+	qcvm_set_operand_typed_value(vec3_t, vm, qcvm_operand(vm, operands, c), result);
 }
 
 #define F_OP_DIV(F_OP, TLeft, TRight, TResult) \
-static void F_OP(qcvm_t *vm, const qcvm_operands_t operands, int *depth) \
+static void F_OP(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth) \
 { \
-	const TLeft a = *qcvm_get_global_typed(TLeft, vm, operands.a); \
-	const TRight b = *qcvm_get_global_typed(TRight, vm, operands.b); \
+	const TLeft a = *qcvm_operand_typed(TLeft, vm, qcvm_operand(vm, operands, a)); \
+	const TRight b = *qcvm_operand_typed(TRight, vm, qcvm_operand(vm, operands, b)); \
 	const TResult result = a / b; \
-	qcvm_set_global_typed_value(TResult, vm, operands.c, result); \
+	qcvm_set_operand_typed_value(TResult, vm, qcvm_operand(vm, operands, c), result); \
 }
 
 F_OP_DIV(F_OP_DIV_F, vec_t, vec_t, vec_t)
@@ -87,21 +167,21 @@ F_OP_DIV(F_OP_DIV_IF, int32_t, vec_t, vec_t)
 F_OP_DIV(F_OP_DIV_FI, vec_t, int32_t, vec_t)
 #undef F_OP_DIV
 
-static void F_OP_DIV_VF(qcvm_t *vm, const qcvm_operands_t operands, int *depth)
+static void F_OP_DIV_VF(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth)
 {
-	const vec3_t a = *qcvm_get_global_typed(vec3_t, vm, operands.a);
-	const vec_t b = *qcvm_get_global_typed(vec_t, vm, operands.b);
+	const vec3_t a = *qcvm_operand_typed(vec3_t, vm, qcvm_operand(vm, operands, a));
+	const vec_t b = *qcvm_operand_typed(vec_t, vm, qcvm_operand(vm, operands, b));
 	const vec3_t result = VectorDivideF(a, b);
-	qcvm_set_global_typed_value(vec3_t, vm, operands.c, result);
+	qcvm_set_operand_typed_value(vec3_t, vm, qcvm_operand(vm, operands, c), result);
 }
 
 #define F_OP_ADD(F_OP, TLeft, TRight, TResult) \
-static void F_OP(qcvm_t *vm, const qcvm_operands_t operands, int *depth) \
+static void F_OP(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth) \
 { \
-	const TLeft a = *qcvm_get_global_typed(TLeft, vm, operands.a); \
-	const TRight b = *qcvm_get_global_typed(TRight, vm, operands.b); \
+	const TLeft a = *qcvm_operand_typed(TLeft, vm, qcvm_operand(vm, operands, a)); \
+	const TRight b = *qcvm_operand_typed(TRight, vm, qcvm_operand(vm, operands, b)); \
 	const TResult result = a + b; \
-	qcvm_set_global_typed_value(TResult, vm, operands.c, result); \
+	qcvm_set_operand_typed_value(TResult, vm, qcvm_operand(vm, operands, c), result); \
 }
 
 F_OP_ADD(F_OP_ADD_F, vec_t, vec_t, vec_t)
@@ -110,21 +190,21 @@ F_OP_ADD(F_OP_ADD_FI, vec_t, int32_t, vec_t)
 F_OP_ADD(F_OP_ADD_IF, int32_t, vec_t, vec_t)
 #undef F_OP_ADD
 
-static void F_OP_ADD_V(qcvm_t *vm, const qcvm_operands_t operands, int *depth)
+static void F_OP_ADD_V(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth)
 {
-	const vec3_t a = *qcvm_get_global_typed(vec3_t, vm, operands.a);
-	const vec3_t b = *qcvm_get_global_typed(vec3_t, vm, operands.b);
+	const vec3_t a = *qcvm_operand_typed(vec3_t, vm, qcvm_operand(vm, operands, a));
+	const vec3_t b = *qcvm_operand_typed(vec3_t, vm, qcvm_operand(vm, operands, b));
 	const vec3_t result = VectorAdd(a, b);
-	qcvm_set_global_typed_value(vec3_t, vm, operands.c, result);
+	qcvm_set_operand_typed_value(vec3_t, vm, qcvm_operand(vm, operands, c), result);
 }
 
 #define F_OP_SUB(F_OP, TLeft, TRight, TResult) \
-static void F_OP(qcvm_t *vm, const qcvm_operands_t operands, int *depth) \
+static void F_OP(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth) \
 { \
-	const TLeft a = *qcvm_get_global_typed(TLeft, vm, operands.a); \
-	const TRight b = *qcvm_get_global_typed(TRight, vm, operands.b); \
+	const TLeft a = *qcvm_operand_typed(TLeft, vm, qcvm_operand(vm, operands, a)); \
+	const TRight b = *qcvm_operand_typed(TRight, vm, qcvm_operand(vm, operands, b)); \
 	const TResult result = a - b; \
-	qcvm_set_global_typed_value(TResult, vm, operands.c, result); \
+	qcvm_set_operand_typed_value(TResult, vm, qcvm_operand(vm, operands, c), result); \
 }
 
 F_OP_SUB(F_OP_SUB_F, vec_t, vec_t, vec_t)
@@ -133,21 +213,21 @@ F_OP_SUB(F_OP_SUB_FI, vec_t, int32_t, vec_t)
 F_OP_SUB(F_OP_SUB_IF, int32_t, vec_t, vec_t)
 #undef F_OP_SUB
 
-static void F_OP_SUB_V(qcvm_t *vm, const qcvm_operands_t operands, int *depth)
+static void F_OP_SUB_V(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth)
 {
-	const vec3_t a = *qcvm_get_global_typed(vec3_t, vm, operands.a);
-	const vec3_t b = *qcvm_get_global_typed(vec3_t, vm, operands.b);
+	const vec3_t a = *qcvm_operand_typed(vec3_t, vm, qcvm_operand(vm, operands, a));
+	const vec3_t b = *qcvm_operand_typed(vec3_t, vm, qcvm_operand(vm, operands, b));
 	const vec3_t result = VectorSubtract(a, b);
-	qcvm_set_global_typed_value(vec3_t, vm, operands.c, result);
+	qcvm_set_operand_typed_value(vec3_t, vm, qcvm_operand(vm, operands, c), result);
 }
 
 #define F_OP_EQ(F_OP, TLeft, TRight, TResult) \
-static void F_OP(qcvm_t *vm, const qcvm_operands_t operands, int *depth) \
+static void F_OP(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth) \
 { \
-	const TLeft a = *qcvm_get_global_typed(TLeft, vm, operands.a); \
-	const TRight b = *qcvm_get_global_typed(TRight, vm, operands.b); \
+	const TLeft a = *qcvm_operand_typed(TLeft, vm, qcvm_operand(vm, operands, a)); \
+	const TRight b = *qcvm_operand_typed(TRight, vm, qcvm_operand(vm, operands, b)); \
 	const TResult result = a == b; \
-	qcvm_set_global_typed_value(TResult, vm, operands.c, result); \
+	qcvm_set_operand_typed_value(TResult, vm, qcvm_operand(vm, operands, c), result); \
 }
 
 F_OP_EQ(F_OP_EQ_F, vec_t, vec_t, vec_t)
@@ -158,37 +238,30 @@ F_OP_EQ(F_OP_EQ_IF, int32_t, vec_t, int32_t)
 F_OP_EQ(F_OP_EQ_FI, vec_t, int32_t, int32_t)
 #undef F_OP_EQ
 
-static void F_OP_EQ_V(qcvm_t *vm, const qcvm_operands_t operands, int *depth)
+static void F_OP_EQ_V(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth)
 {
-	const vec3_t a = *qcvm_get_global_typed(vec3_t, vm, operands.a);
-	const vec3_t b = *qcvm_get_global_typed(vec3_t, vm, operands.b);
+	const vec3_t a = *qcvm_operand_typed(vec3_t, vm, qcvm_operand(vm, operands, a));
+	const vec3_t b = *qcvm_operand_typed(vec3_t, vm, qcvm_operand(vm, operands, b));
 	const vec_t result = VectorEquals(a, b);
-	qcvm_set_global_typed_value(vec_t, vm, operands.c, result);
+	qcvm_set_operand_typed_value(vec_t, vm, qcvm_operand(vm, operands, c), result);
 }
 
-static void F_OP_EQ_S(qcvm_t *vm, const qcvm_operands_t operands, int *depth)
+static void F_OP_EQ_S(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth)
 {
-	const qcvm_string_t a = *qcvm_get_global_typed(qcvm_string_t, vm, operands.a);
-	const qcvm_string_t b = *qcvm_get_global_typed(qcvm_string_t, vm, operands.b);
-	vec_t result;
-
-	if (a == b)
-		result = 1;
-	else if (qcvm_strings_case_sensitive(vm))
-		result = !strcmp(qcvm_get_string(vm, a), qcvm_get_string(vm, b));
-	else
-		result = !stricmp(qcvm_get_string(vm, a), qcvm_get_string(vm, b));
+	const qcvm_string_t a = *qcvm_operand_typed(qcvm_string_t, vm, qcvm_operand(vm, operands, a));
+	const qcvm_string_t b = *qcvm_operand_typed(qcvm_string_t, vm, qcvm_operand(vm, operands, b));
+	const vec_t result = qcvm_strings_equal(vm, a, b);
 	
-	qcvm_set_global_typed_value(vec_t, vm, operands.c, result);
+	qcvm_set_operand_typed_value(vec_t, vm, qcvm_operand(vm, operands, c), result);
 }
 
 #define F_OP_NE(F_OP, TLeft, TRight, TResult) \
-static void F_OP(qcvm_t *vm, const qcvm_operands_t operands, int *depth) \
+static void F_OP(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth) \
 { \
-	const TLeft a = *qcvm_get_global_typed(TLeft, vm, operands.a); \
-	const TRight b = *qcvm_get_global_typed(TRight, vm, operands.b); \
+	const TLeft a = *qcvm_operand_typed(TLeft, vm, qcvm_operand(vm, operands, a)); \
+	const TRight b = *qcvm_operand_typed(TRight, vm, qcvm_operand(vm, operands, b)); \
 	const TResult result = a != b; \
-	qcvm_set_global_typed_value(TResult, vm, operands.c, result); \
+	qcvm_set_operand_typed_value(TResult, vm, qcvm_operand(vm, operands, c), result); \
 }
 
 F_OP_NE(F_OP_NE_F, vec_t, vec_t, vec_t)
@@ -199,37 +272,30 @@ F_OP_NE(F_OP_NE_IF, int32_t, vec_t, int32_t)
 F_OP_NE(F_OP_NE_FI, vec_t, int32_t, int32_t)
 #undef F_OP_NE
 
-static void F_OP_NE_V(qcvm_t *vm, const qcvm_operands_t operands, int *depth)
+static void F_OP_NE_V(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth)
 {
-	const vec3_t a = *qcvm_get_global_typed(vec3_t, vm, operands.a);
-	const vec3_t b = *qcvm_get_global_typed(vec3_t, vm, operands.b);
+	const vec3_t a = *qcvm_operand_typed(vec3_t, vm, qcvm_operand(vm, operands, a));
+	const vec3_t b = *qcvm_operand_typed(vec3_t, vm, qcvm_operand(vm, operands, b));
 	const vec_t result = !VectorEquals(a, b);
-	qcvm_set_global_typed_value(vec_t, vm, operands.c, result);
+	qcvm_set_operand_typed_value(vec_t, vm, qcvm_operand(vm, operands, c), result);
 }
 
-static void F_OP_NE_S(qcvm_t *vm, const qcvm_operands_t operands, int *depth)
+static void F_OP_NE_S(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth)
 {
-	const qcvm_string_t a = *qcvm_get_global_typed(qcvm_string_t, vm, operands.a);
-	const qcvm_string_t b = *qcvm_get_global_typed(qcvm_string_t, vm, operands.b);
-	vec_t result;
-
-	if (a == b)
-		result = 0;
-	else if (qcvm_strings_case_sensitive(vm))
-		result = !!strcmp(qcvm_get_string(vm, a), qcvm_get_string(vm, b));
-	else
-		result = !!stricmp(qcvm_get_string(vm, a), qcvm_get_string(vm, b));
+	const qcvm_string_t a = *qcvm_operand_typed(qcvm_string_t, vm, qcvm_operand(vm, operands, a));
+	const qcvm_string_t b = *qcvm_operand_typed(qcvm_string_t, vm, qcvm_operand(vm, operands, b));
+	const vec_t result = !qcvm_strings_equal(vm, a, b);
 
-	qcvm_set_global_typed_value(vec_t, vm, operands.c, result);
+	qcvm_set_operand_typed_value(vec_t, vm, qcvm_operand(vm, operands, c), result);
 }
 
 #define F_OP_LE(F_OP, TLeft, TRight, TResult) \
-static void F_OP(qcvm_t *vm, const qcvm_operands_t operands, int *depth) \
+static void F_OP(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth) \
 { \
-	const TLeft a = *qcvm_get_global_typed(TLeft, vm, operands.a); \
-	const TRight b = *qcvm_get_global_typed(TRight, vm, operands.b); \
+	const TLeft a = *qcvm_operand_typed(TLeft, vm, qcvm_operand(vm, operands, a)); \
+	const TRight b = *qcvm_operand_typed(TRight, vm, qcvm_operand(vm, operands, b)); \
 	const TResult result = a <= b; \
-	qcvm_set_global_typed_value(TResult, vm, operands.c, result); \
+	qcvm_set_operand_typed_value(TResult, vm, qcvm_operand(vm, operands, c), result); \
 }
 
 F_OP_LE(F_OP_LE_F, vec_t, vec_t, vec_t)
@@ -239,12 +305,12 @@ F_OP_LE(F_OP_LE_FI, vec_t, int32_t, int32_t)
 #undef F_OP_LE
 
 #define F_OP_GE(F_OP, TLeft, TRight, TResult) \
-static void F_OP(qcvm_t *vm, const qcvm_operands_t operands, int *depth) \
+static void F_OP(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth) \
 { \
-	const TLeft a = *qcvm_get_global_typed(TLeft, vm, operands.a); \
-	const TRight b = *qcvm_get_global_typed(TRight, vm, operands.b); \
+	const TLeft a = *qcvm_operand_typed(TLeft, vm, qcvm_operand(vm, operands, a)); \
+	const TRight b = *qcvm_operand_typed(TRight, vm, qcvm_operand(vm, operands, b)); \
 	const TResult result = a >= b; \
-	qcvm_set_global_typed_value(TResult, vm, operands.c, result); \
+	qcvm_set_operand_typed_value(TResult, vm, qcvm_operand(vm, operands, c), result); \
 }
 
 F_OP_GE(F_OP_GE_F, vec_t, vec_t, vec_t)
@@ -254,12 +320,12 @@ F_OP_GE(F_OP_GE_FI, vec_t, int32_t, int32_t)
 #undef F_OP_GE
 
 #define F_OP_LT(F_OP, TLeft, TRight, TResult) \
-static void F_OP(qcvm_t *vm, const qcvm_operands_t operands, int *depth) \
+static void F_OP(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth) \
 { \
-	const TLeft a = *qcvm_get_global_typed(TLeft, vm, operands.a); \
-	const TRight b = *qcvm_get_global_typed(TRight, vm, operands.b); \
+	const TLeft a = *qcvm_operand_typed(TLeft, vm, qcvm_operand(vm, operands, a)); \
+	const TRight b = *qcvm_operand_typed(TRight, vm, qcvm_operand(vm, operands, b)); \
 	const TResult result = a < b; \
-	qcvm_set_global_typed_value(TResult, vm, operands.c, result); \
+	qcvm_set_operand_typed_value(TResult, vm, qcvm_operand(vm, operands, c), result); \
 }
 
 F_OP_LT(F_OP_LT_F, vec_t, vec_t, vec_t)
@@ -269,12 +335,12 @@ F_OP_LT(F_OP_LT_FI, vec_t, int32_t, int32_t)
 #undef F_OP_LT
 
 #define F_OP_GT(F_OP, TLeft, TRight, TResult) \
-static void F_OP(qcvm_t *vm, const qcvm_operands_t operands, int *depth) \
+static void F_OP(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth) \
 { \
-	const TLeft a = *qcvm_get_global_typed(TLeft, vm, operands.a); \
-	const TRight b = *qcvm_get_global_typed(TRight, vm, operands.b); \
+	const TLeft a = *qcvm_operand_typed(TLeft, vm, qcvm_operand(vm, operands, a)); \
+	const TRight b = *qcvm_operand_typed(TRight, vm, qcvm_operand(vm, operands, b)); \
 	const TResult result = a > b; \
-	qcvm_set_global_typed_value(TResult, vm, operands.c, result); \
+	qcvm_set_operand_typed_value(TResult, vm, qcvm_operand(vm, operands, c), result); \
 }
 
 F_OP_GT(F_OP_GT_F, vec_t, vec_t, vec_t)
@@ -284,17 +350,17 @@ F_OP_GT(F_OP_GT_FI, vec_t, int32_t, int32_t)
 #undef F_OP_GT
 
 #define F_OP_LOAD(F_OP, TType) \
-static void F_OP(qcvm_t *vm, const qcvm_operands_t operands, int *depth) \
+static void F_OP(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth) \
 { \
-	edict_t *ent = qcvm_ent_to_entity(vm, *qcvm_get_global_typed(qcvm_ent_t, vm, operands.a), true); \
-	const int32_t field = *qcvm_get_global_typed(int32_t, vm, operands.b); \
+	edict_t *ent = qcvm_ent_to_entity(vm, *qcvm_operand_typed(qcvm_ent_t, vm, qcvm_operand(vm, operands, a)), true); \
+	const int32_t field = *qcvm_operand_typed(int32_t, vm, qcvm_operand(vm, operands, b)); \
 	const qcvm_pointer_t pointer = qcvm_get_entity_field_pointer(vm, ent, field); \
 	TType *field_value; \
 	if (!qcvm_resolve_pointer(vm, pointer, false, sizeof(TType), (void**)&field_value)) \
 		qcvm_error(vm, "invalid pointer"); \
-	qcvm_set_global_typed_ptr(TType, vm, operands.c, field_value); \
-	qcvm_string_list_mark_refs_copied(vm, field_value, qcvm_get_global(vm, operands.c), sizeof(TType) / sizeof(qcvm_global_t)); \
-	qcvm_field_wrap_list_check_set(vm, qcvm_get_global(vm, operands.c), sizeof(TType) / sizeof(qcvm_global_t)); \
+	qcvm_set_operand_typed_ptr(TType, vm, qcvm_operand(vm, operands, c), field_value); \
+	if (vm->dynamic_strings.ref_storage_stored) \
+		qcvm_string_list_mark_refs_copied(vm, field_value, qcvm_fetch_operand(vm, qcvm_operand(vm, operands, c)), sizeof(TType) / sizeof(qcvm_global_t)); \
 }
 
 F_OP_LOAD(F_OP_LOAD_F, vec_t)
@@ -307,24 +373,24 @@ F_OP_LOAD(F_OP_LOAD_I, int32_t)
 F_OP_LOAD(F_OP_LOAD_P, int32_t)
 #undef F_OP_LOAD
 
-static void F_OP_ADDRESS(qcvm_t *vm, const qcvm_operands_t operands, int *depth)
+static void F_OP_ADDRESS(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth)
 {
-	edict_t *ent = qcvm_ent_to_entity(vm, *qcvm_get_global_typed(qcvm_ent_t, vm, operands.a), true);
-	const int32_t field = *qcvm_get_global_typed(int32_t, vm, operands.b);
+	edict_t *ent = qcvm_ent_to_entity(vm, *qcvm_operand_typed(qcvm_ent_t, vm, qcvm_operand(vm, operands, a)), true);
+	const int32_t field = *qcvm_operand_typed(int32_t, vm, qcvm_operand(vm, operands, b));
 	const qcvm_pointer_t pointer = qcvm_get_entity_field_pointer(vm, ent, field);
-	qcvm_set_global_typed_value(qcvm_pointer_t, vm, operands.c, pointer);
+	qcvm_set_operand_typed_value(qcvm_pointer_t, vm, qcvm_operand(vm, operands, c), pointer);
 }
 
 #define F_OP_STORE_SAME(F_OP, TType) \
-static void F_OP(qcvm_t *vm, const qcvm_operands_t operands, int *depth) \
+static void F_OP(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth) \
 { \
-	qcvm_copy_globals_typed(TType, vm, operands.b, operands.a); \
+	qcvm_copy_operands_typed(TType, vm, qcvm_operand(vm, operands, b), qcvm_operand(vm, operands, a)); \
 }
 
 #define F_OP_STORE_DIFF(F_OP, TType, TResult) \
-static void F_OP(qcvm_t *vm, const qcvm_operands_t operands, int *depth) \
+static void F_OP(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth) \
 { \
-	qcvm_copy_globals_safe(TResult, TType, vm, operands.b, operands.a); \
+	qcvm_copy_operands_safe(TResult, TType, vm, qcvm_operand(vm, operands, b), qcvm_operand(vm, operands, a)); \
 }
 
 F_OP_STORE_SAME(F_OP_STORE_F, vec_t)
@@ -340,22 +406,23 @@ F_OP_STORE_SAME(F_OP_STORE_P, int32_t)
 #undef F_OP_STORE
 
 #define F_OP_STOREP(F_OP, TType, TResult) \
-static void F_OP(qcvm_t *vm, const qcvm_operands_t operands, int *depth) \
+static void F_OP(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth) \
 { \
-	qcvm_pointer_t pointer = *qcvm_get_global_typed(qcvm_pointer_t, vm, operands.b); \
-	const ptrdiff_t offset = *qcvm_get_global_typed(int32_t, vm, operands.c); \
+	qcvm_pointer_t pointer = *qcvm_operand_typed(qcvm_pointer_t, vm, qcvm_operand(vm, operands, b)); \
+	const ptrdiff_t offset = *qcvm_operand_typed(int32_t, vm, qcvm_operand(vm, operands, c)); \
 	pointer = qcvm_offset_pointer(vm, pointer, offset * sizeof(qcvm_global_t)); \
 	TResult *address_ptr; \
 \
 	if (!qcvm_resolve_pointer(vm, pointer, false, sizeof(TResult), (void **)&address_ptr)) \
 		qcvm_error(vm, "invalid address"); \
 \
-	const TType *value = qcvm_get_global_typed(TType, vm, operands.a); \
+	const TType *value = qcvm_operand_typed(TType, vm, qcvm_operand(vm, operands, a)); \
 	const size_t span = sizeof(TType) / sizeof(qcvm_global_t); \
 \
 	*address_ptr = *value; \
-	qcvm_string_list_mark_refs_copied(vm, value, address_ptr, span); \
-	qcvm_field_wrap_list_check_set(vm, address_ptr, span); \
+	if (vm->dynamic_strings.ref_storage_stored) \
+		qcvm_string_list_mark_refs_copied(vm, value, address_ptr, span); \
+	qcvm_check_store_wraps(vm, operands, address_ptr, span); \
 }
 
 F_OP_STOREP(F_OP_STOREP_F, vec_t, vec_t)
@@ -370,11 +437,11 @@ F_OP_STOREP(F_OP_STOREP_FI, vec_t, int32_t)
 #undef F_OP_STOREP
 
 #define F_OP_NOT(F_OP, TType, TResult) \
-static void F_OP(qcvm_t *vm, const qcvm_operands_t operands, int *depth) \
+static void F_OP(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth) \
 { \
-	const TType a = *qcvm_get_global_typed(TType, vm, operands.a); \
+	const TType a = *qcvm_operand_typed(TType, vm, qcvm_operand(vm, operands, a)); \
 	const TResult result = !a; \
-	qcvm_set_global_typed_value(TResult, vm, operands.c, result); \
+	qcvm_set_operand_typed_value(TResult, vm, qcvm_operand(vm, operands, c), result); \
 }
 
 F_OP_NOT(F_OP_NOT_F, vec_t, vec_t)
@@ -383,18 +450,18 @@ F_OP_NOT(F_OP_NOT_ENT, qcvm_ent_t, vec_t)
 F_OP_NOT(F_OP_NOT_I, int32_t, int32_t)
 #undef F_OP_NOT
 
-static void F_OP_NOT_V(qcvm_t *vm, const qcvm_operands_t operands, int *depth)
+static void F_OP_NOT_V(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth)
 {
-	const vec3_t a = *qcvm_get_global_typed(vec3_t, vm, operands.a);
+	const vec3_t a = *qcvm_operand_typed(vec3_t, vm, qcvm_operand(vm, operands, a));
 	const vec_t result = VectorEmpty(a);
-	qcvm_set_global_typed_value(vec_t, vm, operands.c, result);
+	qcvm_set_operand_typed_value(vec_t, vm, qcvm_operand(vm, operands, c), result);
 }
 
-static void F_OP_NOT_S(qcvm_t *vm, const qcvm_operands_t operands, int *depth)
+static void F_OP_NOT_S(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth)
 {
-	const qcvm_string_t a = *qcvm_get_global_typed(qcvm_string_t, vm, operands.a);
+	const qcvm_string_t a = *qcvm_operand_typed(qcvm_string_t, vm, qcvm_operand(vm, operands, a));
 	const vec_t result = a == STRING_EMPTY || !*qcvm_get_string(vm, a);
-	qcvm_set_global_typed_value(vec_t, vm, operands.c, result);
+	qcvm_set_operand_typed_value(vec_t, vm, qcvm_operand(vm, operands, c), result);
 }
 
 #if ALLOW_INSTRUMENTING
@@ -406,12 +473,12 @@ static void F_OP_NOT_S(qcvm_t *vm, const qcvm_operands_t operands, int *depth)
 #endif
 
 #define F_OP_IF(F_OP, TType) \
-static void F_OP(qcvm_t *vm, const qcvm_operands_t operands, int *depth) \
+static void F_OP(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth) \
 { \
-	if (*qcvm_get_global_typed(TType, vm, operands.a)) \
+	if (*qcvm_operand_typed(TType, vm, qcvm_operand(vm, operands, a))) \
 	{ \
 		qcvm_stack_t *current = &vm->state.stack[vm->state.current]; \
-		current->statement += (int16_t)current->statement->args.b - 1; \
+		current->statement += (int16_t)operands->args.b - 1; \
 		PROFILE_COND_JUMP; \
 	} \
 }
@@ -420,25 +487,25 @@ F_OP_IF(F_OP_IF_I, vec_t)
 F_OP_IF(F_OP_IF_F, int32_t)
 #undef F_OP_IF
 
-static void F_OP_IF_S(qcvm_t *vm, const qcvm_operands_t operands, int *depth)
+static void F_OP_IF_S(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth)
 {
-	const qcvm_string_t s = *qcvm_get_global_typed(qcvm_string_t, vm, operands.a);
+	const qcvm_string_t s = *qcvm_operand_typed(qcvm_string_t, vm, qcvm_operand(vm, operands, a));
 
 	if (s != STRING_EMPTY && *qcvm_get_string(vm, s))
 	{
 		qcvm_stack_t *current = &vm->state.stack[vm->state.current];
-		current->statement += (int16_t)current->statement->args.b - 1;
+		current->statement += (int16_t)operands->args.b - 1;
 		PROFILE_COND_JUMP;
 	}
 }
 
 #define F_OP_IFNOT(F_OP, TType) \
-static void F_OP(qcvm_t *vm, const qcvm_operands_t operands, int *depth) \
+static void F_OP(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth) \
 { \
-	if (!*qcvm_get_global_typed(TType, vm, operands.a)) \
+	if (!*qcvm_operand_typed(TType, vm, qcvm_operand(vm, operands, a))) \
 	{ \
 		qcvm_stack_t *current = &vm->state.stack[vm->state.current]; \
-		current->statement += (int16_t)current->statement->args.b - 1; \
+		current->statement += (int16_t)operands->args.b - 1; \
 		PROFILE_COND_JUMP; \
 	} \
 }
@@ -447,14 +514,14 @@ F_OP_IFNOT(F_OP_IFNOT_I, vec_t)
 F_OP_IFNOT(F_OP_IFNOT_F, int32_t)
 #undef F_IFNOT
 
-static void F_OP_IFNOT_S(qcvm_t *vm, const qcvm_operands_t operands, int *depth)
+static void F_OP_IFNOT_S(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth)
 {
-	const qcvm_string_t s = *qcvm_get_global_typed(qcvm_string_t, vm, operands.a);
+	const qcvm_string_t s = *qcvm_operand_typed(qcvm_string_t, vm, qcvm_operand(vm, operands, a));
 
 	if (s == STRING_EMPTY || !*qcvm_get_string(vm, s))
 	{
 		qcvm_stack_t *current = &vm->state.stack[vm->state.current];
-		current->statement += (int16_t)current->statement->args.b - 1;
+		current->statement += (int16_t)operands->args.b - 1;
 		PROFILE_COND_JUMP;
 	}
 }
@@ -462,12 +529,29 @@ static void F_OP_IFNOT_S(qcvm_t *vm, const qcvm_operands_t operands, int *depth)
 #ifndef _DEBUG
 qcvm_always_inline
 #endif
-static void F_OP_CALL_BASE(qcvm_t *vm, const qcvm_operands_t operands, int *depth)
+static void F_OP_CALL_BASE(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth)
 {
-	const int32_t enter_func = *qcvm_get_global_typed(int32_t, vm, operands.a);
+	const int32_t enter_func = *qcvm_operand_typed(int32_t, vm, qcvm_operand(vm, operands, a));
+	qcvm_call_cache_t *cache = &vm->call_caches[operands->call_cache];
+
+	// only resolve the function if it's not the one this site called last
+	if (enter_func != cache->func || !cache->function)
+	{
+		if (enter_func <= 0 || enter_func >= vm->functions_size)
+			qcvm_error(vm, "NULL function");
+
+		qcvm_function_t *resolved = &vm->functions[enter_func];
+
+		if (!resolved->id)
+			qcvm_error(vm, "Tried to call missing function %s", qcvm_get_string(vm, resolved->name_index));
+
+		qcvm_builtin_t builtin = NULL;
 
-	if (enter_func <= 0 || enter_func >= vm->functions_size)
-		qcvm_error(vm, "NULL function");
+		if (resolved->id < 0 && !(builtin = qcvm_builtin_list_get(vm, resolved->id)))
+			qcvm_error(vm, "Bad builtin call number");
+
+		*cache = (qcvm_call_cache_t) { enter_func, resolved, builtin };
+	}
 	
 #if ALLOW_INSTRUMENTING
 	if (vm->profiling.flags & PROFILE_FIELDS)
@@ -477,10 +561,7 @@ static void F_OP_CALL_BASE(qcvm_t *vm, const qcvm_operands_t operands, int *dept
 	}
 #endif
 
-	qcvm_function_t *call = &vm->functions[enter_func];
-
-	if (!call->id)
-		qcvm_error(vm, "Tried to call missing function %s", qcvm_get_string(vm, call->name_index));
+	qcvm_function_t *call = cache->function;
 
 #if ALLOW_PROFILING
 	if (vm->profiling.flags & PROFILE_SAMPLES)
@@ -493,37 +574,47 @@ static void F_OP_CALL_BASE(qcvm_t *vm, const qcvm_operands_t operands, int *dept
 	}
 #endif
 
-	if (call->id < 0) /* negative statements are built in functions */
+	if (cache->builtin) /* negative statements are built in functions */
 	{
-		qcvm_call_builtin(vm, call);
+		qcvm_run_builtin(vm, call, cache->builtin);
 		return;
 	}
 
+#if ALLOW_AOT
+	if (qcvm_aot_execute(vm, call))
+		return;
+#endif
+
+#if ALLOW_JIT
+	if (qcvm_jit_execute(vm, call))
+		return;
+#endif
+
 	(*depth)++;
 	qcvm_enter(vm, call);
 }
 
 #define F_OP_CALL(F_OP, num_args) \
-static void F_OP(qcvm_t *vm, const qcvm_operands_t operands, int *depth) \
+static void F_OP(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth) \
 { \
 	vm->state.argc = num_args; \
 	F_OP_CALL_BASE(vm, operands, depth); \
 }
 
 #define F_OP_CALLH1(F_OP, num_args) \
-static void F_OP(qcvm_t *vm, const qcvm_operands_t operands, int *depth) \
+static void F_OP(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth) \
 { \
 	vm->state.argc = num_args; \
-	qcvm_copy_globals_typed(qcvm_global_t[3], vm, GLOBAL_PARM0, operands.b); \
+	qcvm_copy_operands_typed(qcvm_global_t[3], vm, vm->global_data + GLOBAL_PARM0, qcvm_operand(vm, operands, b)); \
 	F_OP_CALL_BASE(vm, operands, depth); \
 }
 
 #define F_OP_CALLH2(F_OP, num_args) \
-static void F_OP(qcvm_t *vm, const qcvm_operands_t operands, int *depth) \
+static void F_OP(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth) \
 { \
 	vm->state.argc = num_args; \
-	qcvm_copy_globals_typed(qcvm_global_t[3], vm, GLOBAL_PARM0, operands.b); \
-	qcvm_copy_globals_typed(qcvm_global_t[3], vm, GLOBAL_PARM1, operands.c); \
+	qcvm_copy_operands_typed(qcvm_global_t[3], vm, vm->global_data + GLOBAL_PARM0, qcvm_operand(vm, operands, b)); \
+	qcvm_copy_operands_typed(qcvm_global_t[3], vm, vm->global_data + GLOBAL_PARM1, qcvm_operand(vm, operands, c)); \
 	F_OP_CALL_BASE(vm, operands, depth); \
 }
 
@@ -549,10 +640,10 @@ F_OP_CALLH2(F_OP_CALL8H, 8)
 #undef F_OP_CALLH1
 #undef F_OP_CALLH2
 
-static void F_OP_GOTO(qcvm_t *vm, const qcvm_operands_t operands, int *depth)
+static void F_OP_GOTO(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth)
 {
 	qcvm_stack_t *current = &vm->state.stack[vm->state.current];
-	current->statement += (int16_t)current->statement->args.a - 1;
+	current->statement += (int16_t)operands->args.a - 1;
 
 #if ALLOW_INSTRUMENTING
 	if (vm->profiling.flags & PROFILE_FIELDS)
@@ -561,12 +652,12 @@ static void F_OP_GOTO(qcvm_t *vm, const qcvm_operands_t operands, int *depth)
 }
 
 #define F_OP_AND(F_OP, TLeft, TRight, TResult) \
-static void F_OP(qcvm_t *vm, const qcvm_operands_t operands, int *depth) \
+static void F_OP(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth) \
 { \
-	const TLeft a = *qcvm_get_global_typed(TLeft, vm, operands.a); \
-	const TRight b = *qcvm_get_global_typed(TRight, vm, operands.b); \
+	const TLeft a = *qcvm_operand_typed(TLeft, vm, qcvm_operand(vm, operands, a)); \
+	const TRight b = *qcvm_operand_typed(TRight, vm, qcvm_operand(vm, operands, b)); \
 	const TResult result = a && b; \
-	qcvm_set_global_typed_value(TResult, vm, operands.c, result); \
+	qcvm_set_operand_typed_value(TResult, vm, qcvm_operand(vm, operands, c), result); \
 }
 
 F_OP_AND(F_OP_AND_F, vec_t, vec_t, vec_t)
@@ -576,12 +667,12 @@ F_OP_AND(F_OP_AND_FI, vec_t, int32_t, int32_t)
 #undef F_OP_AND
 
 #define F_OP_OR(F_OP, TLeft, TRight, TResult) \
-static void F_OP(qcvm_t *vm, const qcvm_operands_t operands, int *depth) \
+static void F_OP(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth) \
 { \
-	const TLeft a = *qcvm_get_global_typed(TLeft, vm, operands.a); \
-	const TRight b = *qcvm_get_global_typed(TRight, vm, operands.b); \
+	const TLeft a = *qcvm_operand_typed(TLeft, vm, qcvm_operand(vm, operands, a)); \
+	const TRight b = *qcvm_operand_typed(TRight, vm, qcvm_operand(vm, operands, b)); \
 	const TResult result = a || b; \
-	qcvm_set_global_typed_value(TResult, vm, operands.c, result); \
+	qcvm_set_operand_typed_value(TResult, vm, qcvm_operand(vm, operands, c), result); \
 }
 
 F_OP_OR(F_OP_OR_F, vec_t, vec_t, vec_t)
@@ -591,12 +682,12 @@ F_OP_OR(F_OP_OR_FI, vec_t, int32_t, int32_t)
 #undef F_OP_OR
 
 #define F_OP_BITAND(F_OP, TLeft, TRight, TResult) \
-static void F_OP(qcvm_t *vm, const qcvm_operands_t operands, int *depth) \
+static void F_OP(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth) \
 { \
-	const int32_t a = (int32_t)*qcvm_get_global_typed(TLeft, vm, operands.a); \
-	const int32_t b = (int32_t)*qcvm_get_global_typed(TRight, vm, operands.b); \
+	const int32_t a = (int32_t)*qcvm_operand_typed(TLeft, vm, qcvm_operand(vm, operands, a)); \
+	const int32_t b = (int32_t)*qcvm_operand_typed(TRight, vm, qcvm_operand(vm, operands, b)); \
 	const TResult result = a & b; \
-	qcvm_set_global_typed_value(TResult, vm, operands.c, result); \
+	qcvm_set_operand_typed_value(TResult, vm, qcvm_operand(vm, operands, c), result); \
 }
 
 F_OP_BITAND(F_OP_BITAND_F, vec_t, vec_t, vec_t)
@@ -606,12 +697,12 @@ F_OP_BITAND(F_OP_BITAND_FI, vec_t, int32_t, int32_t)
 #undef F_OP_BITAND
 
 #define F_OP_BITOR(F_OP, TLeft, TRight, TResult) \
-static void F_OP(qcvm_t *vm, const qcvm_operands_t operands, int *depth) \
+static void F_OP(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth) \
 { \
-	const int32_t a = (int32_t)*qcvm_get_global_typed(TLeft, vm, operands.a); \
-	const int32_t b = (int32_t)*qcvm_get_global_typed(TRight, vm, operands.b); \
+	const int32_t a = (int32_t)*qcvm_operand_typed(TLeft, vm, qcvm_operand(vm, operands, a)); \
+	const int32_t b = (int32_t)*qcvm_operand_typed(TRight, vm, qcvm_operand(vm, operands, b)); \
 	const TResult result = a | b; \
-	qcvm_set_global_typed_value(TResult, vm, operands.c, result); \
+	qcvm_set_operand_typed_value(TResult, vm, qcvm_operand(vm, operands, c), result); \
 }
 
 F_OP_BITOR(F_OP_BITOR_F, vec_t, vec_t, vec_t)
@@ -620,70 +711,70 @@ F_OP_BITOR(F_OP_BITOR_IF, int32_t, vec_t, int32_t)
 F_OP_BITOR(F_OP_BITOR_FI, vec_t, int32_t, int32_t)
 #undef F_OP_BITOR
 
-static void F_OP_CONV_ITOF(qcvm_t *vm, const qcvm_operands_t operands, int *depth)
+static void F_OP_CONV_ITOF(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth)
 {
-	const vec_t result = (vec_t)*qcvm_get_global_typed(int32_t, vm, operands.a);
-	qcvm_set_global_typed_value(vec_t, vm, operands.c, result);
+	const vec_t result = (vec_t)*qcvm_operand_typed(int32_t, vm, qcvm_operand(vm, operands, a));
+	qcvm_set_operand_typed_value(vec_t, vm, qcvm_operand(vm, operands, c), result);
 }
 
-static void F_OP_CONV_FTOI(qcvm_t *vm, const qcvm_operands_t operands, int *depth)
+static void F_OP_CONV_FTOI(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth)
 {
-	const int32_t result = (int32_t)*qcvm_get_global_typed(vec_t, vm, operands.a);
-	qcvm_set_global_typed_value(int32_t, vm, operands.c, result);
+	const int32_t result = (int32_t)*qcvm_operand_typed(vec_t, vm, qcvm_operand(vm, operands, a));
+	qcvm_set_operand_typed_value(int32_t, vm, qcvm_operand(vm, operands, c), result);
 }
 
-static void F_OP_CP_ITOF(qcvm_t *vm, const qcvm_operands_t operands, int *depth)
+static void F_OP_CP_ITOF(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth)
 {
-	const qcvm_pointer_t address = *qcvm_get_global_typed(qcvm_pointer_t, vm, operands.a);
+	const qcvm_pointer_t address = *qcvm_operand_typed(qcvm_pointer_t, vm, qcvm_operand(vm, operands, a));
 	int32_t i;
 
 	if (!qcvm_resolve_pointer(vm, address, false, sizeof(int32_t), (void**)&i))
 		qcvm_error(vm, "invalid address");
 
 	const vec_t result = i;
-	qcvm_set_global_typed_value(vec_t, vm, operands.c, result);
+	qcvm_set_operand_typed_value(vec_t, vm, qcvm_operand(vm, operands, c), result);
 }
 
-static void F_OP_CP_FTOI(qcvm_t *vm, const qcvm_operands_t operands, int *depth)
+static void F_OP_CP_FTOI(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth)
 {
-	const qcvm_pointer_t address = *qcvm_get_global_typed(qcvm_pointer_t, vm, operands.a);
+	const qcvm_pointer_t address = *qcvm_operand_typed(qcvm_pointer_t, vm, qcvm_operand(vm, operands, a));
 	vec_t f;
 	
 	if (!qcvm_resolve_pointer(vm, address, false, sizeof(vec_t), (void**)&f))
 		qcvm_error(vm, "invalid address");
 	
 	const int32_t result = f;
-	qcvm_set_global_typed_value(int32_t, vm, operands.c, result);
+	qcvm_set_operand_typed_value(int32_t, vm, qcvm_operand(vm, operands, c), result);
 }
 
-static void F_OP_BITXOR_I(qcvm_t *vm, const qcvm_operands_t operands, int *depth)
+static void F_OP_BITXOR_I(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth)
 {
-	const int32_t a = *qcvm_get_global_typed(int32_t, vm, operands.a);
-	const int32_t b = *qcvm_get_global_typed(int32_t, vm, operands.b);
+	const int32_t a = *qcvm_operand_typed(int32_t, vm, qcvm_operand(vm, operands, a));
+	const int32_t b = *qcvm_operand_typed(int32_t, vm, qcvm_operand(vm, operands, b));
 	const int32_t result = a ^ b;
-	qcvm_set_global_typed_value(int32_t, vm, operands.c, result);
+	qcvm_set_operand_typed_value(int32_t, vm, qcvm_operand(vm, operands, c), result);
 }
 
-static void F_OP_RSHIFT_I(qcvm_t *vm, const qcvm_operands_t operands, int *depth)
+static void F_OP_RSHIFT_I(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth)
 {
-	const int32_t a = *qcvm_get_global_typed(int32_t, vm, operands.a);
-	const int32_t b = *qcvm_get_global_typed(int32_t, vm, operands.b);
+	const int32_t a = *qcvm_operand_typed(int32_t, vm, qcvm_operand(vm, operands, a));
+	const int32_t b = *qcvm_operand_typed(int32_t, vm, qcvm_operand(vm, operands, b));
 	const int32_t result = a >> b;
-	qcvm_set_global_typed_value(int32_t, vm, operands.c, result);
+	qcvm_set_operand_typed_value(int32_t, vm, qcvm_operand(vm, operands, c), result);
 }
 
-static void F_OP_LSHIFT_I(qcvm_t *vm, const qcvm_operands_t operands, int *depth)
+static void F_OP_LSHIFT_I(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth)
 {
-	const int32_t a = *qcvm_get_global_typed(int32_t, vm, operands.a);
-	const int32_t b = *qcvm_get_global_typed(int32_t, vm, operands.b);
+	const int32_t a = *qcvm_operand_typed(int32_t, vm, qcvm_operand(vm, operands, a));
+	const int32_t b = *qcvm_operand_typed(int32_t, vm, qcvm_operand(vm, operands, b));
 	const int32_t result = a << b;
-	qcvm_set_global_typed_value(int32_t, vm, operands.c, result);
+	qcvm_set_operand_typed_value(int32_t, vm, qcvm_operand(vm, operands, c), result);
 }
 
-static void F_OP_GLOBALADDRESS(qcvm_t *vm, const qcvm_operands_t operands, int *depth)
+static void F_OP_GLOBALADDRESS(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth)
 {
-	const qcvm_global_t *base = qcvm_get_global(vm, operands.a);
-	const ptrdiff_t offset = *qcvm_get_global_typed(int32_t, vm, operands.b);
+	const qcvm_global_t *base = qcvm_fetch_operand(vm, qcvm_operand(vm, operands, a));
+	const ptrdiff_t offset = *qcvm_operand_typed(int32_t, vm, qcvm_operand(vm, operands, b));
 	const qcvm_pointer_t pointer = qcvm_make_pointer(vm, QCVM_POINTER_GLOBAL, base + offset);
 
 #ifdef _DEBUG
@@ -691,33 +782,33 @@ static void F_OP_GLOBALADDRESS(qcvm_t *vm, const qcvm_operands_t operands, int *
 		qcvm_error(vm, "bad pointer");
 #endif
 
-	qcvm_set_global_typed_value(qcvm_pointer_t, vm, operands.c, pointer);
+	qcvm_set_operand_typed_value(qcvm_pointer_t, vm, qcvm_operand(vm, operands, c), pointer);
 }
 
-static void F_OP_ADD_PIW(qcvm_t *vm, const qcvm_operands_t operands, int *depth)
+static void F_OP_ADD_PIW(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth)
 {
-	const int32_t a = *qcvm_get_global_typed(int32_t, vm, operands.a);
-	const int32_t b = *qcvm_get_global_typed(int32_t, vm, operands.b);
+	const int32_t a = *qcvm_operand_typed(int32_t, vm, qcvm_operand(vm, operands, a));
+	const int32_t b = *qcvm_operand_typed(int32_t, vm, qcvm_operand(vm, operands, b));
 	int32_t result = a + (b * sizeof(qcvm_global_t));
 	
-	qcvm_set_global_typed_value(int32_t, vm, operands.c, result);
+	qcvm_set_operand_typed_value(int32_t, vm, qcvm_operand(vm, operands, c), result);
 }
 
 #define F_OP_LOADA(F_OP, TType) \
-static void F_OP(qcvm_t *vm, const qcvm_operands_t operands, int *depth) \
+static void F_OP(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth) \
 { \
-	const ptrdiff_t address = (ptrdiff_t)operands.a + *qcvm_get_global_typed(int32_t, vm, operands.b); \
+	const ptrdiff_t address = (ptrdiff_t)operands->args.a + *qcvm_operand_typed(int32_t, vm, qcvm_operand(vm, operands, b)); \
 	const qcvm_pointer_t pointer = qcvm_make_pointer(vm, QCVM_POINTER_GLOBAL, (void *)(vm->global_data + address)); \
 	TType *field_value; \
 \
 	if (!qcvm_resolve_pointer(vm, pointer, false, sizeof(TType), (void**)&field_value)) \
 		qcvm_error(vm, "Invalid pointer %x", address); \
 \
-	qcvm_set_global_typed_ptr(TType, vm, operands.c, field_value); \
+	qcvm_set_operand_typed_ptr(TType, vm, qcvm_operand(vm, operands, c), field_value); \
 \
 	const size_t span = sizeof(TType) / sizeof(qcvm_global_t); \
-	qcvm_string_list_mark_refs_copied(vm, field_value, qcvm_get_global(vm, operands.c), span); \
-	qcvm_field_wrap_list_check_set(vm, qcvm_get_global(vm, operands.c), span); \
+	if (vm->dynamic_strings.ref_storage_stored) \
+		qcvm_string_list_mark_refs_copied(vm, field_value, qcvm_fetch_operand(vm, qcvm_operand(vm, operands, c)), span); \
 }
 
 F_OP_LOADA(F_OP_LOADA_F, vec_t)
@@ -729,24 +820,24 @@ F_OP_LOADA(F_OP_LOADA_FNC, qcvm_func_t)
 F_OP_LOADA(F_OP_LOADA_I, int32_t)
 #undef F_OP_LOADA
 
-static inline void F_OP_LOADP_BASE(qcvm_t *vm, const qcvm_operands_t operands, int *depth, const size_t TType_size)
+static inline void F_OP_LOADP_BASE(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth, const size_t TType_size)
 {
-	qcvm_pointer_t pointer = *qcvm_get_global_typed(qcvm_pointer_t, vm, operands.a);
-	pointer = qcvm_offset_pointer(vm, pointer, *qcvm_get_global_typed(int32_t, vm, operands.b) * sizeof(qcvm_global_t));
+	qcvm_pointer_t pointer = *qcvm_operand_typed(qcvm_pointer_t, vm, qcvm_operand(vm, operands, a));
+	pointer = qcvm_offset_pointer(vm, pointer, *qcvm_operand_typed(int32_t, vm, qcvm_operand(vm, operands, b)) * sizeof(qcvm_global_t));
 	void *field_value;
 
 	if (!qcvm_resolve_pointer(vm, pointer, false, TType_size, &field_value))
 		qcvm_error(vm, "Invalid pointer");
 
-	qcvm_set_global(vm, operands.c, field_value, TType_size);
+	qcvm_set_operand(vm, qcvm_operand(vm, operands, c), field_value, TType_size);
 
 	const size_t span = TType_size / sizeof(qcvm_global_t);
-	qcvm_string_list_mark_refs_copied(vm, field_value, qcvm_get_global(vm, operands.c), span);
-	qcvm_field_wrap_list_check_set(vm, qcvm_get_global(vm, operands.c), span);
+	if (vm->dynamic_strings.ref_storage_stored)
+		qcvm_string_list_mark_refs_copied(vm, field_value, qcvm_fetch_operand(vm, qcvm_operand(vm, operands, c)), span);
 }
 
 #define F_OP_LOADP(F_OP, TType) \
-static void F_OP(qcvm_t *vm, const qcvm_operands_t operands, int *depth) \
+static void F_OP(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth) \
 { \
 	F_OP_LOADP_BASE(vm, operands, depth, sizeof(TType)); \
 }
@@ -760,10 +851,10 @@ F_OP_LOADP(F_OP_LOADP_FNC, qcvm_func_t)
 F_OP_LOADP(F_OP_LOADP_I, int32_t)
 #undef F_OP_LOADP
 
-static void F_OP_LOADP_C(qcvm_t *vm, const qcvm_operands_t operands, int *depth)
+static void F_OP_LOADP_C(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth)
 {
-	const qcvm_string_t strid = *qcvm_get_global_typed(qcvm_string_t, vm, operands.a);
-	const size_t offset = *qcvm_get_global_typed(int32_t, vm, operands.b);
+	const qcvm_string_t strid = *qcvm_operand_typed(qcvm_string_t, vm, qcvm_operand(vm, operands, a));
+	const size_t offset = *qcvm_operand_typed(int32_t, vm, qcvm_operand(vm, operands, b));
 	int32_t result;
 
 	if (offset > qcvm_get_string_length(vm, strid))
@@ -774,175 +865,176 @@ static void F_OP_LOADP_C(qcvm_t *vm, const qcvm_operands_t operands, int *depth)
 		result = str[offset];
 	}
 
-	qcvm_set_global_typed_value(vec_t, vm, operands.c, result);
+	qcvm_set_operand_typed_value(vec_t, vm, qcvm_operand(vm, operands, c), result);
 }
 
-static void F_OP_BOUNDCHECK(qcvm_t *vm, const qcvm_operands_t operands, int *depth)
+static void F_OP_BOUNDCHECK(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth)
 {
 #if _DEBUG
-	const uint32_t a = *qcvm_get_global_typed(uint32_t, vm, operands.a);
-	const uint32_t b = (uint32_t)operands.b;
-	const uint32_t c = (uint32_t)operands.c;
+	const uint32_t a = *qcvm_operand_typed(uint32_t, vm, qcvm_operand(vm, operands, a));
+	const uint32_t b = (uint32_t)operands->args.b;
+	const uint32_t c = (uint32_t)operands->args.c;
 
 	if (a < c || a >= b)
 		qcvm_error(vm, "bounds check failed");
 #endif
 }
 
-static void F_OP_MULSTOREP_F(qcvm_t *vm, const qcvm_operands_t operands, int *depth)
+static void F_OP_MULSTOREP_F(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth)
 {
-	const qcvm_pointer_t pointer = *qcvm_get_global_typed(qcvm_pointer_t, vm, operands.b);
+	const qcvm_pointer_t pointer = *qcvm_operand_typed(qcvm_pointer_t, vm, qcvm_operand(vm, operands, b));
 	vec_t *f;
 
 	if (!qcvm_resolve_pointer(vm, pointer, false, sizeof(vec_t), (void**)&f))
 		qcvm_error(vm, "bad pointer");
 
-	const vec_t a = *qcvm_get_global_typed(vec_t, vm, operands.a);
+	const vec_t a = *qcvm_operand_typed(vec_t, vm, qcvm_operand(vm, operands, a));
 	const vec_t result = (*f) *= a;
 
-	qcvm_set_global_typed_value(vec_t, vm, operands.c, result);
-	qcvm_field_wrap_list_check_set(vm, f, sizeof(vec_t) / sizeof(qcvm_global_t));
+	qcvm_set_operand_typed_value(vec_t, vm, qcvm_operand(vm, operands, c), result);
+	qcvm_check_store_wraps(vm, operands, f, sizeof(vec_t) / sizeof(qcvm_global_t));
 }
 
-static void F_OP_MULSTOREP_VF(qcvm_t *vm, const qcvm_operands_t operands, int *depth)
+static void F_OP_MULSTOREP_VF(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth)
 {
-	const qcvm_pointer_t pointer = *qcvm_get_global_typed(qcvm_pointer_t, vm, operands.b);
+	const qcvm_pointer_t pointer = *qcvm_operand_typed(qcvm_pointer_t, vm, qcvm_operand(vm, operands, b));
 	vec3_t *f;
 
 	if (!qcvm_resolve_pointer(vm, pointer, false, sizeof(vec3_t), (void**)&f))
 		qcvm_error(vm, "bad pointer");
 
-	const vec_t a = *qcvm_get_global_typed(vec_t, vm, operands.a);
+	const vec_t a = *qcvm_operand_typed(vec_t, vm, qcvm_operand(vm, operands, a));
 	const vec3_t result = (*f) = VectorScaleF(*f, a);
-	qcvm_set_global_typed_value(vec3_t, vm, operands.c, result);
-	qcvm_field_wrap_list_check_set(vm, f, sizeof(vec3_t) / sizeof(qcvm_global_t));
+	qcvm_set_operand_typed_value(vec3_t, vm, qcvm_operand(vm, operands, c), result);
+	qcvm_check_store_wraps(vm, operands, f, sizeof(vec3_t) / sizeof(qcvm_global_t));
 }
 
-static void F_OP_DIVSTOREP_F(qcvm_t *vm, const qcvm_operands_t operands, int *depth)
+static void F_OP_DIVSTOREP_F(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth)
 {
-	const qcvm_pointer_t pointer = *qcvm_get_global_typed(qcvm_pointer_t, vm, operands.b);
+	const qcvm_pointer_t pointer = *qcvm_operand_typed(qcvm_pointer_t, vm, qcvm_operand(vm, operands, b));
 	vec_t *f;
 
 	if (!qcvm_resolve_pointer(vm, pointer, false, sizeof(vec_t), (void**)&f))
 		qcvm_error(vm, "bad pointer");
 
-	const vec_t a = *qcvm_get_global_typed(vec_t, vm, operands.a);
+	const vec_t a = *qcvm_operand_typed(vec_t, vm, qcvm_operand(vm, operands, a));
 	const vec_t result = (*f) /= a;
-	qcvm_set_global_typed_value(vec_t, vm, operands.c, result);
-	qcvm_field_wrap_list_check_set(vm, f, sizeof(vec_t) / sizeof(qcvm_global_t));
+	qcvm_set_operand_typed_value(vec_t, vm, qcvm_operand(vm, operands, c), result);
+	qcvm_check_store_wraps(vm, operands, f, sizeof(vec_t) / sizeof(qcvm_global_t));
 }
 
-static void F_OP_ADDSTOREP_F(qcvm_t *vm, const qcvm_operands_t operands, int *depth)
+static void F_OP_ADDSTOREP_F(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth)
 {
-	const qcvm_pointer_t pointer = *qcvm_get_global_typed(qcvm_pointer_t, vm, operands.b);
+	const qcvm_pointer_t pointer = *qcvm_operand_typed(qcvm_pointer_t, vm, qcvm_operand(vm, operands, b));
 	vec_t *f;
 
 	if (!qcvm_resolve_pointer(vm, pointer, false, sizeof(vec_t), (void**)&f))
 		qcvm_error(vm, "bad pointer");
 
-	const vec_t a = *qcvm_get_global_typed(vec_t, vm, operands.a);
+	const vec_t a = *qcvm_operand_typed(vec_t, vm, qcvm_operand(vm, operands, a));
 	const vec_t result = (*f) += a;
-	qcvm_set_global_typed_value(vec_t, vm, operands.c, result);
-	qcvm_field_wrap_list_check_set(vm, f, sizeof(vec_t) / sizeof(qcvm_global_t));
+	qcvm_set_operand_typed_value(vec_t, vm, qcvm_operand(vm, operands, c), result);
+	qcvm_check_store_wraps(vm, operands, f, sizeof(vec_t) / sizeof(qcvm_global_t));
 }
 
-static void F_OP_ADDSTOREP_V(qcvm_t *vm, const qcvm_operands_t operands, int *depth)
+static void F_OP_ADDSTOREP_V(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth)
 {
-	const qcvm_pointer_t pointer = *qcvm_get_global_typed(qcvm_pointer_t, vm, operands.b);
+	const qcvm_pointer_t pointer = *qcvm_operand_typed(qcvm_pointer_t, vm, qcvm_operand(vm, operands, b));
 	vec3_t *f;
 
 	if (!qcvm_resolve_pointer(vm, pointer, false, sizeof(vec3_t), (void**)&f))
 		qcvm_error(vm, "bad pointer");
 
-	const vec3_t a = *qcvm_get_global_typed(vec3_t, vm, operands.a);
+	const vec3_t a = *qcvm_operand_typed(vec3_t, vm, qcvm_operand(vm, operands, a));
 	const vec3_t result = (*f) = VectorAdd(*f, a);
-	qcvm_set_global_typed_value(vec3_t, vm, operands.c, result);
-	qcvm_field_wrap_list_check_set(vm, f, sizeof(vec3_t) / sizeof(qcvm_global_t));
+	qcvm_set_operand_typed_value(vec3_t, vm, qcvm_operand(vm, operands, c), result);
+	qcvm_check_store_wraps(vm, operands, f, sizeof(vec3_t) / sizeof(qcvm_global_t));
 }
 
-static void F_OP_SUBSTOREP_F(qcvm_t *vm, const qcvm_operands_t operands, int *depth)
+static void F_OP_SUBSTOREP_F(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth)
 {
-	const qcvm_pointer_t pointer = *qcvm_get_global_typed(qcvm_pointer_t, vm, operands.b);
+	const qcvm_pointer_t pointer = *qcvm_operand_typed(qcvm_pointer_t, vm, qcvm_operand(vm, operands, b));
 	vec_t *f;
 
 	if (!qcvm_resolve_pointer(vm, pointer, false, sizeof(vec_t), (void**)&f))
 		qcvm_error(vm, "bad pointer");
 
-	const vec_t a = *qcvm_get_global_typed(vec_t, vm, operands.a);
+	const vec_t a = *qcvm_operand_typed(vec_t, vm, qcvm_operand(vm, operands, a));
 	const vec_t result = (*f) -= a;
-	qcvm_set_global_typed_value(vec_t, vm, operands.c, result);
-	qcvm_field_wrap_list_check_set(vm, f, sizeof(vec_t) / sizeof(qcvm_global_t));
+	qcvm_set_operand_typed_value(vec_t, vm, qcvm_operand(vm, operands, c), result);
+	qcvm_check_store_wraps(vm, operands, f, sizeof(vec_t) / sizeof(qcvm_global_t));
 }
 
-static void F_OP_SUBSTOREP_V(qcvm_t *vm, const qcvm_operands_t operands, int *depth)
+static void F_OP_SUBSTOREP_V(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth)
 {
-	const qcvm_pointer_t pointer = *qcvm_get_global_typed(qcvm_pointer_t, vm, operands.b);
+	const qcvm_pointer_t pointer = *qcvm_operand_typed(qcvm_pointer_t, vm, qcvm_operand(vm, operands, b));
 	vec3_t *f;
 
 	if (!qcvm_resolve_pointer(vm, pointer, false, sizeof(vec3_t), (void**)&f))
 		qcvm_error(vm, "bad pointer");
 
-	const vec3_t a = *qcvm_get_global_typed(vec3_t, vm, operands.a);
+	const vec3_t a = *qcvm_operand_typed(vec3_t, vm, qcvm_operand(vm, operands, a));
 	const vec3_t result = (*f) = VectorSubtract(*f, a);
-	qcvm_set_global_typed_value(vec3_t, vm, operands.c, result);
-	qcvm_field_wrap_list_check_set(vm, f, sizeof(vec3_t) / sizeof(qcvm_global_t));
+	qcvm_set_operand_typed_value(vec3_t, vm, qcvm_operand(vm, operands, c), result);
+	qcvm_check_store_wraps(vm, operands, f, sizeof(vec3_t) / sizeof(qcvm_global_t));
 }
 
-static void F_OP_RAND0(qcvm_t *vm, const qcvm_operands_t operands, int *depth)
+static void F_OP_RAND0(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth)
 {
 	const vec_t result = frand();
-	qcvm_set_global_typed_value(vec_t, vm, operands.c, result);
+	qcvm_set_operand_typed_value(vec_t, vm, qcvm_operand(vm, operands, c), result);
 }
 
-static void F_OP_RAND1(qcvm_t *vm, const qcvm_operands_t operands, int *depth)
+static void F_OP_RAND1(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth)
 {
-	const vec_t result = frand_m(*qcvm_get_global_typed(vec_t, vm, operands.a));
-	qcvm_set_global_typed_value(vec_t, vm, operands.c, result);
+	const vec_t result = frand_m(*qcvm_operand_typed(vec_t, vm, qcvm_operand(vm, operands, a)));
+	qcvm_set_operand_typed_value(vec_t, vm, qcvm_operand(vm, operands, c), result);
 }
 
-static void F_OP_RAND2(qcvm_t *vm, const qcvm_operands_t operands, int *depth)
+static void F_OP_RAND2(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth)
 {
-	const vec_t result = frand_mm(*qcvm_get_global_typed(vec_t, vm, operands.a), *qcvm_get_global_typed(vec_t, vm, operands.b));
-	qcvm_set_global_typed_value(vec_t, vm, operands.c, result);
+	const vec_t result = frand_mm(*qcvm_operand_typed(vec_t, vm, qcvm_operand(vm, operands, a)), *qcvm_operand_typed(vec_t, vm, qcvm_operand(vm, operands, b)));
+	qcvm_set_operand_typed_value(vec_t, vm, qcvm_operand(vm, operands, c), result);
 }
 
-static void F_OP_RANDV0(qcvm_t *vm, const qcvm_operands_t operands, int *depth)
+static void F_OP_RANDV0(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth)
 {
 	const vec3_t result = { frand(), frand(), frand() };
-	qcvm_set_global_typed_value(vec3_t, vm, operands.c, result);
+	qcvm_set_operand_typed_value(vec3_t, vm, qcvm_operand(vm, operands, c), result);
 }
 
-static void F_OP_RANDV1(qcvm_t *vm, const qcvm_operands_t operands, int *depth)
+static void F_OP_RANDV1(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth)
 {
-	const vec3_t a = *qcvm_get_global_typed(vec3_t, vm, operands.a);
+	const vec3_t a = *qcvm_operand_typed(vec3_t, vm, qcvm_operand(vm, operands, a));
 	const vec3_t result = { frand_m(a.x), frand_m(a.y), frand_m(a.z) };
-	qcvm_set_global_typed_value(vec3_t, vm, operands.c, result);
+	qcvm_set_operand_typed_value(vec3_t, vm, qcvm_operand(vm, operands, c), result);
 }
 
-static void F_OP_RANDV2(qcvm_t *vm, const qcvm_operands_t operands, int *depth)
+static void F_OP_RANDV2(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth)
 {
-	const vec3_t a = *qcvm_get_global_typed(vec3_t, vm, operands.a);
-	const vec3_t b = *qcvm_get_global_typed(vec3_t, vm, operands.b);
+	const vec3_t a = *qcvm_operand_typed(vec3_t, vm, qcvm_operand(vm, operands, a));
+	const vec3_t b = *qcvm_operand_typed(vec3_t, vm, qcvm_operand(vm, operands, b));
 	const vec3_t result = { frand_mm(a.x, b.x), frand_mm(a.y, b.y), frand_mm(a.z, b.z) };
-	qcvm_set_global_typed_value(vec3_t, vm, operands.c, result);
+	qcvm_set_operand_typed_value(vec3_t, vm, qcvm_operand(vm, operands, c), result);
 }
 
 #define F_OP_STOREF(F_OP, TType) \
-static void F_OP(qcvm_t *vm, const qcvm_operands_t operands, int *depth) \
+static void F_OP(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth) \
 { \
 	const size_t span = sizeof(TType) / sizeof(qcvm_global_t); \
-	edict_t *ent = qcvm_ent_to_entity(vm, *qcvm_get_global_typed(qcvm_ent_t, vm, operands.a), true); \
-	const int32_t field = *qcvm_get_global_typed(int32_t, vm, operands.b); \
+	edict_t *ent = qcvm_ent_to_entity(vm, *qcvm_operand_typed(qcvm_ent_t, vm, qcvm_operand(vm, operands, a)), true); \
+	const int32_t field = *qcvm_operand_typed(int32_t, vm, qcvm_operand(vm, operands, b)); \
 	const qcvm_pointer_t pointer = qcvm_get_entity_field_pointer(vm, ent, field); \
 	TType *field_value; \
 	if (!qcvm_resolve_pointer(vm, pointer, false, sizeof(TType), (void**)&field_value)) \
 		qcvm_error(vm, "bad pointer"); \
-	const TType *value = qcvm_get_global_typed(TType, vm, operands.c); \
+	const TType *value = qcvm_operand_typed(TType, vm, qcvm_operand(vm, operands, c)); \
 \
 	*field_value = *value; \
 \
-	qcvm_string_list_mark_refs_copied(vm, value, field_value, span); \
-	qcvm_field_wrap_list_check_set(vm, field_value, span); \
+	if (vm->dynamic_strings.ref_storage_stored) \
+		qcvm_string_list_mark_refs_copied(vm, value, field_value, span); \
+	qcvm_check_store_wraps(vm, operands, field_value, span); \
 }
 
 F_OP_STOREF(F_OP_STOREF_F, vec_t)
@@ -951,10 +1043,10 @@ F_OP_STOREF(F_OP_STOREF_I, int32_t)
 F_OP_STOREF(F_OP_STOREF_V, vec3_t)
 #undef F_OP_STOREF
 
-static void F_OP_LOADP_B(qcvm_t *vm, const qcvm_operands_t operands, int *depth)
+static void F_OP_LOADP_B(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth)
 {
-	const qcvm_string_t strid = *qcvm_get_global_typed(qcvm_string_t, vm, operands.a);
-	const size_t offset = *qcvm_get_global_typed(int32_t, vm, operands.b);
+	const qcvm_string_t strid = *qcvm_operand_typed(qcvm_string_t, vm, qcvm_operand(vm, operands, a));
+	const size_t offset = *qcvm_operand_typed(int32_t, vm, qcvm_operand(vm, operands, b));
 	int32_t result;
 
 	if (offset > qcvm_get_string_length(vm, strid))
@@ -965,27 +1057,60 @@ static void F_OP_LOADP_B(qcvm_t *vm, const qcvm_operands_t operands, int *depth)
 		result = str[offset];
 	}
 
-	qcvm_set_global_typed_value(int32_t, vm, operands.c, result);
+	qcvm_set_operand_typed_value(int32_t, vm, qcvm_operand(vm, operands, c), result);
 }
 
-static void F_OP_INTRIN_SQRT(qcvm_t *vm, const qcvm_operands_t operands, int *depth)
+static void F_OP_INTRIN_SQRT(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth)
 {
-	const vec_t result = sqrt(*qcvm_get_global_typed(vec_t, vm, operands.b));
+	const vec_t result = sqrt(*qcvm_operand_typed(vec_t, vm, qcvm_operand(vm, operands, b)));
 	qcvm_set_global_typed_value(vec_t, vm, GLOBAL_RETURN, result);
 }
 
-static void F_OP_INTRIN_SIN(qcvm_t *vm, const qcvm_operands_t operands, int *depth)
+static void F_OP_INTRIN_SIN(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth)
 {
-	const vec_t result = sin(*qcvm_get_global_typed(vec_t, vm, operands.b));
+	const vec_t result = sin(*qcvm_operand_typed(vec_t, vm, qcvm_operand(vm, operands, b)));
 	qcvm_set_global_typed_value(vec_t, vm, GLOBAL_RETURN, result);
 }
 
-static void F_OP_INTRIN_COS(qcvm_t *vm, const qcvm_operands_t operands, int *depth)
+static void F_OP_INTRIN_COS(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth)
 {
-	const vec_t result = cos(*qcvm_get_global_typed(vec_t, vm, operands.b));
+	const vec_t result = cos(*qcvm_operand_typed(vec_t, vm, qcvm_operand(vm, operands, b)));
 	qcvm_set_global_typed_value(vec_t, vm, GLOBAL_RETURN, result);
 }
 
+// superinstructions; the second statement is left in place so jumps
+// into it still work, and the fused handler just skips over it
+#define F_OP_FUSED(F_OP, F_FIRST, F_SECOND) \
+static void F_OP(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth) \
+{ \
+	F_FIRST(vm, operands, depth); \
+	vm->state.stack[vm->state.current].statement++; \
+	F_SECOND(vm, operands + 1, depth); \
+}
+
+F_OP_FUSED(F_OP_FUSE_LOAD_F_STORE_F, F_OP_LOAD_F, F_OP_STORE_F)
+F_OP_FUSED(F_OP_FUSE_EQ_F_IFNOT_I, F_OP_EQ_F, F_OP_IFNOT_I)
+F_OP_FUSED(F_OP_FUSE_NE_F_IFNOT_I, F_OP_NE_F, F_OP_IFNOT_I)
+F_OP_FUSED(F_OP_FUSE_ADDRESS_STOREP_F, F_OP_ADDRESS, F_OP_STOREP_F)
+F_OP_FUSED(F_OP_FUSE_MUL_VF_ADD_V, F_OP_MUL_VF, F_OP_ADD_V)
+#undef F_OP_FUSED
+
+// stores that qcvm_classify_stores proved can never copy a string ref
+// or land in an entity, so they skip qcvm_copy_operands' bookkeeping
+#define F_OP_UNCHECKED_STORE(F_OP, TType) \
+static void F_OP(qcvm_t *vm, const qcvm_decoded_statement_t *operands, int *depth) \
+{ \
+	memcpy(qcvm_operand(vm, operands, b), qcvm_operand(vm, operands, a), sizeof(TType)); \
+}
+
+F_OP_UNCHECKED_STORE(F_OP_UNCHECKED_STORE_F, vec_t)
+F_OP_UNCHECKED_STORE(F_OP_UNCHECKED_STORE_V, vec3_t)
+F_OP_UNCHECKED_STORE(F_OP_UNCHECKED_STORE_ENT, qcvm_ent_t)
+F_OP_UNCHECKED_STORE(F_OP_UNCHECKED_STORE_FLD, int32_t)
+F_OP_UNCHECKED_STORE(F_OP_UNCHECKED_STORE_FNC, qcvm_func_t)
+F_OP_UNCHECKED_STORE(F_OP_UNCHECKED_STORE_I, int32_t)
+#undef F_OP_UNCHECKED_STORE
+
 #define FOR_ALL_JUMPCODES(OP) \
 	OP(DONE) \
 \
@@ -1204,9 +1329,41 @@ static void F_OP_INTRIN_COS(qcvm_t *vm, const qcvm_operands_t operands, int *dep
 \
 	OP(INTRIN_SQRT) \
 	OP(INTRIN_SIN) \
-	OP(INTRIN_COS)
+	OP(INTRIN_COS) \
+	OP(FUSE_LOAD_F_STORE_F) \
+	OP(FUSE_EQ_F_IFNOT_I) \
+	OP(FUSE_NE_F_IFNOT_I) \
+	OP(FUSE_ADDRESS_STOREP_F) \
+	OP(FUSE_MUL_VF_ADD_V) \
+	OP(UNCHECKED_STORE_F) \
+	OP(UNCHECKED_STORE_V) \
+	OP(UNCHECKED_STORE_ENT) \
+	OP(UNCHECKED_STORE_FLD) \
+	OP(UNCHECKED_STORE_FNC) \
+	OP(UNCHECKED_STORE_I)
 	
-#if defined(USE_GNU_OPCODE_JUMPING) && defined(__GNU__)
+// the plain interpreter loop uses the best of these that's supported;
+// the hooked one needs to get control back between every statement, so
+// it always goes through a central dispatch.
+#if USE_TAIL_CALL_DISPATCH && defined(qcvm_musttail)
+#define QCVM_TAIL_DISPATCH 1
+#else
+#define QCVM_TAIL_DISPATCH 0
+#endif
+
+#if USE_GNU_OPCODE_JUMPING && defined(__GNUC__)
+#define QCVM_THREADED_DISPATCH 1
+#else
+#define QCVM_THREADED_DISPATCH 0
+#endif
+
+static qcvm_always_inline const qcvm_decoded_statement_t *qcvm_next_decoded(qcvm_t *vm)
+{
+	const qcvm_statement_t *statement = ++vm->state.stack[vm->state.current].statement;
+	return vm->decoded_statements + (statement - vm->statements);
+}
+
+#if QCVM_THREADED_DISPATCH
 #define OPC(N) \
 	[OP_##N] = &&JMP_##N,
 
@@ -1217,30 +1374,71 @@ static void F_OP_INTRIN_COS(qcvm_t *vm, const qcvm_operands_t operands, int *dep
 
 #define OPN(N) \
 	JMP_##N: \
-		F_OP_##N(vm, statement->args, &enter_depth); \
+		F_OP_##N(vm, decoded, &enter_depth); \
 		goto JMP_R;
 
 #define JUMPCODE_ASM \
 		FOR_ALL_JUMPCODES(OPN)
 
 #define EXECUTE_JUMPCODE \
-		goto *jmps[code]; \
+		goto *jmps[decoded->opcode]; \
 JMP_R:
 
+// threaded; every handler fetches & jumps to the next statement itself,
+// so each one gets its own indirect branch to predict
+#define THREADED_DISPATCH \
+	decoded = qcvm_next_decoded(vm); \
+	goto *jmps[decoded->opcode];
+
+#define OPT(N) \
+	JMP_##N: \
+		F_OP_##N(vm, decoded, &enter_depth); \
+		if (!enter_depth) \
+			return; \
+		THREADED_DISPATCH
+
+#define THREADED_JUMPCODE_ASM \
+		FOR_ALL_JUMPCODES(OPT)
+
 #else
 #define JUMPCODE_LIST
 #define JUMPCODE_ASM
 
-#define OPN(N) \
-	case OP_##N: \
-		F_OP_##N(vm, statement->args, &enter_depth); \
-		break;
-
+// the decoded stream already holds the handler, so just call into it
 #define EXECUTE_JUMPCODE \
-	switch (code) \
-	{ \
-		FOR_ALL_JUMPCODES(OPN) \
-	}
+	decoded->handler(vm, decoded, &enter_depth);
+#endif
+
+#if QCVM_TAIL_DISPATCH
+// every handler is wrapped in one that tail calls into the next statement's,
+// so there's no loop at all; the chain unwinds once enter_depth is 0.
+typedef int (*qcvm_tail_func_t)(qcvm_t *vm, const qcvm_decoded_statement_t *decoded, int *depth);
+
+static int qcvm_tail_dispatch(qcvm_t *vm, const qcvm_decoded_statement_t *decoded, int *depth);
+
+#define OPTC(N) \
+static int T_OP_##N(qcvm_t *vm, const qcvm_decoded_statement_t *decoded, int *depth) \
+{ \
+	F_OP_##N(vm, decoded, depth); \
+	if (!*depth) \
+		return 0; \
+	qcvm_musttail return qcvm_tail_dispatch(vm, decoded, depth); \
+}
+
+FOR_ALL_JUMPCODES(OPTC)
+
+#define OPTF(N) \
+	[OP_##N] = T_OP_##N,
+
+static const qcvm_tail_func_t qcvm_tail_funcs[] = {
+	FOR_ALL_JUMPCODES(OPTF)
+};
+
+static int qcvm_tail_dispatch(qcvm_t *vm, const qcvm_decoded_statement_t *decoded, int *depth)
+{
+	decoded = qcvm_next_decoded(vm);
+	qcvm_musttail return qcvm_tail_funcs[decoded->opcode](vm, decoded, depth);
+}
 #endif
 
 #define OPF(N) \
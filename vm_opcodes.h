@@ -275,6 +275,19 @@
 	f(OP_INTRIN_SQRT), \
 	f(OP_INTRIN_SIN), \
 	f(OP_INTRIN_COS), \
+\
+	f(OP_FUSE_LOAD_F_STORE_F), \
+	f(OP_FUSE_EQ_F_IFNOT_I), \
+	f(OP_FUSE_NE_F_IFNOT_I), \
+	f(OP_FUSE_ADDRESS_STOREP_F), \
+	f(OP_FUSE_MUL_VF_ADD_V), \
+\
+	f(OP_UNCHECKED_STORE_F), \
+	f(OP_UNCHECKED_STORE_V), \
+	f(OP_UNCHECKED_STORE_ENT), \
+	f(OP_UNCHECKED_STORE_FLD), \
+	f(OP_UNCHECKED_STORE_FNC), \
+	f(OP_UNCHECKED_STORE_I), \
 \
 	f(OP_NUMOPS)
 
@@ -58,10 +58,158 @@ char *qcvm_temp_format(const qcvm_t *vm, const char *format, ...)
 	return buffer;
 }
 
+static void qcvm_string_builder_reserve(const qcvm_t *vm, qcvm_string_builder_t *builder, const size_t len)
+{
+	// keeps the doubling below from overflowing
+	if (len >= (SIZE_MAX / 2) - builder->length)
+		qcvm_error(vm, "string builder overflow");
+
+	const size_t needed = builder->length + len + 1;
+
+	if (needed <= builder->allocated)
+		return;
+
+	size_t allocated = builder->allocated ? builder->allocated : 64;
+
+	while (allocated < needed)
+		allocated *= 2;
+
+	char *data = (char *)qcvm_alloc(vm, allocated);
+
+	if (builder->data)
+	{
+		memcpy(data, builder->data, builder->length + 1);
+		qcvm_mem_free(vm, builder->data);
+	}
+
+	builder->data = data;
+	builder->allocated = allocated;
+}
+
+void qcvm_string_builder_append(const qcvm_t *vm, qcvm_string_builder_t *builder, const char *str, const size_t len)
+{
+	qcvm_string_builder_reserve(vm, builder, len);
+	memcpy(builder->data + builder->length, str, len);
+	builder->length += len;
+	builder->data[builder->length] = 0;
+}
+
+void qcvm_string_builder_appendf(const qcvm_t *vm, qcvm_string_builder_t *builder, const char *format, ...)
+{
+	va_list	argptr, retry;
+
+	va_start(argptr, format);
+	va_copy(retry, argptr);
+
+	qcvm_string_builder_reserve(vm, builder, 0);
+
+	const size_t left = builder->allocated - builder->length;
+	const size_t written = vsnprintf(builder->data + builder->length, left, format, argptr);
+
+	if (written >= left)
+	{
+		qcvm_string_builder_reserve(vm, builder, written);
+		vsnprintf(builder->data + builder->length, written + 1, format, retry);
+	}
+
+	builder->length += written;
+
+	va_end(retry);
+	va_end(argptr);
+}
+
+void qcvm_string_builder_clear(qcvm_string_builder_t *builder)
+{
+	builder->length = 0;
+
+	if (builder->data)
+		*builder->data = 0;
+}
+
+void qcvm_string_builder_free(const qcvm_t *vm, qcvm_string_builder_t *builder)
+{
+	if (builder->data)
+		qcvm_mem_free(vm, builder->data);
+
+	*builder = (qcvm_string_builder_t) { 0 };
+}
+
+void qcvm_return_string_builder(qcvm_t *vm, qcvm_string_builder_t *builder)
+{
+	if (builder->length)
+		qcvm_set_global_str(vm, GLOBAL_RETURN, builder->data, builder->length, true);
+	else
+		qcvm_return_string_id(vm, STRING_EMPTY);
+
+	qcvm_string_builder_clear(builder);
+}
+
 static void QC_va(qcvm_t *vm)
 {
 	const qcvm_string_t fmtid = qcvm_argv_string_id(vm, 0);
-	qcvm_return_string(vm, qcvm_parse_format(fmtid, vm, 1));
+	qcvm_string_builder_clear(&vm->format_builder);
+	qcvm_parse_format_append(&vm->format_builder, fmtid, vm, 1);
+	qcvm_return_string_builder(vm, &vm->format_builder);
+}
+
+// string builders as QC handles; strbuild_finish hands back the string and
+// empties the builder so it can be reused
+static void qcvm_string_builder_handle_free(qcvm_t *vm, void *handle)
+{
+	qcvm_string_builder_free(vm, (qcvm_string_builder_t *)handle);
+	qcvm_mem_free(vm, handle);
+}
+
+static const qcvm_handle_descriptor_t string_builder_descriptor =
+{
+	.free = qcvm_string_builder_handle_free
+};
+
+// the most strbuild_alloc will reserve up front; it's only a hint
+enum { STRBUILD_MAX_RESERVE = 1 << 20 };
+
+static void QC_strbuild_alloc(qcvm_t *vm)
+{
+	qcvm_string_builder_t *builder = (qcvm_string_builder_t *)qcvm_alloc(vm, sizeof(qcvm_string_builder_t));
+
+	if (vm->state.argc)
+	{
+		const int32_t reserve = qcvm_argv_int32(vm, 0);
+
+		if (reserve > 0)
+			qcvm_string_builder_reserve(vm, builder, minsz((size_t)reserve, STRBUILD_MAX_RESERVE));
+	}
+
+	qcvm_return_handle(vm, builder, &string_builder_descriptor);
+}
+
+static void QC_strbuild_append(qcvm_t *vm)
+{
+	qcvm_string_builder_t *builder = qcvm_argv_handle(qcvm_string_builder_t, vm, 0);
+
+	for (int32_t i = 1; i < vm->state.argc; i++)
+	{
+		const qcvm_string_t str = qcvm_argv_string_id(vm, i);
+		qcvm_string_builder_append(vm, builder, qcvm_get_string_chars(vm, str), qcvm_get_string_length(vm, str));
+	}
+}
+
+static void QC_strbuild_appendf(qcvm_t *vm)
+{
+	qcvm_string_builder_t *builder = qcvm_argv_handle(qcvm_string_builder_t, vm, 0);
+	qcvm_parse_format_append(builder, qcvm_argv_string_id(vm, 1), vm, 2);
+}
+
+static void QC_strbuild_length(qcvm_t *vm)
+{
+	const qcvm_string_builder_t *builder = qcvm_argv_handle(qcvm_string_builder_t, vm, 0);
+	qcvm_return_int32(vm, (int32_t)builder->length);
+}
+
+static void QC_strbuild_finish(qcvm_t *vm)
+{
+	qcvm_string_builder_t *builder = qcvm_argv_handle(qcvm_string_builder_t, vm, 0);
+	qcvm_return_string_builder(vm, builder);
 }
 
 static void QC_stoi(qcvm_t *vm)
@@ -113,10 +261,7 @@ static void QC_substr(qcvm_t *vm)
 
 	length = minsz(str_len - start, length);
 
-	char *buffer = qcvm_temp_buffer(vm, length);
-	strncpy(buffer, qcvm_get_string(vm, strid) + start, length);
-	buffer[length] = 0;
-	qcvm_return_string(vm, buffer);
+	qcvm_return_string_id(vm, qcvm_string_slice(vm, strid, start, length));
 }
 
 static void QC_strconcat(qcvm_t *vm)
@@ -132,12 +277,17 @@ static void QC_strconcat(qcvm_t *vm)
 		return;
 	}
 
-	const char *str = "";
+	qcvm_string_builder_t *builder = &vm->format_builder;
+
+	qcvm_string_builder_clear(builder);
 
 	for (int32_t i = 0; i < vm->state.argc; i++)
-		str = qcvm_temp_format(vm, "%s%s", str, qcvm_argv_string(vm, i));
+	{
+		const qcvm_string_t str = qcvm_argv_string_id(vm, i);
+		qcvm_string_builder_append(vm, builder, qcvm_get_string_chars(vm, str), qcvm_get_string_length(vm, str));
+	}
 
-	qcvm_return_string(vm, str);
+	qcvm_return_string_builder(vm, builder);
 }
 
 static void QC_strstr(qcvm_t *vm)
@@ -174,13 +324,25 @@ static void QC_strlwr(qcvm_t *vm)
 {
 	const qcvm_string_t a = qcvm_argv_string_id(vm, 0);
 	const size_t length = qcvm_get_string_length(vm, a);
-	
+	const char *chars = qcvm_get_string_chars(vm, a);
+	size_t i = 0;
+
+	// nothing to change means nothing to allocate
+	while (i < length && (unsigned char)chars[i] == tolower((unsigned char)chars[i]))
+		i++;
+
+	if (i == length)
+	{
+		qcvm_return_string_id(vm, a);
+		return;
+	}
+
 	char *buffer = qcvm_temp_buffer(vm, length);
-	strncpy(buffer, qcvm_get_string(vm, a), length);
+	memcpy(buffer, chars, length);
 	buffer[length] = 0;
 
-	for (size_t i = 0; i < length; i++)
-		buffer[i] = tolower(buffer[i]);
+	for (; i < length; i++)
+		buffer[i] = tolower((unsigned char)buffer[i]);
 
 	qcvm_return_string(vm, buffer);
 }
@@ -189,13 +351,25 @@ static void QC_strupr(qcvm_t *vm)
 {
 	const qcvm_string_t a = qcvm_argv_string_id(vm, 0);
 	const size_t length = qcvm_get_string_length(vm, a);
-	
+	const char *chars = qcvm_get_string_chars(vm, a);
+	size_t i = 0;
+
+	// nothing to change means nothing to allocate
+	while (i < length && (unsigned char)chars[i] == toupper((unsigned char)chars[i]))
+		i++;
+
+	if (i == length)
+	{
+		qcvm_return_string_id(vm, a);
+		return;
+	}
+
 	char *buffer = qcvm_temp_buffer(vm, length);
-	strncpy(buffer, qcvm_get_string(vm, a), length);
+	memcpy(buffer, chars, length);
 	buffer[length] = 0;
 
-	for (size_t i = 0; i < length; i++)
-		buffer[i] = toupper(buffer[i]);
+	for (; i < length; i++)
+		buffer[i] = toupper((unsigned char)buffer[i]);
 
 	qcvm_return_string(vm, buffer);
 }
@@ -234,4 +408,10 @@ void qcvm_init_string_builtins(qcvm_t *vm)
 	qcvm_register_builtin(strupr);
 
 	qcvm_register_builtin(localtime);
+
+	qcvm_register_builtin(strbuild_alloc);
+	qcvm_register_builtin(strbuild_append);
+	qcvm_register_builtin(strbuild_appendf);
+	qcvm_register_builtin(strbuild_length);
+	qcvm_register_builtin(strbuild_finish);
 }
\ No newline at end of file
@@ -3,4 +3,15 @@
 char *qcvm_temp_buffer(const qcvm_t *vm, const size_t len);
 char *qcvm_temp_format(const qcvm_t *vm, const char *format, ...);
 
+void qcvm_string_builder_append(const qcvm_t *vm, qcvm_string_builder_t *builder, const char *str, const size_t len);
+void qcvm_string_builder_appendf(const qcvm_t *vm, qcvm_string_builder_t *builder, const char *format, ...);
+// empties the builder without giving up its memory
+void qcvm_string_builder_clear(qcvm_string_builder_t *builder);
+void qcvm_string_builder_free(const qcvm_t *vm, qcvm_string_builder_t *builder);
+// returns the built string from the current builtin and empties the builder
+void qcvm_return_string_builder(qcvm_t *vm, qcvm_string_builder_t *builder);
+
+// same as qcvm_parse_format, but appends onto a builder
+void qcvm_parse_format_append(qcvm_string_builder_t *builder, const qcvm_string_t formatid, const qcvm_t *vm, const uint8_t start);
+
 void qcvm_init_string_builtins(qcvm_t *vm);
\ No newline at end of file
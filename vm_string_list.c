@@ -3,7 +3,136 @@
 #include "vm.h"
 #include "vm_string.h"
 
-qcvm_string_t qcvm_string_list_store(qcvm_t *vm, const char *str, const size_t len)
+static inline size_t qcvm_string_slab_class(const size_t size)
+{
+	size_t c = 0;
+
+	for (size_t class_size = STRING_SLAB_MIN_SIZE; class_size < size; class_size <<= 1)
+		c++;
+
+	return c;
+}
+
+char *qcvm_string_list_alloc(qcvm_t *vm, const size_t len)
+{
+	qcvm_string_list_t *list = &vm->dynamic_strings;
+	qcvm_string_slab_stats_t *stats = &list->slab_stats;
+	const size_t size = len + 1;
+
+	stats->bytes_used += size;
+	stats->allocs++;
+
+	if (size > STRING_SLAB_MAX_SIZE)
+	{
+		stats->bytes_reserved += size;
+		return (char *)qcvm_alloc(vm, size);
+	}
+
+	const size_t c = qcvm_string_slab_class(size);
+	const size_t class_size = (size_t)STRING_SLAB_MIN_SIZE << c;
+
+	// carve a new slab up for this class
+	if (!list->slab_free[c])
+	{
+		uint8_t *slab = (uint8_t *)qcvm_alloc(vm, STRING_SLAB_SIZE);
+
+		for (size_t offset = STRING_SLAB_SIZE; offset; )
+		{
+			offset -= class_size;
+			*(void **)(slab + offset) = list->slab_free[c];
+			list->slab_free[c] = slab + offset;
+		}
+
+		stats->slabs++;
+		stats->bytes_reserved += STRING_SLAB_SIZE;
+		stats->bytes_free += STRING_SLAB_SIZE;
+	}
+
+	char *chunk = (char *)list->slab_free[c];
+	list->slab_free[c] = *(void **)chunk;
+	stats->bytes_free -= class_size;
+
+	return chunk;
+}
+
+static void qcvm_string_list_free_body(qcvm_t *vm, const char *str, const size_t len)
+{
+	qcvm_string_list_t *list = &vm->dynamic_strings;
+	qcvm_string_slab_stats_t *stats = &list->slab_stats;
+	const size_t size = len + 1;
+
+	stats->bytes_used -= size;
+	stats->frees++;
+
+	if (size > STRING_SLAB_MAX_SIZE)
+	{
+		stats->bytes_reserved -= size;
+		qcvm_mem_free(vm, (void *)str);
+		return;
+	}
+
+	const size_t c = qcvm_string_slab_class(size);
+
+	*(void **)str = list->slab_free[c];
+	list->slab_free[c] = (void *)str;
+	stats->bytes_free += (size_t)STRING_SLAB_MIN_SIZE << c;
+}
+
+void qcvm_string_list_end_frame(qcvm_t *vm)
+{
+	qcvm_string_slab_stats_t *stats = &vm->dynamic_strings.slab_stats;
+
+	stats->frame_allocs = stats->allocs;
+	stats->frame_frees = stats->frees;
+	stats->allocs = stats->frees = 0;
+}
+
+static inline qcvm_ref_counted_string_t *qcvm_string_list_entry(qcvm_string_list_t *list, const qcvm_string_t id)
+{
+	return &list->strings[(-id) - 1];
+}
+
+static void qcvm_string_list_hash_link(qcvm_string_list_t *list, const qcvm_string_t id)
+{
+	qcvm_ref_counted_string_t *str = qcvm_string_list_entry(list, id);
+	str->hash_value = Q_hash_string(str->str, list->strings_allocated);
+	str->hash_next = list->hashes[str->hash_value];
+	list->hashes[str->hash_value] = id;
+}
+
+static void qcvm_string_list_hash_unlink(qcvm_string_list_t *list, const qcvm_string_t id)
+{
+	qcvm_ref_counted_string_t *str = qcvm_string_list_entry(list, id);
+
+	for (qcvm_string_t *link = &list->hashes[str->hash_value]; *link; link = &qcvm_string_list_entry(list, *link)->hash_next)
+	{
+		if (*link == id)
+		{
+			*link = str->hash_next;
+			break;
+		}
+	}
+
+	str->hash_next = 0;
+}
+
+// bucket count follows strings_allocated, so everything has to be
+// re-bucketed when the list grows
+static void qcvm_string_list_rehash(qcvm_t *vm)
+{
+	qcvm_string_list_t *list = &vm->dynamic_strings;
+
+	if (list->hashes)
+		qcvm_mem_free(vm, list->hashes);
+
+	list->hashes = (qcvm_string_t *)qcvm_alloc(vm, sizeof(qcvm_string_t) * list->strings_allocated);
+
+	for (size_t i = 0; i < list->strings_size; i++)
+		if (list->strings[i].str && !list->strings[i].view_of)
+			qcvm_string_list_hash_link(list, (qcvm_string_t)(-(int32_t)(i + 1)));
+}
+
+static int32_t qcvm_string_list_new_index(qcvm_t *vm)
 {
 	qcvm_string_list_t *list = &vm->dynamic_strings;
 	int32_t index;
@@ -22,21 +151,89 @@ qcvm_string_t qcvm_string_list_store(qcvm_t *vm, const char *str, const size_t l
 				memcpy(list->strings, old_strings, sizeof(qcvm_ref_counted_string_t) * list->strings_size);
 				qcvm_mem_free(vm, old_strings);
 			}
-			qcvm_debug(vm, "Increased ref string storage to %u due to \"%s\"\n", list->strings_allocated, str);
+			qcvm_string_list_rehash(vm);
+			qcvm_debug(vm, "Increased ref string storage to %u\n", list->strings_allocated);
 		}
 
 		index = (int32_t)list->strings_size++;
 	}
 
+	return index;
+}
+
+qcvm_string_t qcvm_string_list_store(qcvm_t *vm, const char *str, const size_t len)
+{
+	qcvm_string_list_t *list = &vm->dynamic_strings;
+	const int32_t index = qcvm_string_list_new_index(vm);
+	const qcvm_string_t id = (qcvm_string_t)(-(index + 1));
+
 	list->strings[index] = (qcvm_ref_counted_string_t) {
 		str,
 		len,
 		0
 	};
 
+	qcvm_string_list_hash_link(list, id);
+
+	return id;
+}
+
+qcvm_string_t qcvm_string_slice(qcvm_t *vm, const qcvm_string_t parent, const size_t offset, const size_t len)
+{
+	qcvm_string_list_t *list = &vm->dynamic_strings;
+
+	const size_t parent_len = qcvm_get_string_length(vm, parent);
+
+	if (offset + len > parent_len)
+		qcvm_error(vm, "bad string slice");
+	else if (!len)
+		return STRING_EMPTY;
+	else if (!offset && len == parent_len)
+		return parent;
+
+	// static strings are indexable at any offset, so their tails are free
+	if (parent > 0 && offset + len == parent_len)
+		return (qcvm_string_t)(parent + offset);
+
+	const char *str = qcvm_get_string_chars(vm, parent) + offset;
+	qcvm_string_t root = parent;
+
+	// views always hang off of a real string
+	if (parent < 0 && qcvm_string_list_entry(list, parent)->view_of)
+		root = qcvm_string_list_entry(list, parent)->view_of;
+
+	const int32_t index = qcvm_string_list_new_index(vm);
+
+	list->strings[index] = (qcvm_ref_counted_string_t) {
+		.str = str,
+		.length = len,
+		.view_of = root
+	};
+
+	if (root < 0)
+		qcvm_string_list_acquire(vm, root);
+
 	return (qcvm_string_t)(-(index + 1));
 }
 
+// gives a view its own terminated copy, dropping the parent
+static void qcvm_string_list_materialize(qcvm_t *vm, const qcvm_string_t id)
+{
+	qcvm_string_list_t *list = &vm->dynamic_strings;
+	qcvm_ref_counted_string_t *str = qcvm_string_list_entry(list, id);
+	const qcvm_string_t parent = str->view_of;
+	char *body = qcvm_string_list_alloc(vm, str->length);
+
+	memcpy(body, str->str, str->length);
+	body[str->length] = 0;
+	str->str = body;
+	str->view_of = 0;
+	qcvm_string_list_hash_link(list, id);
+
+	if (parent < 0)
+		qcvm_string_list_release(vm, parent);
+}
+
 void qcvm_string_list_unstore(qcvm_t *vm, const qcvm_string_t id)
 {
 	qcvm_string_list_t *list = &vm->dynamic_strings;
@@ -48,7 +245,13 @@ void qcvm_string_list_unstore(qcvm_t *vm, const qcvm_string_t id)
 
 	assert(!str->ref_count);
 
-	qcvm_mem_free(vm, (void *)str->str);
+	const qcvm_string_t parent = str->view_of;
+
+	if (!parent && !str->borrowed)
+	{
+		qcvm_string_list_hash_unlink(list, id);
+		qcvm_string_list_free_body(vm, str->str, str->length);
+	}
 
 	*str = (qcvm_ref_counted_string_t) { NULL, 0, 0 };
 
@@ -66,6 +269,9 @@ void qcvm_string_list_unstore(qcvm_t *vm, const qcvm_string_t id)
 	}
 
 	list->free_indices[list->free_indices_size++] = id;
+
+	if (parent < 0)
+		qcvm_string_list_release(vm, parent);
 }
 
 static size_t qcvm_string_list_get_length(const qcvm_t *vm, const qcvm_string_t id)
@@ -82,7 +288,14 @@ const char *qcvm_string_list_get(const qcvm_t *vm, const qcvm_string_t id)
 	const int32_t index = (int32_t)(-id) - 1;
 	assert(index >= 0 && index < list->strings_size);
 	assert(list->strings[index].str);
-	return list->strings[index].str;
+
+	const qcvm_ref_counted_string_t *str = &list->strings[index];
+
+	// this is still logically const; the string's contents don't change
+	if (str->view_of && str->str[str->length])
+		qcvm_string_list_materialize((qcvm_t *)vm, id);
+
+	return str->str;
 }
 
 void qcvm_string_list_acquire(qcvm_t *vm, const qcvm_string_t id)
@@ -114,7 +327,8 @@ void qcvm_string_list_release(qcvm_t *vm, const qcvm_string_t id)
 		
 	str->ref_count--;
 
-	if (!str->ref_count)
+	// in collect mode this was only a pin, so leave it to the collector
+	if (!str->ref_count && !list->collect)
 		qcvm_string_list_unstore(vm, id);
 
 	END_TIMER(vm, PROFILE_TIMERS);
@@ -216,6 +430,21 @@ static void qcvm_string_list_ref_link(qcvm_t *vm, uint32_t hash, const qcvm_stri
 }
 
 #ifdef _DEBUG
+static void qcvm_string_list_dump_shadow_refs(FILE *fp, qcvm_t *vm, const qcvm_string_t *shadow, const qcvm_global_t *base, const size_t span, const qcvm_string_t id)
+{
+	if (!shadow)
+		return;
+
+	for (size_t i = 0; i < span; i++)
+	{
+		if (shadow[i] != id)
+			continue;
+
+		const qcvm_string_t current_id = *(const qcvm_string_t *)(base + i);
+		fprintf(fp, "\t%s\t\t%s (%u)\n", qcvm_dump_pointer(vm, base + i), current_id == id ? "valid" : "invalid", current_id);
+	}
+}
+
 void qcvm_string_list_dump_refs(FILE *fp, qcvm_t *vm)
 {
 	qcvm_string_list_t *list = &vm->dynamic_strings;
@@ -244,6 +473,10 @@ void qcvm_string_list_dump_refs(FILE *fp, qcvm_t *vm)
 
 			fprintf(fp, "\t%s\t%s\t%s (%u)\n", qcvm_dump_pointer(vm, (const qcvm_global_t *)hashed->ptr), qcvm_stack_entry(vm, &hashed->stack, false), still_has_string ? "valid" : "invalid", current_id);
 		}
+
+		qcvm_string_list_dump_shadow_refs(fp, vm, list->global_refs, vm->global_data, vm->global_size, id);
+		qcvm_string_list_dump_shadow_refs(fp, vm, list->edict_refs, (const qcvm_global_t *)vm->edicts, (vm->edict_size * vm->max_edicts) / sizeof(qcvm_global_t), id);
+		qcvm_string_list_dump_shadow_refs(fp, vm, list->frame_refs, vm->state.frames, vm->state.frames_allocated, id);
 	}
 }
 #endif
@@ -285,11 +518,77 @@ static inline qcvm_ref_storage_hash_t *qcvm_string_list_get_storage_hash(qcvm_t
 	return list->ref_storage_hashes[hash];
 }
 
+static inline qcvm_string_t *qcvm_string_list_shadow_range(qcvm_t *vm, qcvm_string_t **shadow, const size_t span)
+{
+	if (!*shadow)
+		*shadow = (qcvm_string_t *)qcvm_alloc(vm, sizeof(qcvm_string_t) * span);
+
+	return *shadow;
+}
+
+// returns the shadow slot that tracks the ref at ptr, or NULL if ptr is
+// somewhere we don't shadow (the hash keeps those instead)
+static inline qcvm_string_t *qcvm_string_list_shadow(qcvm_t *vm, const void *ptr)
+{
+	qcvm_string_list_t *list = &vm->dynamic_strings;
+	const qcvm_global_t *gptr = (const qcvm_global_t *)ptr;
+
+	if (gptr >= vm->global_data && gptr < vm->global_data + vm->global_size)
+		return qcvm_string_list_shadow_range(vm, &list->global_refs, vm->global_size) + (gptr - vm->global_data);
+
+	const qcvm_global_t *edicts = (const qcvm_global_t *)vm->edicts;
+	const size_t edicts_span = (vm->edict_size * vm->max_edicts) / sizeof(qcvm_global_t);
+
+	if (edicts && gptr >= edicts && gptr < edicts + edicts_span)
+		return qcvm_string_list_shadow_range(vm, &list->edict_refs, edicts_span) + (gptr - edicts);
+
+	const qcvm_global_t *frames = vm->state.frames;
+
+	if (frames && gptr >= frames && gptr < frames + vm->state.frames_allocated)
+		return qcvm_string_list_shadow_range(vm, &list->frame_refs, vm->state.frames_allocated) + (gptr - frames);
+
+	return NULL;
+}
+
+static inline void qcvm_string_list_shadow_link(qcvm_t *vm, qcvm_string_t *shadow, const qcvm_string_t id)
+{
+	if (!*shadow)
+		vm->dynamic_strings.ref_storage_stored++;
+
+	*shadow = id;
+}
+
+static inline void qcvm_string_list_shadow_unlink(qcvm_t *vm, qcvm_string_t *shadow)
+{
+	*shadow = 0;
+	vm->dynamic_strings.ref_storage_stored--;
+}
+
 void qcvm_string_list_mark_ref_copy(qcvm_t *vm, const qcvm_string_t id, const void *ptr)
 {
 	qcvm_string_list_t *list = &vm->dynamic_strings;
+
+	// copies aren't tracked when collecting
+	if (list->collect)
+		return;
+
 	START_TIMER(vm, StringMark);
 
+	qcvm_string_t *shadow = qcvm_string_list_shadow(vm, ptr);
+
+	if (shadow)
+	{
+		// same no-op as below; a different id is just stomped over
+		if (*shadow != id)
+		{
+			qcvm_string_list_acquire(vm, id);
+			qcvm_string_list_shadow_link(vm, shadow, id);
+		}
+
+		END_TIMER(vm, PROFILE_TIMERS);
+		return;
+	}
+
 	uint32_t hash = Q_hash_pointer((uint32_t)ptr, list->ref_storage_allocated);
 	qcvm_ref_storage_hash_t *hashed = qcvm_string_list_get_storage_hash(vm, hash);
 
@@ -327,6 +626,9 @@ void qcvm_string_list_mark_ref_copy(qcvm_t *vm, const qcvm_string_t id, const vo
 bool qcvm_string_list_check_ref_unset(qcvm_t *vm, const void *ptr, const size_t span, const bool assume_changed)
 {
 	qcvm_string_list_t *list = &vm->dynamic_strings;
+	if (!list->ref_storage_stored)
+		return false;
+
 	START_TIMER(vm, StringCheckUnset);
 
 	bool any_unset = false;
@@ -334,6 +636,20 @@ bool qcvm_string_list_check_ref_unset(qcvm_t *vm, const void *ptr, const size_t
 	for (size_t i = 0; i < span; i++)
 	{
 		const qcvm_global_t *gptr = (const qcvm_global_t *)ptr + i;
+		qcvm_string_t *shadow = qcvm_string_list_shadow(vm, gptr);
+
+		if (shadow)
+		{
+			const qcvm_string_t old = *shadow;
+
+			if (!old || (!assume_changed && *(const qcvm_string_t *)gptr == old))
+				continue;
+
+			qcvm_string_list_release(vm, old);
+			qcvm_string_list_shadow_unlink(vm, shadow);
+			any_unset = true;
+			continue;
+		}
 
 		qcvm_ref_storage_hash_t *hashed = qcvm_string_list_get_storage_hash(vm, Q_hash_pointer((uint32_t)gptr, list->ref_storage_allocated));
 
@@ -374,6 +690,18 @@ qcvm_string_t *qcvm_string_list_has_ref(qcvm_t *vm, const void *ptr, qcvm_ref_st
 	qcvm_string_list_t *list = &vm->dynamic_strings;
 	START_TIMER(vm, StringHasRef);
 
+	qcvm_string_t *shadow = qcvm_string_list_shadow(vm, ptr);
+
+	if (shadow)
+	{
+		END_TIMER(vm, PROFILE_TIMERS);
+
+		if (hashed_ptr)
+			*hashed_ptr = NULL;
+
+		return *shadow ? shadow : NULL;
+	}
+
 	qcvm_ref_storage_hash_t *hashed = qcvm_string_list_get_storage_hash(vm, Q_hash_pointer((uint32_t)ptr, list->ref_storage_allocated)), *next;
 
 	for (; hashed; hashed = next)
@@ -399,6 +727,9 @@ qcvm_string_t *qcvm_string_list_has_ref(qcvm_t *vm, const void *ptr, qcvm_ref_st
 
 void qcvm_string_list_mark_refs_copied(qcvm_t *vm, const void *src, const void *dst, const size_t span)
 {
+	if (!vm->dynamic_strings.ref_storage_stored)
+		return;
+
 	START_TIMER(vm, StringMarkRefsCopied);
 
 	// grab list of fields that have strings
@@ -420,7 +751,11 @@ void qcvm_string_list_mark_refs_copied(qcvm_t *vm, const void *src, const void *
 
 			// different strings, unref us
 			qcvm_string_list_release(vm, *dstr);
-			qcvm_string_list_ref_unlink(vm, hashed);
+
+			if (hashed)
+				qcvm_string_list_ref_unlink(vm, hashed);
+			else
+				qcvm_string_list_shadow_unlink(vm, dstr);
 		}
 
 		// no new string, so keep going
@@ -446,6 +781,19 @@ qcvm_string_backup_t qcvm_string_list_pop_ref(qcvm_t *vm, const void *ptr)
 	qcvm_string_list_t *list = &vm->dynamic_strings;
 	START_TIMER(vm, StringPopRef);
 
+	qcvm_string_t *shadow = qcvm_string_list_shadow(vm, ptr);
+
+	if (shadow)
+	{
+		assert(*shadow);
+
+		const qcvm_string_backup_t popped_ref = (qcvm_string_backup_t) { ptr, *shadow };
+		qcvm_string_list_shadow_unlink(vm, shadow);
+
+		END_TIMER(vm, PROFILE_TIMERS);
+		return popped_ref;
+	}
+
 	qcvm_ref_storage_hash_t *hashed = qcvm_string_list_get_storage_hash(vm, Q_hash_pointer((uint32_t)ptr, list->ref_storage_allocated));
 
 	for (; hashed; hashed = hashed->hash_next)
@@ -470,6 +818,31 @@ void qcvm_string_list_push_ref(qcvm_t *vm, const qcvm_string_backup_t *backup)
 	qcvm_string_list_t *list = &vm->dynamic_strings;
 	START_TIMER(vm, StringPushRef);
 
+	const int32_t index = (int32_t)(-backup->id) - 1;
+	const bool valid = (index >= 0 && index < list->strings_size) && list->strings[index].str;
+	qcvm_string_t *shadow = qcvm_string_list_shadow(vm, backup->ptr);
+
+	if (shadow)
+	{
+		if (*shadow == backup->id)
+		{
+			END_TIMER(vm, PROFILE_TIMERS);
+			return;
+		}
+		else if (*shadow)
+		{
+			qcvm_string_list_release(vm, *shadow);
+			qcvm_string_list_shadow_unlink(vm, shadow);
+		}
+
+		if (!valid)
+			qcvm_error(vm, "unable to push string backup");
+
+		qcvm_string_list_shadow_link(vm, shadow, backup->id);
+		END_TIMER(vm, PROFILE_TIMERS);
+		return;
+	}
+
 	const uint32_t hash = Q_hash_pointer((uint32_t)backup->ptr, list->ref_storage_allocated);
 	qcvm_ref_storage_hash_t *hashed = qcvm_string_list_get_storage_hash(vm, hash);
 
@@ -491,10 +864,8 @@ void qcvm_string_list_push_ref(qcvm_t *vm, const qcvm_string_backup_t *backup)
 		}
 	}
 
-	const int32_t index = (int32_t)(-backup->id) - 1;
-
 	// simple restore
-	if ((index >= 0 && index < list->strings_size) && list->strings[index].str)
+	if (valid)
 	{
 		qcvm_string_list_ref_link(vm, hash, backup->id, backup->ptr);
 		END_TIMER(vm, PROFILE_TIMERS);
@@ -504,6 +875,69 @@ void qcvm_string_list_push_ref(qcvm_t *vm, const qcvm_string_backup_t *backup)
 	qcvm_error(vm, "unable to push string backup");
 }
 
+void qcvm_string_list_mark_span(qcvm_t *vm, const void *ptr, const size_t span)
+{
+	qcvm_string_list_t *list = &vm->dynamic_strings;
+	const qcvm_string_t *ids = (const qcvm_string_t *)ptr;
+	const qcvm_string_t lowest = -(qcvm_string_t)list->strings_size;
+
+	// anything that looks like a live id counts; a float that happens to
+	// alias one only keeps a string around a bit longer
+	for (size_t i = 0; i < span; i++)
+		if (ids[i] < 0 && ids[i] >= lowest)
+			list->marks[(-ids[i]) - 1] = true;
+
+	list->slab_stats.collect_scanned += span;
+}
+
+void qcvm_string_list_collect(qcvm_t *vm)
+{
+	qcvm_string_list_t *list = &vm->dynamic_strings;
+
+	// locals and temporaries of running functions aren't scanned, so this is
+	// only safe with nothing on the stack
+	if (!list->collect || vm->state.current >= 0)
+		return;
+
+	START_TIMER(vm, StringCollect);
+
+	if (list->marks_allocated < list->strings_size)
+	{
+		if (list->marks)
+			qcvm_mem_free(vm, list->marks);
+
+		list->marks_allocated = list->strings_allocated;
+		list->marks = (bool *)qcvm_alloc(vm, sizeof(bool) * list->marks_allocated);
+	}
+	else
+		memset(list->marks, 0, sizeof(bool) * list->strings_size);
+
+	list->slab_stats.collect_scanned = 0;
+	list->slab_stats.collect_freed = 0;
+
+	qcvm_string_list_mark_span(vm, vm->global_data, vm->global_size);
+
+	if (vm->edicts)
+		qcvm_string_list_mark_span(vm, vm->edicts, (vm->edict_size * vm->max_edicts) / sizeof(qcvm_global_t));
+
+	for (qcvm_handle_t *handle = vm->handles.data; handle < vm->handles.data + vm->handles.size; handle++)
+		if (handle->descriptor && handle->descriptor->mark_strings)
+			handle->descriptor->mark_strings(vm, handle->handle);
+
+	for (size_t i = 0; i < list->strings_size; i++)
+	{
+		const qcvm_ref_counted_string_t *str = &list->strings[i];
+
+		if (!str->str || str->ref_count || list->marks[i])
+			continue;
+
+		qcvm_string_list_unstore(vm, (qcvm_string_t)(-(int32_t)(i + 1)));
+		list->slab_stats.collect_freed++;
+	}
+
+	END_TIMER(vm, PROFILE_TIMERS);
+}
+
 void qcvm_string_list_write_state(qcvm_t *vm, FILE *fp)
 {
 	qcvm_string_list_t *list = &vm->dynamic_strings;
@@ -554,6 +988,69 @@ qcvm_string_t qcvm_set_string_ptr(qcvm_t *vm, void *ptr, const char *value, cons
 	return str;
 }
 
+qcvm_string_t qcvm_set_global_str_borrowed(qcvm_t *vm, const qcvm_global_t global, const char *value, const size_t len)
+{
+	if (!len)
+		return qcvm_set_global_str(vm, global, value, len, false);
+
+	qcvm_string_list_t *list = &vm->dynamic_strings;
+	const int32_t index = qcvm_string_list_new_index(vm);
+	const qcvm_string_t id = (qcvm_string_t)(-(index + 1));
+
+	// not hashed, so it can't be found by content until it's kept
+	list->strings[index] = (qcvm_ref_counted_string_t) {
+		.str = value,
+		.length = len,
+		.borrowed = true
+	};
+
+	void *ptr = qcvm_get_global(vm, global);
+	*(qcvm_string_t *)ptr = id;
+	qcvm_string_list_check_ref_unset(vm, ptr, 1, false);
+	qcvm_field_wrap_list_check_set(vm, ptr, 1);
+	qcvm_string_list_mark_ref_copy(vm, id, ptr);
+
+	return id;
+}
+
+void qcvm_end_borrow(qcvm_t *vm, const qcvm_string_t id, const qcvm_global_t global)
+{
+	qcvm_string_list_t *list = &vm->dynamic_strings;
+
+	if (id >= 0)
+		return;
+
+	qcvm_string_t *ptr = qcvm_get_global_typed(qcvm_string_t, vm, global);
+
+	// drop the ref we handed it in with; if that was the last one it's gone
+	if (*ptr == id)
+	{
+		qcvm_string_list_check_ref_unset(vm, ptr, 1, true);
+		*ptr = STRING_EMPTY;
+	}
+
+	qcvm_ref_counted_string_t *str = qcvm_string_list_entry(list, id);
+
+	// gone, or the slot was reused for something else
+	if (!str->str || !str->borrowed)
+		return;
+
+	// something kept it (or, when collecting, might have), so give it its own copy
+	const char *old_body = str->str;
+	char *body = qcvm_string_list_alloc(vm, str->length);
+
+	memcpy(body, old_body, str->length);
+	body[str->length] = 0;
+	str->str = body;
+	str->borrowed = false;
+	qcvm_string_list_hash_link(list, id);
+
+	// views of it point into the old memory
+	for (qcvm_ref_counted_string_t *view = list->strings; view < list->strings + list->strings_size; view++)
+		if (view->str && view->view_of == id)
+			view->str = body + (view->str - old_body);
+}
+
 bool qcvm_find_string(qcvm_t *vm, const char *value, qcvm_string_t *rstr)
 {
 	START_TIMER(vm, StringFind);
@@ -567,11 +1064,12 @@ bool qcvm_find_string(qcvm_t *vm, const char *value, qcvm_string_t *rstr)
 	}
 
 	// check built-ins
-	const uint32_t hash = Q_hash_string(value, vm->string_size);
+	const size_t len = strlen(value);
+	const uint32_t hash = Q_hash_bytes(value, len);
 
-	for (qcvm_string_hash_t *hashed = vm->string_hashes[hash]; hashed; hashed = hashed->hash_next)
+	for (qcvm_string_hash_t *hashed = vm->string_hashes[hash & vm->string_hash_mask]; hashed; hashed = hashed->hash_next)
 	{
-		if (!strcmp(hashed->str, value))
+		if (hashed->hash_value == hash && vm->string_lengths[hashed->str - vm->string_data] == len && !memcmp(hashed->str, value, len))
 		{
 			*rstr = (qcvm_string_t)(hashed->str - vm->string_data);
 			END_TIMER(vm, PROFILE_TIMERS);
@@ -579,20 +1077,23 @@ bool qcvm_find_string(qcvm_t *vm, const char *value, qcvm_string_t *rstr)
 		}
 	}
 
-	// check dynamic strings.
-	// Note that this search is not hashed... yet.
-	for (qcvm_ref_counted_string_t *s = vm->dynamic_strings.strings; s < vm->dynamic_strings.strings + vm->dynamic_strings.strings_size; s++)
+	// check dynamic strings
+	qcvm_string_list_t *list = &vm->dynamic_strings;
+
+	if (list->strings_allocated)
 	{
-		if (!s->str)
-			continue;
+		for (qcvm_string_t id = list->hashes[Q_hash_string(value, list->strings_allocated)]; id; )
+		{
+			const qcvm_ref_counted_string_t *s = qcvm_string_list_entry(list, id);
 
-		const char *str = s->str;
+			if (strcmp(value, s->str) == 0)
+			{
+				*rstr = id;
+				END_TIMER(vm, PROFILE_TIMERS);
+				return true;
+			}
 
-		if (str && strcmp(value, str) == 0)
-		{
-			*rstr = (qcvm_string_t) -((s - vm->dynamic_strings.strings) + 1);
-			END_TIMER(vm, PROFILE_TIMERS);
-			return true;
+			id = s->hash_next;
 		}
 	}
 	
@@ -613,7 +1114,7 @@ qcvm_string_t qcvm_store_or_find_string(qcvm_t *vm, const char *value, const siz
 
 	if (copy)
 	{
-		char *strcopy = (char *)qcvm_alloc(vm, (sizeof(char) * len) + 1);
+		char *strcopy = qcvm_string_list_alloc(vm, len);
 		memcpy(strcopy, value, sizeof(char) * len);
 		strcopy[len] = 0;
 		value = strcopy;
@@ -632,6 +1133,57 @@ const char *qcvm_get_string(const qcvm_t *vm, const qcvm_string_t str)
 	return vm->string_data + (size_t)str;
 }
 
+static uint32_t qcvm_string_folded_hash(qcvm_t *vm, const qcvm_string_t id)
+{
+	if (id >= 0)
+		return vm->string_folded_hashes[id];
+
+	qcvm_ref_counted_string_t *str = qcvm_string_list_entry(&vm->dynamic_strings, id);
+
+	if (!str->folded_hash)
+	{
+		uint32_t hash = STRING_FOLD_HASH_SEED;
+
+		for (size_t i = str->length; i; i--)
+			hash = qcvm_string_fold_hash_step(hash, str->str[i - 1]);
+
+		str->folded_hash = qcvm_string_fold_hash_final(hash);
+	}
+
+	return str->folded_hash;
+}
+
+bool qcvm_strings_equal(qcvm_t *vm, const qcvm_string_t a, const qcvm_string_t b)
+{
+	if (a == b)
+		return true;
+
+	// folding doesn't change length, so this holds either way
+	const size_t len = qcvm_get_string_length(vm, a);
+
+	if (len != qcvm_get_string_length(vm, b))
+		return false;
+
+	if (qcvm_strings_case_sensitive(vm))
+		return !memcmp(qcvm_get_string_chars(vm, a), qcvm_get_string_chars(vm, b), len);
+	else if (qcvm_string_folded_hash(vm, a) != qcvm_string_folded_hash(vm, b))
+		return false;
+
+	return !strnicmp(qcvm_get_string_chars(vm, a), qcvm_get_string_chars(vm, b), len);
+}
+
+const char *qcvm_get_string_chars(const qcvm_t *vm, const qcvm_string_t str)
+{
+	if (str < 0)
+	{
+		const int32_t index = (int32_t)(-str) - 1;
+		assert(index >= 0 && index < vm->dynamic_strings.strings_size);
+		return vm->dynamic_strings.strings[index].str;
+	}
+
+	return qcvm_get_string(vm, str);
+}
+
 size_t qcvm_get_string_length(const qcvm_t *vm, const qcvm_string_t str)
 {
 	if (str < 0)
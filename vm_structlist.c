@@ -32,10 +32,17 @@ static bool	qcvm_structlist_resolve_pointer(const qcvm_t *vm, void *handle, cons
 	return false;
 }
 
+static void qcvm_structlist_mark_strings(qcvm_t *vm, void *handle)
+{
+	qcvm_structlist_t *list = (qcvm_structlist_t *)handle;
+	qcvm_string_list_mark_span(vm, list->values, (list->size * list->element_size) / sizeof(qcvm_global_t));
+}
+
 static const qcvm_handle_descriptor_t structlist_descriptor =
 {
 	.free = qcvm_structlist_free,
-	.resolve_pointer = qcvm_structlist_resolve_pointer
+	.resolve_pointer = qcvm_structlist_resolve_pointer,
+	.mark_strings = qcvm_structlist_mark_strings
 };
 
 static void QC_structlist_alloc(qcvm_t *vm)